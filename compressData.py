@@ -0,0 +1,193 @@
+#!/usr/bin/env python3
+"""Stage the data/ directory with heatshrink compressed files for the LittleFS image.
+
+Every file that gets at least --min-saving percent smaller is written as "<name>.hs":
+  header: magic "HSZ1", uint8 windowBits, uint8 lookaheadBits, uint16 reserved,
+          uint32 logicalSize, uint32 crc32 (of the original), little endian
+  data  : a heatshrink bit stream (literal: 1 + 8 bits, back reference: 0 + index-1
+          in windowBits + count-1 in lookaheadBits, most significant bit first)
+The firmware opens "/name" and reads "/name.hs" through src/compressedFile.cpp; other
+files are copied unchanged.
+
+Command line: python3 compressData.py data <stagingDir> [-w 10] [-l 5]
+PlatformIO  : "extra_scripts = pre:compressData.py" plus "custom_compress_data = yes"
+              makes buildfs/uploadfs take the image from the staged directory
+"""
+import argparse
+import fnmatch
+import shutil
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+scriptVersion = "v1.0 (2026-10-14)"
+headerMagic = b"HSZ1"
+headerFormat = "<4sBBHII"
+suffix = ".hs"
+defaultPatterns = "*.html,*.htm,*.css,*.js,*.json,*.txt,*.csv,*.svg,*.ini,*.cpp,*.h"
+# the firmware keeps one window per open file, see COMPRESSED_WINDOW_BITS_MAX
+maxWindowBits = 10
+maxChain = 128
+
+
+class BitWriter:
+    def __init__(self) -> None:
+        self.data = bytearray()
+        self.current = 0
+        self.used = 0
+
+    def write(self, value: int, count: int) -> None:
+        for bit in range(count - 1, -1, -1):
+            self.current = (self.current << 1) | ((value >> bit) & 1)
+            self.used += 1
+            if self.used == 8:
+                self.data.append(self.current)
+                self.current = 0
+                self.used = 0
+
+    def finish(self) -> bytes:
+        if self.used:
+            self.data.append(self.current << (8 - self.used))
+            self.current = 0
+            self.used = 0
+        return bytes(self.data)
+
+
+def compress(data: bytes, windowBits: int, lookaheadBits: int) -> bytes:
+    windowSize = 1 << windowBits
+    maxLength = 1 << lookaheadBits
+    # a back reference must be cheaper than the literals it replaces
+    breakEven = (1 + windowBits + lookaheadBits) // 9 + 1
+    chains: dict[bytes, list[int]] = {}
+    writer = BitWriter()
+
+    position = 0
+    while position < len(data):
+        bestLength = 0
+        bestDistance = 0
+        key = data[position:position + 2]
+        if len(key) == 2:
+            candidates = chains.get(key, [])
+            for candidate in reversed(candidates[-maxChain:]):
+                distance = position - candidate
+                if distance > windowSize:
+                    break
+                length = 0
+                limit = min(maxLength, len(data) - position)
+                while length < limit and data[candidate + length] == data[position + length]:
+                    length += 1
+                if length > bestLength:
+                    bestLength = length
+                    bestDistance = distance
+                    if length == limit:
+                        break
+
+        if bestLength >= breakEven:
+            writer.write(0, 1)
+            writer.write(bestDistance - 1, windowBits)
+            writer.write(bestLength - 1, lookaheadBits)
+            step = bestLength
+        else:
+            writer.write(1, 1)
+            writer.write(data[position], 8)
+            step = 1
+
+        for added in range(position, position + step):
+            chains.setdefault(data[added:added + 2], []).append(added)
+        position += step
+
+    return writer.finish()
+
+
+def packFile(data: bytes, windowBits: int, lookaheadBits: int) -> bytes:
+    header = struct.pack(
+        headerFormat, headerMagic, windowBits, lookaheadBits, 0, len(data), zlib.crc32(data) & 0xFFFFFFFF
+    )
+    return header + compress(data, windowBits, lookaheadBits)
+
+
+def stageDirectory(
+    sourceDir: Path, stagingDir: Path, windowBits: int, lookaheadBits: int, minSaving: int, patterns: list[str]
+) -> tuple[int, int]:
+    if stagingDir.exists():
+        shutil.rmtree(stagingDir)
+    stagingDir.mkdir(parents=True)
+
+    logicalTotal = 0
+    storedTotal = 0
+    for path in sorted(sourceDir.rglob("*")):
+        if not path.is_file():
+            continue
+        relative = path.relative_to(sourceDir)
+        target = stagingDir / relative
+        target.parent.mkdir(parents=True, exist_ok=True)
+        data = path.read_bytes()
+        logicalTotal += len(data)
+
+        if any(fnmatch.fnmatch(path.name, pattern) for pattern in patterns):
+            packed = packFile(data, windowBits, lookaheadBits)
+            if len(packed) * 100 <= len(data) * (100 - minSaving):
+                target.with_name(target.name + suffix).write_bytes(packed)
+                storedTotal += len(packed)
+                print(f"  {relative.as_posix():40s} {len(data):8d} -> {len(packed):8d}")
+                continue
+
+        shutil.copyfile(path, target)
+        storedTotal += len(data)
+        print(f"  {relative.as_posix():40s} {len(data):8d}    (copied)")
+
+    return logicalTotal, storedTotal
+
+
+def checkBits(windowBits: int, lookaheadBits: int) -> None:
+    if not 4 <= windowBits <= maxWindowBits:
+        raise SystemExit(f"Window bits must be 4..{maxWindowBits}")
+    if not 3 <= lookaheadBits < windowBits:
+        raise SystemExit("Lookahead bits must be 3 or more and below the window bits")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=f"Stage compressed LittleFS data ({scriptVersion})")
+    parser.add_argument("sourceDir", type=Path)
+    parser.add_argument("stagingDir", type=Path)
+    parser.add_argument("-w", "--window-bits", type=int, default=10)
+    parser.add_argument("-l", "--lookahead-bits", type=int, default=5)
+    parser.add_argument("--min-saving", type=int, default=10, help="percent a file must shrink to be stored compressed")
+    parser.add_argument("--patterns", default=defaultPatterns, help="comma separated file name patterns to try")
+    args = parser.parse_args()
+
+    checkBits(args.window_bits, args.lookahead_bits)
+    if not args.sourceDir.is_dir():
+        raise SystemExit(f"Not a directory: {args.sourceDir}")
+    logicalTotal, storedTotal = stageDirectory(
+        args.sourceDir, args.stagingDir, args.window_bits, args.lookahead_bits, args.min_saving,
+        args.patterns.split(",")
+    )
+    print(f"{logicalTotal} bytes staged as {storedTotal} bytes in {args.stagingDir}")
+    return 0
+
+
+def hookBuildFs(env) -> None:
+    from SCons.Script import COMMAND_LINE_TARGETS
+
+    if str(env.GetProjectOption("custom_compress_data", "no")).lower() not in ("yes", "true", "1"):
+        return
+    if not any(target in ("buildfs", "uploadfs", "uploadfsota") for target in COMMAND_LINE_TARGETS):
+        return
+
+    sourceDir = Path(env.subst("$PROJECT_DATA_DIR"))
+    stagingDir = Path(env.subst("$BUILD_DIR")) / "dataCompressed"
+    print(f"compressData: staging {sourceDir} in {stagingDir}")
+    logicalTotal, storedTotal = stageDirectory(
+        sourceDir, stagingDir, 10, 5, 10, defaultPatterns.split(",")
+    )
+    print(f"compressData: {logicalTotal} bytes stored as {storedTotal} bytes")
+    env.Replace(PROJECT_DATA_DIR=str(stagingDir))
+
+
+if __name__ == "__main__":
+    sys.exit(main())
+else:
+    Import("env")  # noqa: F821  (provided by PlatformIO/SCons)
+    hookBuildFs(env)  # noqa: F821
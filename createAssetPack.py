@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Pack a directory into the read-only asset pack format read by src/assetPack.cpp.
+
+Layout (little endian):
+  header : magic "ASPK", uint16 version, uint16 entryCount, uint32 totalSize, uint32 reserved
+  entries: entryCount x (char name[32], uint32 offset, uint32 length, uint32 crc32), sorted by name
+  data   : the file contents, every file starts on a 4 byte boundary
+
+ESP32  : flash the .bin into a data partition labelled "assets"
+         (esptool.py write_flash <partition offset> assets.bin)
+ESP8266: use --header to embed the pack as a PROGMEM array and build with -DASSET_PACK_EMBEDDED
+"""
+import argparse
+import struct
+import sys
+import zlib
+from pathlib import Path
+
+scriptVersion = "v1.0 (2026-10-14)"
+packMagic = b"ASPK"
+packVersion = 1
+nameLength = 32
+headerFormat = "<4sHHII"
+entryFormat = f"<{nameLength}sIII"
+
+
+def alignUp(value: int, alignment: int = 4) -> int:
+    return (value + alignment - 1) & ~(alignment - 1)
+
+
+def collectFiles(sourceDir: Path) -> list[tuple[str, bytes]]:
+    files: list[tuple[str, bytes]] = []
+    for path in sorted(sourceDir.rglob("*")):
+        if not path.is_file():
+            continue
+        name = "/" + path.relative_to(sourceDir).as_posix()
+        if len(name.encode("utf-8")) >= nameLength:
+            raise SystemExit(f"Asset name too long (max {nameLength - 1} bytes): {name}")
+        files.append((name, path.read_bytes()))
+
+    # the firmware does a binary search on the byte-wise sorted names
+    files.sort(key=lambda item: item[0].encode("utf-8"))
+    return files
+
+
+def buildPack(files: list[tuple[str, bytes]]) -> bytes:
+    headerSize = struct.calcsize(headerFormat)
+    entrySize = struct.calcsize(entryFormat)
+    dataOffset = alignUp(headerSize + entrySize * len(files))
+
+    entries = b""
+    data = b""
+    for name, content in files:
+        offset = dataOffset + len(data)
+        entries += struct.pack(
+            entryFormat, name.encode("utf-8"), offset, len(content), zlib.crc32(content) & 0xFFFFFFFF
+        )
+        data += content
+        data += b"\0" * (alignUp(len(data)) - len(data))
+
+    padding = b"\0" * (dataOffset - headerSize - len(entries))
+    totalSize = dataOffset + len(data)
+    header = struct.pack(headerFormat, packMagic, packVersion, len(files), totalSize, 0)
+    return header + entries + padding + data
+
+
+def writeHeader(pack: bytes, headerPath: Path) -> None:
+    lines = [
+        "//--- Generated by createAssetPack.py, do not edit",
+        "",
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        f"static const uint8_t assetPackData[{len(pack)}] PROGMEM __attribute__((aligned(4))) =",
+        "{",
+    ]
+    for start in range(0, len(pack), 16):
+        chunk = ", ".join(f"0x{byte:02x}" for byte in pack[start:start + 16])
+        lines.append(f"  {chunk},")
+    lines.append("};")
+    headerPath.write_text("\n".join(lines) + "\n", encoding="utf-8")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=f"createAssetPack.py {scriptVersion}")
+    parser.add_argument("source", help="directory with the assets")
+    parser.add_argument("-o", "--output", default="assets.bin", help="pack file to write")
+    parser.add_argument("--header", help="also write a C header with the pack as PROGMEM array")
+    parser.add_argument("--max-size", type=lambda value: int(value, 0), help="partition size to check against")
+    args = parser.parse_args()
+
+    sourceDir = Path(args.source)
+    if not sourceDir.is_dir():
+        raise SystemExit(f"Asset directory not found: {sourceDir}")
+
+    files = collectFiles(sourceDir)
+    if len(files) > 0xFFFF:
+        raise SystemExit("Too many assets for one pack.")
+    pack = buildPack(files)
+
+    if args.max_size is not None and len(pack) > args.max_size:
+        raise SystemExit(f"Pack is {len(pack)} bytes, partition holds {args.max_size}.")
+
+    Path(args.output).write_bytes(pack)
+    print(f"Packed {len(files)} assets into {args.output} ({len(pack)} bytes)")
+
+    if args.header:
+        writeHeader(pack, Path(args.header))
+        print(f"Wrote {args.header}")
+
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        raise SystemExit(main())
+    except KeyboardInterrupt:
+        raise SystemExit("Aborted by user.")
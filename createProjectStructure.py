@@ -1,5 +1,6 @@
 #!/usr/bin/env python3
 import argparse
+import hashlib
 import datetime as dt
 import json
 import re
@@ -346,9 +347,17 @@ def generateFlashJson(
             flashFiles.append({"offset": "0xe000", "file": "boot_app0.bin"})
 
     firmwarePath = targetVersionDir / "firmware.bin"
+    otaImage: dict[str, object] | None = None
     if firmwarePath.exists():
         firmwareOffset = detectFirmwareOffset(partitions, socFamily)
         flashFiles.append({"offset": firmwareOffset, "file": "firmware.bin"})
+        # size and hash the OTA client checks while it streams the image
+        firmwareBytes = firmwarePath.read_bytes()
+        otaImage = {
+            "file": "firmware.bin",
+            "size": len(firmwareBytes),
+            "sha256": hashlib.sha256(firmwareBytes).hexdigest(),
+        }
 
     filesystemFile = None
     if (targetVersionDir / "LittleFS.bin").exists():
@@ -382,6 +391,8 @@ def generateFlashJson(
         "version": version,
         "flash_files": flashFiles,
     }
+    if otaImage:
+        flashPayload["ota"] = otaImage
     (targetVersionDir / "flash.json").write_text(
         json.dumps(flashPayload, ensure_ascii=False, indent=2) + "\n", encoding="utf-8"
     )
@@ -392,7 +403,11 @@ def parseEnvs(platformioIni: Path) -> list[str]:
     for line in platformioIni.read_text(encoding="utf-8", errors="ignore").splitlines():
         match = envSectionPattern.match(line)
         if match:
-            envs.append(match.group(1).strip())
+            envName = match.group(1).strip()
+            # benchmark, battery and host test builds are not published to the flasher website
+            if envName.endswith("_bench") or envName.endswith("_sleep") or envName == "native":
+                continue
+            envs.append(envName)
 
     seen = set()
     uniqueEnvs = []
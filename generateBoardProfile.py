@@ -0,0 +1,159 @@
+"""PlatformIO pre-script: write boardProfile.h with the capabilities of the env being built.
+
+The values come from the board manifest plus the board_build.* / board_upload.* overrides
+in platformio.ini, so a new env gets a matching profile without touching the sources.
+src/boardCaps.h includes the header (BOARD_PROFILE_GENERATED is defined) and derives the
+scheduler mode, the buffer sizes and the output backend from it. The LittleFS partition
+size comes from the partition table (ESP32) or the linker script (ESP8266); the cache
+sizes picked for it are reported next to the ones the core was built with (fsBackend.h).
+
+Hooked in with "extra_scripts = pre:generateBoardProfile.py" in the [env] section; the
+native env has no board and is skipped (boardCaps.h falls back to the core macros).
+"""
+import re
+from pathlib import Path
+
+Import("env")  # noqa: F821  (provided by PlatformIO/SCons)
+
+scriptVersion = "v1.1 (2026-10-14)"
+
+# per SoC: cores, highest CPU clock (MHz), lowest clock that keeps the peripherals and
+# Wi-Fi working (MHz) and the number of RMT transmit channels
+socCaps = {
+    "esp32":   (2, 240, 80, 8),
+    "esp32s3": (2, 240, 80, 4),
+    "esp32s2": (1, 240, 80, 4),
+    "esp32c3": (1, 160, 80, 2),
+    "esp8266": (1, 160, 80, 0),
+}
+
+# LittleFS block (one flash sector)
+fsBlockBytes = 4096
+
+sizePattern = re.compile(r"^\s*(\d+)\s*([KM]?)B?\s*$", re.IGNORECASE)
+
+
+def parseBytes(value: str) -> int:
+    match = sizePattern.match(str(value))
+    if not match:
+        return 0
+    scale = {"": 1, "K": 1024, "M": 1024 * 1024}[match.group(2).upper()]
+    return int(match.group(1)) * scale
+
+
+def parseMhz(value: str) -> int:
+    digits = re.sub(r"[^0-9]", "", str(value))
+    return int(digits) // 1000000 if digits else 0
+
+
+def parseNumber(value: str) -> int:
+    value = value.strip()
+    if value.lower().startswith("0x"):
+        return int(value, 16)
+    return parseBytes(value)
+
+
+def fsPartitionBytes(board, projectDir: Path) -> int:
+    """Size of the LittleFS partition, 0 when the layout is not in the project."""
+    partitions = board.get("build.partitions", "")
+    if partitions and (projectDir / partitions).is_file():
+        for line in (projectDir / partitions).read_text(encoding="utf-8").splitlines():
+            fields = [field.strip() for field in line.split("#")[0].split(",")]
+            if len(fields) >= 5 and fields[1] == "data" and fields[2] in ("spiffs", "littlefs"):
+                return parseNumber(fields[4])
+    ldscript = board.get("build.ldscript", "")
+    if ldscript and (projectDir / ldscript).is_file():
+        text = (projectDir / ldscript).read_text(encoding="utf-8")
+        start = re.search(r"_FS_start\s*=\s*(0x[0-9a-fA-F]+)", text)
+        end = re.search(r"_FS_end\s*=\s*(0x[0-9a-fA-F]+)", text)
+        if start and end:
+            return int(end.group(1), 16) - int(start.group(1), 16)
+    return 0
+
+
+def fsCacheProfile(mcu: str, psram: bool, partitionBytes: int):
+    """(read, prog, cache, lookahead) bytes for the LittleFS of this board."""
+    if mcu == "esp8266":
+        read, prog, cache = 64, 64, 256
+    elif psram:
+        # a directory walk reads whole metadata blocks, bigger caches save flash reads
+        read, prog, cache = 128, 128, 2048
+    else:
+        read, prog, cache = 128, 128, 512
+    # one lookahead bit per block: a buffer that covers the partition finds free
+    # blocks in one pass; without PSRAM it stays at the 128 byte core default
+    blocks = partitionBytes // fsBlockBytes
+    lookahead = max(16, ((blocks + 7) // 8 + 7) // 8 * 8)
+    if not psram:
+        lookahead = min(lookahead, 128)
+    return read, prog, cache, lookahead
+
+
+def hasPsram(board, projectFlags: str) -> bool:
+    if str(board.get("build.psram", "")).lower() in ("enabled", "1", "true", "yes"):
+        return True
+    # the "_opi"/"_qspi" part of qio_opi and friends is the PSRAM interface
+    memoryType = str(board.get("build.arduino.memory_type", "")).lower()
+    if memoryType.endswith("_opi") or memoryType.endswith("_qspi"):
+        return True
+    return "BOARD_HAS_PSRAM" in str(board.get("build.extra_flags", "")) or "BOARD_HAS_PSRAM" in projectFlags
+
+
+def buildProfile(envName: str, board, projectFlags: str, projectDir: Path) -> str:
+    mcu = str(board.get("build.mcu", "")).lower()
+    if mcu not in socCaps:
+        print(f"generateBoardProfile: unknown MCU [{mcu}] in env:{envName}, using single-core defaults")
+    cores, maxMhz, minMhz, rmtChannels = socCaps.get(mcu, (1, 80, 80, 0))
+    cpuMhz = parseMhz(board.get("build.f_cpu", "")) or minMhz
+    flashBytes = parseBytes(board.get("upload.flash_size", "4MB"))
+    psram = hasPsram(board, projectFlags)
+    fsBytes = fsPartitionBytes(board, projectDir)
+    fsRead, fsProg, fsCache, fsLookahead = fsCacheProfile(mcu, psram, fsBytes)
+
+    lines = [
+        f"//--- Board profile of env:{envName}, generated by generateBoardProfile.py {scriptVersion}",
+        "//--- do not edit, it is regenerated at build time (only written when its content changes)",
+        "",
+        "#pragma once",
+        "",
+        f'#define BOARD_PROFILE_ENV      "{envName}"',
+        f'#define BOARD_PROFILE_MCU      "{mcu}"',
+        f"#define BOARD_CPU_CORES        {cores}",
+        f"#define BOARD_F_CPU_MHZ        {cpuMhz}",
+        f"#define BOARD_MAX_CPU_MHZ      {maxMhz}",
+        f"#define BOARD_MIN_CPU_MHZ      {minMhz}",
+        f"#define BOARD_FLASH_BYTES      {flashBytes}UL",
+        f"#define BOARD_PSRAM            {1 if psram else 0}",
+        f"#define BOARD_RMT_TX_CHANNELS  {rmtChannels}",
+        f"#define BOARD_FS_BYTES         {fsBytes}UL",
+        f"#define BOARD_FS_READ_SIZE     {fsRead}",
+        f"#define BOARD_FS_PROG_SIZE     {fsProg}",
+        f"#define BOARD_FS_CACHE_SIZE    {fsCache}",
+        f"#define BOARD_FS_LOOKAHEAD     {fsLookahead}",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main() -> None:
+    if env.get("PIOPLATFORM") == "native":  # noqa: F821
+        return
+
+    envName = env["PIOENV"]  # noqa: F821
+    board = env.BoardConfig()  # noqa: F821
+    projectFlags = " ".join(env.GetProjectOption("build_flags", []) or [])  # noqa: F821
+    projectDir = Path(env.subst("$PROJECT_DIR"))  # noqa: F821
+    profile = buildProfile(envName, board, projectFlags, projectDir)
+
+    outputDir = Path(env.subst("$BUILD_DIR")) / "boardProfile"  # noqa: F821
+    outputDir.mkdir(parents=True, exist_ok=True)
+    header = outputDir / "boardProfile.h"
+    # only rewrite a changed profile, an unchanged one must not rebuild everything
+    if not header.exists() or header.read_text(encoding="utf-8") != profile:
+        header.write_text(profile, encoding="utf-8")
+        print(f"generateBoardProfile: wrote {header}")
+
+    env.Append(CPPPATH=[str(outputDir)], CPPDEFINES=["BOARD_PROFILE_GENERATED"])  # noqa: F821
+
+
+main()
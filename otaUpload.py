@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Send a firmware image to the "ota" console command (src/otaUpdate.cpp) over serial.
+
+Protocol (one line each way, the data in between is raw):
+  host  : "ota <bytes> <sha256>\\n"
+  device: "OTA ready <chunk>"           then per chunk of <chunk> bytes
+  device: "OTA ack <received>"          and at the end
+  device: "OTA ok <bytes>" or "OTA fail <bytes>"
+"""
+import argparse
+import hashlib
+import time
+from pathlib import Path
+
+scriptVersion = "v1.0 (2026-10-14)"
+replyTimeout = 15.0
+
+
+def waitForReply(port, expectedWord: str) -> tuple[str, int]:
+    deadline = time.monotonic() + replyTimeout
+    while time.monotonic() < deadline:
+        line = port.readline().decode("utf-8", errors="replace").strip()
+        if not line.startswith("OTA "):
+            # ordinary log lines of the running firmware
+            continue
+        parts = line.split()
+        if len(parts) >= 3 and parts[1] in (expectedWord, "fail", "ok"):
+            return parts[1], int(parts[2])
+    raise SystemExit(f"No 'OTA {expectedWord}' from the device within {replyTimeout:.0f} s.")
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=f"otaUpload.py {scriptVersion}")
+    parser.add_argument("port", help="serial port, e.g. /dev/ttyACM0")
+    parser.add_argument("firmware", help="firmware.bin to send")
+    parser.add_argument("--baud", type=int, default=115200, help="baud rate (ignored by USB CDC)")
+    args = parser.parse_args()
+
+    try:
+        import serial  # pyserial
+    except ImportError:
+        raise SystemExit("pyserial is required: pip install pyserial")
+
+    image = Path(args.firmware).read_bytes()
+    sha256 = hashlib.sha256(image).hexdigest()
+    print(f"Image {args.firmware}: {len(image)} bytes, sha256 {sha256}")
+
+    with serial.Serial(args.port, args.baud, timeout=0.5) as port:
+        port.reset_input_buffer()
+        port.write(f"ota {len(image)} {sha256}\n".encode("ascii"))
+
+        word, chunkSize = waitForReply(port, "ready")
+        if word != "ready":
+            raise SystemExit("The device refused the update (see its log).")
+
+        sent = 0
+        while sent < len(image):
+            chunk = image[sent:sent + chunkSize]
+            port.write(chunk)
+            sent += len(chunk)
+            if sent == len(image):
+                break
+            word, received = waitForReply(port, "ack")
+            if word != "ack" or received != sent:
+                raise SystemExit(f"Transfer failed at {sent} bytes (device: {word} {received}).")
+            print(f"\r{sent * 100 // len(image):3d}%", end="", flush=True)
+
+        word, received = waitForReply(port, "ok")
+        print()
+        if word != "ok":
+            raise SystemExit(f"The device rejected the image after {received} bytes.")
+
+    print("Update written, the device restarts into the new image.")
+    return 0
+
+
+if __name__ == "__main__":
+    try:
+        raise SystemExit(main())
+    except KeyboardInterrupt:
+        raise SystemExit("Aborted by user.")
@@ -0,0 +1,257 @@
+//--- Read-only asset pack served straight from flash (no File, no heap copies)
+
+#include "assetPack.h"
+
+#if ASSET_PACK_ENABLED
+
+#include "logger.h"
+#include "crc32.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_partition.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+  #include "assetPackData.h"
+#endif
+
+//-- layout written by createAssetPack.py (little endian, same as both SoCs)
+static const uint32_t assetPackMagic   = 0x4B505341;   // "ASPK"
+static const uint16_t assetPackVersion = 1;
+
+struct packHeader
+{
+  uint32_t magic;
+  uint16_t version;
+  uint16_t entryCount;
+  uint32_t totalSize;
+  uint32_t reserved;
+};
+
+void AssetPack::copyFromPack(void *dst, const void *src, size_t size) const
+{
+#if defined(ARDUINO_ARCH_ESP8266)
+  //-- flash mapped memory on the ESP8266 only allows aligned 32-bit loads
+  memcpy_P(dst, src, size);
+#else
+  memcpy(dst, src, size);
+#endif
+
+}   //   copyFromPack()
+
+bool AssetPack::begin()
+{
+  if (mapped)
+  {
+    return true;
+  }
+
+  packHeader header;
+  uint32_t   regionSize = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+  const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                              ESP_PARTITION_SUBTYPE_ANY,
+                                                              ASSET_PACK_PARTITION);
+  if (partition == nullptr)
+  {
+    LOG_INFO("Info: no [%s] partition, asset pack disabled.\n", ASSET_PACK_PARTITION);
+    return false;
+  }
+  if (esp_partition_read(partition, 0, &header, sizeof(header)) != 0)
+  {
+    LOG_ERROR("Error: cannot read the asset pack header.\n");
+    return false;
+  }
+  regionSize = partition->size;
+#elif defined(ARDUINO_ARCH_ESP8266)
+  copyFromPack(&header, assetPackData, sizeof(header));
+  regionSize = sizeof(assetPackData);
+#endif
+
+  if (header.magic != assetPackMagic || header.version != assetPackVersion)
+  {
+    LOG_WARN("Warning: no valid asset pack (magic %08x, version %u).\n", (unsigned)header.magic, (unsigned)header.version);
+    return false;
+  }
+  uint32_t indexEnd = sizeof(packHeader) + (uint32_t)header.entryCount * sizeof(packEntry);
+  if (header.totalSize > regionSize || indexEnd > header.totalSize)
+  {
+    LOG_ERROR("Error: asset pack size %u does not fit region %u.\n", (unsigned)header.totalSize, (unsigned)regionSize);
+    return false;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //-- only the used part is mapped, the cache MMU pages are a shared resource
+  const void                  *mappedPtr = nullptr;
+  esp_partition_mmap_handle_t  handle;
+  if (esp_partition_mmap(partition, 0, header.totalSize, ESP_PARTITION_MMAP_DATA, &mappedPtr, &handle) != 0)
+  {
+    LOG_ERROR("Error: cannot map the asset pack (%u bytes).\n", (unsigned)header.totalSize);
+    return false;
+  }
+  base      = (const uint8_t *)mappedPtr;
+  mapHandle = handle;
+#elif defined(ARDUINO_ARCH_ESP8266)
+  base = assetPackData;
+#endif
+
+  totalSize  = header.totalSize;
+  entryCount = header.entryCount;
+  mapped     = true;
+
+  LOG_INFO("Info: asset pack mapped, %u assets in %u bytes.\n", (unsigned)entryCount, (unsigned)totalSize);
+  return true;
+
+}   //   begin()
+
+void AssetPack::end()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  if (mapped)
+  {
+    esp_partition_munmap(mapHandle);
+  }
+#endif
+  base       = nullptr;
+  totalSize  = 0;
+  entryCount = 0;
+  mapped     = false;
+
+}   //   end()
+
+bool AssetPack::loadEntry(uint16_t index, packEntry &packed) const
+{
+  if (!mapped || index >= entryCount)
+  {
+    return false;
+  }
+
+  copyFromPack(&packed, base + sizeof(packHeader) + (uint32_t)index * sizeof(packEntry), sizeof(packEntry));
+  packed.name[ASSET_NAME_LEN - 1] = '\0';
+
+  //-- never hand out a view that points past the pack
+  if (packed.offset > totalSize || packed.length > totalSize - packed.offset)
+  {
+    return false;
+  }
+  return true;
+
+}   //   loadEntry()
+
+bool AssetPack::find(const char *name, assetView &view) const
+{
+  if (name == nullptr)
+  {
+    return false;
+  }
+
+  int32_t low  = 0;
+  int32_t high = (int32_t)entryCount - 1;
+  while (low <= high)
+  {
+    int32_t   middle = low + (high - low) / 2;
+    packEntry packed;
+    if (!loadEntry((uint16_t)middle, packed))
+    {
+      return false;
+    }
+
+    int compare = strcmp(name, packed.name);
+    if (compare == 0)
+    {
+      view.data   = base + packed.offset;
+      view.length = packed.length;
+      return true;
+    }
+    if (compare < 0)
+    {
+      high = middle - 1;
+    }
+    else
+    {
+      low = middle + 1;
+    }
+  }
+  return false;
+
+}   //   find()
+
+bool AssetPack::entry(uint16_t index, char *name, size_t nameSize, assetView &view) const
+{
+  packEntry packed;
+  if (!loadEntry(index, packed))
+  {
+    return false;
+  }
+
+  if (name != nullptr && nameSize > 0)
+  {
+    snprintf(name, nameSize, "%s", packed.name);
+  }
+  view.data   = base + packed.offset;
+  view.length = packed.length;
+  return true;
+
+}   //   entry()
+
+size_t AssetPack::read(const assetView &view, uint32_t offset, void *buffer, size_t size) const
+{
+  if (!mapped || view.data == nullptr || buffer == nullptr || offset >= view.length)
+  {
+    return 0;
+  }
+
+  if (size > view.length - offset)
+  {
+    size = view.length - offset;
+  }
+  copyFromPack(buffer, view.data + offset, size);
+  return size;
+
+}   //   read()
+
+bool AssetPack::verify(uint16_t index) const
+{
+  packEntry packed;
+  if (!loadEntry(index, packed))
+  {
+    return false;
+  }
+
+  //-- read through a small stack buffer so it works on ESP8266 flash as well
+  uint8_t  chunk[64];
+  uint32_t crc  = 0;
+  uint32_t done = 0;
+  while (done < packed.length)
+  {
+    uint32_t step = packed.length - done;
+    if (step > sizeof(chunk))
+    {
+      step = sizeof(chunk);
+    }
+    copyFromPack(chunk, base + packed.offset + done, step);
+    crc   = crc32Update(crc, chunk, step);
+    done += step;
+  }
+  return crc == packed.crc32;
+
+}   //   verify()
+
+void AssetPack::printListing() const
+{
+  if (!mapped)
+  {
+    return;
+  }
+
+  for (uint16_t index = 0; index < entryCount; index++)
+  {
+    packEntry packed;
+    if (loadEntry(index, packed))
+    {
+      LOG_INFO("ASSET: %s\tSIZE: %u\n", packed.name, (unsigned)packed.length);
+    }
+  }
+
+}   //   printListing()
+
+#endif   // ASSET_PACK_ENABLED
@@ -0,0 +1,82 @@
+//--- Read-only asset pack served straight from flash (no File, no heap copies)
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- selected with -DUSE_ASSET_PACK; the pack is built with createAssetPack.py
+//-- ESP32  : flashed into a data partition labelled "assets", read through esp_partition_mmap()
+//-- ESP8266: embedded as PROGMEM array (-DASSET_PACK_EMBEDDED + generated assetPackData.h),
+//--          which the SoC maps into the address space like any other flash constant
+#if defined(USE_ASSET_PACK) && (defined(ARDUINO_ARCH_ESP32) || (defined(ARDUINO_ARCH_ESP8266) && defined(ASSET_PACK_EMBEDDED)))
+  #define ASSET_PACK_ENABLED 1
+#else
+  #define ASSET_PACK_ENABLED 0
+#endif
+
+#if ASSET_PACK_ENABLED
+
+#ifndef ASSET_PACK_PARTITION
+  #define ASSET_PACK_PARTITION "assets"
+#endif
+
+//-- must match nameLength in createAssetPack.py
+#define ASSET_NAME_LEN 32
+
+//-- a pointer into mapped flash; valid until AssetPack::end()
+//-- on ESP8266 the bytes must be read 32-bit aligned (memcpy_P / AssetPack::read())
+struct assetView
+{
+  const uint8_t *data;
+  uint32_t       length;
+};
+
+class AssetPack
+{
+  public:
+    //-- map the pack and check header and index bounds; false if there is no (valid) pack
+    bool begin();
+    void end();
+
+    bool     isMapped() const   { return mapped; }
+    uint16_t count() const      { return entryCount; }
+    uint32_t packBytes() const  { return totalSize; }
+
+    //-- binary search on the sorted index ("/web/index.html")
+    bool find(const char *name, assetView &view) const;
+
+    //-- name and view of asset number index (in name order)
+    bool entry(uint16_t index, char *name, size_t nameSize, assetView &view) const;
+
+    //-- copy part of an asset into RAM, for consumers that cannot read flash directly
+    size_t read(const assetView &view, uint32_t offset, void *buffer, size_t size) const;
+
+    //-- compare the CRC32 stored in the index with the data (reads the whole asset)
+    bool verify(uint16_t index) const;
+
+    //-- one line per asset
+    void printListing() const;
+
+  private:
+    struct packEntry
+    {
+      char     name[ASSET_NAME_LEN];
+      uint32_t offset;
+      uint32_t length;
+      uint32_t crc32;
+    };
+
+    bool loadEntry(uint16_t index, packEntry &packed) const;
+    void copyFromPack(void *dst, const void *src, size_t size) const;
+
+    const uint8_t *base       = nullptr;
+    uint32_t       totalSize  = 0;
+    uint16_t       entryCount = 0;
+    bool           mapped     = false;
+#if defined(ARDUINO_ARCH_ESP32)
+    uint32_t       mapHandle  = 0;
+#endif
+
+};   //   AssetPack
+
+#endif   // ASSET_PACK_ENABLED
@@ -0,0 +1,97 @@
+//--- Board capabilities (generated per env) and the defaults the firmware derives from them
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- generateBoardProfile.py writes boardProfile.h for the env being built; without it
+//-- (Arduino IDE, the native tests) the values come from the core's own macros
+#if defined(BOARD_PROFILE_GENERATED)
+  #include "boardProfile.h"
+#else
+  #define BOARD_PROFILE_ENV "unknown"
+  #if defined(ARDUINO_ARCH_ESP32)
+    #define BOARD_PROFILE_MCU "esp32"
+    #if defined(CONFIG_FREERTOS_UNICORE)
+      #define BOARD_CPU_CORES 1
+    #else
+      #define BOARD_CPU_CORES 2
+    #endif
+    #define BOARD_MAX_CPU_MHZ 240
+    #if defined(CONFIG_IDF_TARGET_ESP32S3)
+      #define BOARD_RMT_TX_CHANNELS 4
+    #else
+      #define BOARD_RMT_TX_CHANNELS 8
+    #endif
+  #elif defined(ARDUINO_ARCH_ESP8266)
+    #define BOARD_PROFILE_MCU     "esp8266"
+    #define BOARD_CPU_CORES       1
+    #define BOARD_MAX_CPU_MHZ     160
+    #define BOARD_RMT_TX_CHANNELS 0
+  #else
+    #define BOARD_PROFILE_MCU     "host"
+    #define BOARD_CPU_CORES       1
+    #define BOARD_MAX_CPU_MHZ     80
+    #define BOARD_RMT_TX_CHANNELS 0
+  #endif
+  #if defined(F_CPU)
+    #define BOARD_F_CPU_MHZ (F_CPU / 1000000)
+  #else
+    #define BOARD_F_CPU_MHZ 80
+  #endif
+  #define BOARD_MIN_CPU_MHZ 80
+  #define BOARD_FLASH_BYTES (4UL * 1024 * 1024)
+  #if defined(BOARD_HAS_PSRAM)
+    #define BOARD_PSRAM 1
+  #else
+    #define BOARD_PSRAM 0
+  #endif
+  //-- partition size unknown; the caches the script would pick without PSRAM
+  #define BOARD_FS_BYTES 0UL
+  #if defined(ARDUINO_ARCH_ESP8266)
+    #define BOARD_FS_READ_SIZE  64
+    #define BOARD_FS_PROG_SIZE  64
+    #define BOARD_FS_CACHE_SIZE 256
+  #else
+    #define BOARD_FS_READ_SIZE  128
+    #define BOARD_FS_PROG_SIZE  128
+    #define BOARD_FS_CACHE_SIZE 512
+  #endif
+  #define BOARD_FS_LOOKAHEAD 128
+#endif
+
+//-- everything below is a default: a -D on the command line still wins
+
+//-- two cores: toggle and filesystem work in their own tasks (rtosTasks.h);
+//-- -DUSE_SINGLE_LOOP keeps everything in loop(), sleep mode always does
+#if !defined(BOARD_AUTO_RTOS_TASKS)
+  #if BOARD_CPU_CORES >= 2 && !defined(USE_SINGLE_LOOP) && !defined(USE_SLEEP_MODE)
+    #define BOARD_AUTO_RTOS_TASKS 1
+  #else
+    #define BOARD_AUTO_RTOS_TASKS 0
+  #endif
+#endif
+
+//-- an RMT peripheral drives the NeoPixels without the CPU (rmtNeoPixel.h);
+//-- -DUSE_NEOPIXEL_BITBANG keeps the Adafruit_NeoPixel driver
+#if !defined(BOARD_AUTO_NEOPIXEL_RMT)
+  #if BOARD_RMT_TX_CHANNELS > 0 && !defined(USE_NEOPIXEL_BITBANG)
+    #define BOARD_AUTO_NEOPIXEL_RMT 1
+  #else
+    #define BOARD_AUTO_NEOPIXEL_RMT 0
+  #endif
+#endif
+
+//-- the log ring and the file index are cold buffers (memAllocCold): with PSRAM
+//-- they cost no internal RAM at all, an ESP32 without it can still spare a
+//-- larger log ring, the ESP8266 keeps the small sizes
+#if BOARD_PSRAM
+  #define BOARD_LOG_BUFFER_SIZE     8192
+  #define BOARD_FS_INDEX_ENTRIES    512
+#elif defined(ARDUINO_ARCH_ESP32)
+  #define BOARD_LOG_BUFFER_SIZE     4096
+  #define BOARD_FS_INDEX_ENTRIES    128
+#else
+  #define BOARD_LOG_BUFFER_SIZE     2048
+  #define BOARD_FS_INDEX_ENTRIES    128
+#endif
@@ -0,0 +1,70 @@
+//--- Boot stage timestamps, reported as one summary line
+
+#include "bootProfile.h"
+#include "logger.h"
+
+#include <string.h>
+
+struct bootStage
+{
+  const char *name;
+  uint32_t    atUs;
+};
+
+static bootStage bootStages[BOOT_MAX_STAGES];
+static uint8_t   bootStageCount = 0;
+static bool      bootReported   = false;
+
+void bootMark(const char *stage)
+{
+  if (bootReported || bootStageCount >= BOOT_MAX_STAGES)
+  {
+    return;
+  }
+  bootStages[bootStageCount].name = stage;
+  bootStages[bootStageCount].atUs = micros();
+  bootStageCount++;
+
+}   //   bootMark()
+
+uint32_t bootStageUs(const char *stage)
+{
+  for (uint8_t index = 0; index < bootStageCount; index++)
+  {
+    if (strcmp(bootStages[index].name, stage) == 0)
+    {
+      return bootStages[index].atUs;
+    }
+  }
+  return 0;
+
+}   //   bootStageUs()
+
+void bootReport()
+{
+  //-- one line, may be longer than LOG_LINE_MAX so it is queued raw
+  char   line[256];
+  size_t length = snprintf(line, sizeof(line), "Boot (us since reset):");
+
+  for (uint8_t index = 0; index < bootStageCount && length < sizeof(line); index++)
+  {
+    length += snprintf(
+      &line[length],
+      sizeof(line) - length,
+      " %s=%u",
+      bootStages[index].name,
+      (unsigned)bootStages[index].atUs
+    );
+  }
+  if (length > sizeof(line) - 2)
+  {
+    length = sizeof(line) - 2;
+  }
+  line[length++] = '\n';
+
+  bootReported = true;
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+  logWriteRaw(line, length);
+#endif
+
+}   //   bootReport()
@@ -0,0 +1,18 @@
+//--- Boot stage timestamps, reported as one summary line
+
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef BOOT_MAX_STAGES
+  #define BOOT_MAX_STAGES 10
+#endif
+
+//-- record micros() since reset for stage (name must be a string literal)
+void bootMark(const char *stage);
+
+//-- log all recorded stages on one line; later marks are ignored
+void bootReport();
+
+//-- micros() at the given mark, 0 if it was not recorded
+uint32_t bootStageUs(const char *stage);
@@ -0,0 +1,317 @@
+//--- Compressed files on LittleFS: heatshrink (LZSS) streams, decompressed while they are read
+
+#include "compressedFile.h"
+#include "crc32.h"
+#include "fsWalker.h"
+#include "logger.h"
+
+#include <string.h>
+
+static const char compressedMagic[4] = { 'H', 'S', 'Z', '1' };
+
+//-- smallest lookahead/window heatshrink accepts
+static const uint8_t minLookaheadBits = 3;
+static const uint8_t minWindowBits    = 4;
+
+bool compressedIsPath(const char *path)
+{
+  size_t length = strlen(path);
+  size_t suffix = sizeof(COMPRESSED_SUFFIX) - 1;
+  return length > suffix && strcmp(&path[length - suffix], COMPRESSED_SUFFIX) == 0;
+
+}   //   compressedIsPath()
+
+static bool headerIsValid(const compressedHeader &header)
+{
+  return memcmp(header.magic, compressedMagic, sizeof(compressedMagic)) == 0
+         && header.windowBits >= minWindowBits && header.windowBits <= COMPRESSED_WINDOW_BITS_MAX
+         && header.lookaheadBits >= minLookaheadBits && header.lookaheadBits < header.windowBits;
+
+}   //   headerIsValid()
+
+static bool readHeader(File &file, compressedHeader &header)
+{
+  return file.read((uint8_t *)&header, sizeof(header)) == sizeof(header) && headerIsValid(header);
+
+}   //   readHeader()
+
+bool compressedReadHeader(fs::FS &fileSystem, const char *storedPath, compressedHeader &header)
+{
+  File file = fileSystem.open(storedPath, "r");
+  return file && readHeader(file, header);
+
+}   //   compressedReadHeader()
+
+void compressedPrintFileLine(fs::FS &fileSystem, uint8_t depth, const char *path, uint32_t size)
+{
+  compressedHeader header;
+  if (compressedIsPath(path) && compressedReadHeader(fileSystem, path, header))
+  {
+    LOG_INFO(
+      "%*sFILE: %s\tSIZE: %u (logical %u)\n",
+      depth * 2, "",
+      path,
+      (unsigned)size,
+      (unsigned)header.logicalSize
+    );
+    return;
+  }
+  LOG_INFO("%*sFILE: %s\tSIZE: %u\n", depth * 2, "", path, (unsigned)size);
+
+}   //   compressedPrintFileLine()
+
+bool CompressedFile::open(fs::FS &fileSystem, const char *path)
+{
+  close();
+
+  if (fileSystem.exists(path))
+  {
+    source = fileSystem.open(path, "r");
+    if (!source || source.isDirectory())
+    {
+      close();
+      return false;
+    }
+    storedBytes = source.size();
+    logicalSize = storedBytes;
+    return true;
+  }
+
+  char storedPath[FS_WALK_PATH_LEN];
+  int  length = snprintf(storedPath, sizeof(storedPath), "%s" COMPRESSED_SUFFIX, path);
+  if (length < 0 || (size_t)length >= sizeof(storedPath) || !fileSystem.exists(storedPath))
+  {
+    return false;
+  }
+  source = fileSystem.open(storedPath, "r");
+  if (!source)
+  {
+    return false;
+  }
+  compressed  = true;
+  storedBytes = source.size();
+  if (!openCompressed())
+  {
+    close();
+    return false;
+  }
+  return true;
+
+}   //   open()
+
+bool CompressedFile::openCompressed()
+{
+  compressedHeader header;
+  if (!source.seek(0) || !readHeader(source, header))
+  {
+    return false;
+  }
+
+  windowBits    = header.windowBits;
+  lookaheadBits = header.lookaheadBits;
+  logicalSize   = header.logicalSize;
+  expectedCrc   = header.crc32;
+  runningCrc    = 0;
+  produced      = 0;
+  peeked        = -1;
+  damaged       = false;
+  copyRemaining = 0;
+  bitMask       = 0;
+  inputPosition = 0;
+  inputLength   = 0;
+  return true;
+
+}   //   openCompressed()
+
+void CompressedFile::close()
+{
+  source.close();
+  compressed  = false;
+  damaged     = false;
+  logicalSize = 0;
+  storedBytes = 0;
+  produced    = 0;
+  peeked      = -1;
+
+}   //   close()
+
+bool CompressedFile::fillInput()
+{
+  int got = source.read(input, sizeof(input));
+  inputPosition = 0;
+  inputLength   = (got > 0) ? (uint16_t)got : 0;
+  return inputLength > 0;
+
+}   //   fillInput()
+
+//-- count bits, most significant first; -1 at the end of the stored data
+int CompressedFile::readBits(uint8_t count)
+{
+  int value = 0;
+  for (uint8_t bit = 0; bit < count; bit++)
+  {
+    if (bitMask == 0)
+    {
+      if (inputPosition >= inputLength && !fillInput())
+      {
+        return -1;
+      }
+      currentByte = input[inputPosition++];
+      bitMask     = 0x80;
+    }
+    value   = (value << 1) | ((currentByte & bitMask) ? 1 : 0);
+    bitMask >>= 1;
+  }
+  return value;
+
+}   //   readBits()
+
+//-- store a decompressed byte in the window; the CRC runs over a whole window
+//-- just before it wraps (and over the rest at the end), not byte by byte
+int CompressedFile::emit(uint8_t value)
+{
+  uint32_t mask = (1u << windowBits) - 1;
+  window[produced & mask] = value;
+  produced++;
+  if ((produced & mask) == 0 || produced == logicalSize)
+  {
+    runningCrc = crc32Update(runningCrc, window, ((produced - 1) & mask) + 1);
+    if (produced == logicalSize && runningCrc != expectedCrc)
+    {
+      damaged = true;
+    }
+  }
+  return value;
+
+}   //   emit()
+
+//-- one decompressed byte: a literal (tag 1 + 8 bits) or the next byte of a
+//-- back reference (tag 0 + index and count, both stored minus one)
+int CompressedFile::nextByte()
+{
+  if (produced >= logicalSize || damaged)
+  {
+    return -1;
+  }
+
+  if (copyRemaining == 0)
+  {
+    int tag = readBits(1);
+    if (tag == 1)
+    {
+      int literal = readBits(8);
+      if (literal < 0)
+      {
+        damaged = true;
+        return -1;
+      }
+      return emit((uint8_t)literal);
+    }
+
+    int index = (tag == 0) ? readBits(windowBits) : -1;
+    int count = (index >= 0) ? readBits(lookaheadBits) : -1;
+    if (count < 0 || (size_t)index + 1 > produced)
+    {
+      damaged = true;
+      return -1;
+    }
+    copyDistance  = (uint16_t)(index + 1);
+    copyRemaining = (uint16_t)(count + 1);
+  }
+
+  //-- a copy may overlap the bytes it produces (a run), so go byte by byte
+  copyRemaining--;
+  return emit(window[(produced - copyDistance) & ((1u << windowBits) - 1)]);
+
+}   //   nextByte()
+
+int CompressedFile::read()
+{
+  if (peeked >= 0)
+  {
+    int value = peeked;
+    peeked    = -1;
+    return value;
+  }
+  if (!compressed)
+  {
+    int value = source ? source.read() : -1;
+    if (value >= 0)
+    {
+      produced++;
+    }
+    return value;
+  }
+  return nextByte();
+
+}   //   read()
+
+int CompressedFile::peek()
+{
+  if (peeked < 0)
+  {
+    peeked = read();
+  }
+  return peeked;
+
+}   //   peek()
+
+size_t CompressedFile::read(uint8_t *buffer, size_t length)
+{
+  size_t done = 0;
+  if (peeked >= 0 && length > 0)
+  {
+    buffer[done++] = (uint8_t)peeked;
+    peeked         = -1;
+  }
+  if (!compressed)
+  {
+    size_t got = source ? source.read(&buffer[done], length - done) : 0;
+    produced += got;
+    return done + got;
+  }
+
+  while (done < length)
+  {
+    int value = nextByte();
+    if (value < 0)
+    {
+      break;
+    }
+    buffer[done++] = (uint8_t)value;
+  }
+  return done;
+
+}   //   read()
+
+bool CompressedFile::seek(uint32_t position)
+{
+  if (!source || position > logicalSize)
+  {
+    return false;
+  }
+  peeked = -1;
+  if (!compressed)
+  {
+    if (!source.seek(position))
+    {
+      return false;
+    }
+    produced = position;
+    return true;
+  }
+
+  if (position < produced && !openCompressed())
+  {
+    return false;
+  }
+  while (produced < position)
+  {
+    if (nextByte() < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+
+}   //   seek()
@@ -0,0 +1,110 @@
+//--- Compressed files on LittleFS: heatshrink (LZSS) streams, decompressed while they are read
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+//-- "/web/index.html" is stored as "/web/index.html.hs" by compressData.py
+#define COMPRESSED_SUFFIX ".hs"
+
+//-- largest window a file may use; every open CompressedFile holds one in RAM
+#ifndef COMPRESSED_WINDOW_BITS_MAX
+  #define COMPRESSED_WINDOW_BITS_MAX 10
+#endif
+
+//-- stored bytes fetched from flash per read
+#ifndef COMPRESSED_INPUT_BYTES
+  #define COMPRESSED_INPUT_BYTES 128
+#endif
+
+//-- the 16 byte header in front of the heatshrink bit stream, little endian;
+//-- must match headerFormat in compressData.py
+struct compressedHeader
+{
+  char     magic[4];        // "HSZ1"
+  uint8_t  windowBits;      // heatshrink -w
+  uint8_t  lookaheadBits;   // heatshrink -l
+  uint16_t reserved;
+  uint32_t logicalSize;     // size after decompression
+  uint32_t crc32;           // of the decompressed data
+};
+
+static_assert(sizeof(compressedHeader) == 16, "compressedHeader must stay 16 bytes");
+
+//-- path ends in COMPRESSED_SUFFIX
+bool compressedIsPath(const char *path);
+
+//-- read and check the header of a stored ".hs" file (for listings)
+bool compressedReadHeader(fs::FS &fileSystem, const char *storedPath, compressedHeader &header);
+
+//-- one listing line "FILE: <path>\tSIZE: <stored>", for a ".hs" file followed by
+//-- " (logical <size>)" from its header; shared by every listing of the firmware
+void compressedPrintFileLine(fs::FS &fileSystem, uint8_t depth, const char *path, uint32_t size);
+
+//-- read-only file with the File read interface; plain files are passed
+//-- through, compressed ones are decompressed with a fixed window, so reading
+//-- takes the stored (smaller) number of bytes from flash
+class CompressedFile
+{
+  public:
+    CompressedFile() {}
+    ~CompressedFile() { close(); }
+
+    //-- open the logical path: the file itself, else path + COMPRESSED_SUFFIX
+    bool open(fs::FS &fileSystem, const char *path);
+    void close();
+
+    operator bool() const { return (bool)source; }
+
+    bool   isCompressed() const { return compressed; }
+    //-- logical bytes (what read() returns in total) and bytes on flash
+    size_t size() const        { return logicalSize; }
+    size_t storedSize() const  { return storedBytes; }
+    //-- a peek()ed byte is not read yet
+    size_t position() const    { return produced - ((peeked >= 0) ? 1 : 0); }
+    int    available()         { return (int)(logicalSize - position()); }
+
+    int    read();
+    int    peek();
+    size_t read(uint8_t *buffer, size_t length);
+
+    //-- forward seeks decompress up to the position, backward ones start over
+    bool seek(uint32_t position);
+
+    //-- a bad stream or a CRC mismatch at the end; read() returns short from then on
+    bool isDamaged() const { return damaged; }
+
+  private:
+    bool openCompressed();
+    bool fillInput();
+    int  readBits(uint8_t count);
+    int  nextByte();
+    int  emit(uint8_t value);
+
+    File     source;
+    bool     compressed  = false;
+    bool     damaged     = false;
+    size_t   logicalSize = 0;
+    size_t   storedBytes = 0;
+    size_t   produced    = 0;
+    int      peeked      = -1;
+
+    //-- decoder state
+    uint8_t  windowBits    = 0;
+    uint8_t  lookaheadBits = 0;
+    uint32_t expectedCrc   = 0;
+    uint32_t runningCrc    = 0;
+    uint16_t copyDistance  = 0;
+    uint16_t copyRemaining = 0;
+    uint8_t  currentByte   = 0;
+    uint8_t  bitMask       = 0;
+    uint16_t inputPosition = 0;
+    uint16_t inputLength   = 0;
+    uint8_t  input[COMPRESSED_INPUT_BYTES];
+    uint8_t  window[1 << COMPRESSED_WINDOW_BITS_MAX];
+
+    CompressedFile(const CompressedFile &) = delete;
+    CompressedFile &operator=(const CompressedFile &) = delete;
+
+};   //   CompressedFile
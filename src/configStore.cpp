@@ -0,0 +1,255 @@
+//--- Persistent settings: loaded once at boot, changes coalesced in RAM and written lazily
+
+#include "configStore.h"
+#include "logger.h"
+
+#include <stddef.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <Preferences.h>
+#else
+  #include <LittleFS.h>
+  #include "fsIndex.h"
+#endif
+
+static const uint16_t configMagic   = 0x4347;   // "GC"
+static const uint16_t configVersion = 1;
+
+#if !defined(ARDUINO_ARCH_ESP32)
+static const char *configTempPath = CONFIG_FILE_PATH ".tmp";
+#endif
+
+//-- what goes to flash: the settings framed by magic, version and a checksum
+struct configRecord
+{
+  uint16_t     magic;
+  uint16_t     version;
+  deviceConfig config;
+  uint32_t     check;
+};
+
+static uint32_t recordCheck(const configRecord &record)
+{
+  //-- FNV-1a over everything but the check itself
+  const uint8_t *bytes = (const uint8_t *)&record;
+  uint32_t       hash  = 2166136261UL;
+  for (size_t i = 0; i < offsetof(configRecord, check); i++)
+  {
+    hash = (hash ^ bytes[i]) * 16777619UL;
+  }
+  return hash;
+
+}   //   recordCheck()
+
+//-- wrap-around safe "a is at or after b" for millis() timestamps
+static inline bool isDue(uint32_t nowMs, uint32_t dueMs)
+{
+  return (int32_t)(nowMs - dueMs) >= 0;
+
+}   //   isDue()
+
+bool ConfigStore::begin(const deviceConfig &defaults)
+{
+  current = defaults;
+  stored  = defaults;
+  dirty   = false;
+
+  deviceConfig fromFlash = {};
+  loaded = load(fromFlash);
+  if (loaded)
+  {
+    current = fromFlash;
+    stored  = fromFlash;
+    LOG_INFO("Info: settings loaded (period %u ms, brightness %u).\n", (unsigned)current.delayTime, (unsigned)current.brightness);
+  }
+  else
+  {
+    LOG_INFO("Info: no stored settings, using the defaults.\n");
+  }
+  return loaded;
+
+}   //   begin()
+
+uint32_t ConfigStore::update(const deviceConfig &config)
+{
+  uint32_t nowMs = millis();
+
+  current = config;
+  if (memcmp(&current, &stored, sizeof(current)) == 0)
+  {
+    //-- changed back to what is in flash: nothing left to write
+    dirty     = false;
+    coalesced = 0;
+    return 0;
+  }
+
+  if (dirty)
+  {
+    coalesced++;
+  }
+  else
+  {
+    dirty         = true;
+    firstChangeMs = nowMs;
+  }
+  lastChangeMs = nowMs;
+
+  //-- the write itself is left to commitIfDue(), the caller picks a moment
+  //-- the output has room for it; due already: call it at once
+  uint32_t writeMs = dueMs();
+  return ::isDue(nowMs, writeMs) ? 1 : writeMs - nowMs;
+
+}   //   update()
+
+//-- millis() at which the pending change is written
+uint32_t ConfigStore::dueMs() const
+{
+  uint32_t settledMs = lastChangeMs + CONFIG_COMMIT_DELAY_MS;
+  uint32_t latestMs  = firstChangeMs + CONFIG_MAX_DIRTY_MS;
+  return ((int32_t)(latestMs - settledMs) < 0) ? latestMs : settledMs;
+
+}   //   dueMs()
+
+bool ConfigStore::isDue() const
+{
+  return dirty && ::isDue(millis(), dueMs());
+
+}   //   isDue()
+
+uint32_t ConfigStore::commitIfDue()
+{
+  if (!dirty)
+  {
+    return 0;
+  }
+
+  uint32_t nowMs   = millis();
+  uint32_t writeMs = dueMs();
+
+  if (!::isDue(nowMs, writeMs))
+  {
+    return writeMs - nowMs;
+  }
+
+  if (!commit())
+  {
+    //-- keep the change in RAM and try again after another delay
+    lastChangeMs  = nowMs;
+    firstChangeMs = nowMs;
+    return CONFIG_COMMIT_DELAY_MS;
+  }
+  return 0;
+
+}   //   commitIfDue()
+
+bool ConfigStore::commit()
+{
+  if (!dirty)
+  {
+    return true;
+  }
+  uint32_t startUs = micros();
+  bool     written = store(current);
+  uint32_t tookUs  = micros() - startUs;
+  if (tookUs > longestCommitUs)
+  {
+    longestCommitUs = tookUs;
+  }
+  if (!written)
+  {
+    LOG_ERROR("Error: could not write the settings.\n");
+    return false;
+  }
+
+  stored = current;
+  dirty  = false;
+  writes++;
+  LOG_INFO("Info: settings written (%u changes coalesced).\n", (unsigned)coalesced);
+  coalesced = 0;
+  return true;
+
+}   //   commit()
+
+bool ConfigStore::load(deviceConfig &config)
+{
+  configRecord record = {};
+
+#if defined(ARDUINO_ARCH_ESP32)
+  Preferences preferences;
+  if (!preferences.begin(CONFIG_NVS_NAMESPACE, true))
+  {
+    return false;
+  }
+  size_t length = preferences.getBytes("config", &record, sizeof(record));
+  preferences.end();
+#else
+  File file = LittleFS.open(CONFIG_FILE_PATH, "r");
+  if (!file)
+  {
+    file = LittleFS.open(configTempPath, "r");
+  }
+  if (!file)
+  {
+    return false;
+  }
+  size_t length = file.read((uint8_t *)&record, sizeof(record));
+  file.close();
+#endif
+
+  if (length != sizeof(record) || record.magic != configMagic
+      || record.version != configVersion || record.check != recordCheck(record))
+  {
+    return false;
+  }
+  config = record.config;
+  return true;
+
+}   //   load()
+
+bool ConfigStore::store(const deviceConfig &config)
+{
+  configRecord record = {};
+  record.magic   = configMagic;
+  record.version = configVersion;
+  record.config  = config;
+  record.check   = recordCheck(record);
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //-- NVS itself is wear levelled and writes atomically
+  Preferences preferences;
+  if (!preferences.begin(CONFIG_NVS_NAMESPACE, false))
+  {
+    return false;
+  }
+  size_t written = preferences.putBytes("config", &record, sizeof(record));
+  preferences.end();
+  return (written == sizeof(record));
+#else
+  //-- write a temporary file and rename it, a reset never leaves half a record
+  //-- (load() falls back to the temporary file if it happened after the remove)
+  if (index != nullptr)
+  {
+    if (index->writeFile(configTempPath, (const uint8_t *)&record, sizeof(record)) != sizeof(record))
+    {
+      return false;
+    }
+    index->removeFile(CONFIG_FILE_PATH);
+    return index->renameFile(configTempPath, CONFIG_FILE_PATH);
+  }
+
+  File file = LittleFS.open(configTempPath, "w");
+  if (!file)
+  {
+    return false;
+  }
+  size_t written = file.write((const uint8_t *)&record, sizeof(record));
+  file.close();
+  if (written != sizeof(record))
+  {
+    return false;
+  }
+  LittleFS.remove(CONFIG_FILE_PATH);
+  return LittleFS.rename(configTempPath, CONFIG_FILE_PATH);
+#endif
+
+}   //   store()
@@ -0,0 +1,99 @@
+//--- Persistent settings: loaded once at boot, changes coalesced in RAM and written lazily
+
+#pragma once
+
+#include <Arduino.h>
+
+class FsIndex;
+
+//-- ESP32 keeps the settings in the "nvs" partition, ESP8266 in a LittleFS file
+//-- (which needs the filesystem mounted before begin())
+#if defined(ARDUINO_ARCH_ESP32)
+  #define CONFIG_STORE_NEEDS_FS 0
+#else
+  #define CONFIG_STORE_NEEDS_FS 1
+#endif
+
+#ifndef CONFIG_NVS_NAMESPACE
+  #define CONFIG_NVS_NAMESPACE "blink"
+#endif
+
+#ifndef CONFIG_FILE_PATH
+  #define CONFIG_FILE_PATH "/config.bin"
+#endif
+
+//-- a change is written once no further change came in for this long ...
+#ifndef CONFIG_COMMIT_DELAY_MS
+  #define CONFIG_COMMIT_DELAY_MS 5000
+#endif
+
+//-- ... but never later than this after the first unsaved change
+#ifndef CONFIG_MAX_DIRTY_MS
+  #define CONFIG_MAX_DIRTY_MS 30000
+#endif
+
+//-- assumed duration of one commit until one has been measured; NVS (or LittleFS
+//-- on the ESP8266) may erase a 4 KB sector first (~45 ms), stalling both caches
+#ifndef CONFIG_COMMIT_BUSY_US
+  #define CONFIG_COMMIT_BUSY_US 50000
+#endif
+
+//-- the stored settings; explicit padding so records compare with memcmp()
+struct deviceConfig
+{
+  uint32_t delayTime;
+  uint32_t color;
+  uint8_t  brightness;
+  uint8_t  reserved[3];
+};
+
+class ConfigStore
+{
+  public:
+    //-- load the stored settings, or keep defaults when there are none (or they are invalid)
+    bool begin(const deviceConfig &defaults);
+
+    //-- ESP8266: write through the index wrappers so listing and usage stay correct
+    void setIndex(FsIndex *fileIndex) { index = fileIndex; }
+
+    const deviceConfig &get() const { return current; }
+
+    //-- take over a changed config in RAM only, never writes; returns the ms
+    //-- until commitIfDue() should be called (0 when it equals the stored one)
+    uint32_t update(const deviceConfig &config);
+
+    //-- true when dirty and commitIfDue() would write now
+    bool isDue() const;
+
+    //-- write when the settings have settled or were dirty for too long;
+    //-- returns the ms until the next call is useful (0 when clean)
+    uint32_t commitIfDue();
+
+    //-- write now if anything changed
+    bool commit();
+
+    bool     isDirty() const        { return dirty; }
+    bool     isLoaded() const       { return loaded; }
+    uint32_t writeCount() const     { return writes; }
+    //-- changes folded into the pending write (0 after every commit)
+    uint32_t coalescedCount() const { return coalesced; }
+    //-- longest commit so far, the estimate for the next one
+    uint32_t maxCommitUs() const    { return longestCommitUs; }
+
+  private:
+    bool     load(deviceConfig &config);
+    bool     store(const deviceConfig &config);
+    uint32_t dueMs() const;
+
+    deviceConfig current         = {};
+    deviceConfig stored          = {};
+    FsIndex     *index           = nullptr;
+    bool         dirty           = false;
+    bool         loaded          = false;
+    uint32_t     firstChangeMs   = 0;
+    uint32_t     lastChangeMs    = 0;
+    uint32_t     writes          = 0;
+    uint32_t     coalesced       = 0;
+    uint32_t     longestCommitUs = CONFIG_COMMIT_BUSY_US;
+
+};   //   ConfigStore
@@ -0,0 +1,151 @@
+//--- CPU clock scaling: full speed during bursts of work, a low clock while the loop idles
+
+#include "cpuScaling.h"
+
+#if CPU_SCALING_ENABLED
+
+#include "logger.h"
+
+#include <atomic>
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+#else
+  extern "C"
+  {
+    #include <user_interface.h>
+  }
+#endif
+
+static std::atomic<int32_t> burstDepth(0);
+//-- set by a burst in another task, noticed by the next cpuScalingService()
+static std::atomic<bool>    burstSeen(false);
+
+static uint16_t currentMhz   = 0;
+static uint32_t lastBurstMs  = 0;
+static uint32_t burstStartMs = 0;
+static uint32_t burstTotalMs = 0;
+static uint32_t raiseCount   = 0;
+static uint32_t lowerCount   = 0;
+
+#if defined(ARDUINO_ARCH_ESP32)
+static TaskHandle_t loopTask = nullptr;
+#endif
+
+static bool onLoopTask()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  return xTaskGetCurrentTaskHandle() == loopTask;
+#else
+  return true;
+#endif
+
+}   //   onLoopTask()
+
+static void applyMhz(uint16_t mhz)
+{
+  if (mhz == currentMhz)
+  {
+    return;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //-- 80 MHz and up keep the APB (UART, LEDC, RMT, timers) at 80 MHz
+  if (!setCpuFrequencyMhz(mhz))
+  {
+    LOG_WARN("Warning: the CPU cannot run at %u MHz.\n", (unsigned)mhz);
+    return;
+  }
+#else
+  system_update_cpu_freq((mhz >= 160) ? SYS_CPU_160MHZ : SYS_CPU_80MHZ);
+#endif
+
+  uint32_t nowMs = millis();
+  if (mhz > currentMhz)
+  {
+    raiseCount++;
+    burstStartMs = nowMs;
+  }
+  else
+  {
+    lowerCount++;
+    burstTotalMs += nowMs - burstStartMs;
+  }
+  currentMhz = mhz;
+
+}   //   applyMhz()
+
+void cpuScalingBegin()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  loopTask   = xTaskGetCurrentTaskHandle();
+  currentMhz = (uint16_t)getCpuFrequencyMhz();
+#else
+  currentMhz = (uint16_t)ESP.getCpuFreqMHz();
+#endif
+  burstStartMs = millis();
+  lastBurstMs  = burstStartMs;
+
+  LOG_INFO(
+    "Info: CPU scaling %u MHz during bursts, %u MHz when idle (was %u MHz)\n",
+    (unsigned)CPU_BURST_MHZ,
+    (unsigned)CPU_IDLE_MHZ,
+    (unsigned)currentMhz
+  );
+  applyMhz(CPU_BURST_MHZ);
+
+}   //   cpuScalingBegin()
+
+void cpuBurstBegin()
+{
+  burstDepth++;
+  burstSeen = true;
+  if (onLoopTask())
+  {
+    applyMhz(CPU_BURST_MHZ);
+  }
+
+}   //   cpuBurstBegin()
+
+void cpuBurstEnd()
+{
+  burstDepth--;
+
+}   //   cpuBurstEnd()
+
+void cpuScalingService(bool busy)
+{
+  uint32_t nowMs = millis();
+
+  //-- exchange() also catches a burst that began and ended since the last pass
+  if (busy || burstSeen.exchange(false) || burstDepth.load() > 0)
+  {
+    lastBurstMs = nowMs;
+    applyMhz(CPU_BURST_MHZ);
+    return;
+  }
+
+  if (currentMhz != CPU_IDLE_MHZ && nowMs - lastBurstMs >= CPU_IDLE_AFTER_MS)
+  {
+    applyMhz(CPU_IDLE_MHZ);
+  }
+
+}   //   cpuScalingService()
+
+cpuScalingStats cpuScalingGetStats()
+{
+  cpuScalingStats stats;
+  stats.currentMhz = currentMhz;
+  stats.raises     = raiseCount;
+  stats.lowers     = lowerCount;
+  stats.burstMs    = burstTotalMs;
+  if (currentMhz == CPU_BURST_MHZ)
+  {
+    stats.burstMs += millis() - burstStartMs;
+  }
+  return stats;
+
+}   //   cpuScalingGetStats()
+
+#endif   //   CPU_SCALING_ENABLED
@@ -0,0 +1,77 @@
+//--- CPU clock scaling: full speed during bursts of work, a low clock while the loop idles
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "boardCaps.h"
+
+//-- selected with -DUSE_CPU_SCALING
+#if defined(USE_CPU_SCALING) && (defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266))
+  #define CPU_SCALING_ENABLED 1
+#else
+  #define CPU_SCALING_ENABLED 0
+#endif
+
+#if CPU_SCALING_ENABLED
+
+#if defined(ARDUINO_ARCH_ESP8266) && defined(USE_NEOPIXEL)
+  #error "USE_CPU_SCALING changes the clock the ESP8266 NeoPixel bit-bang timing is built for"
+#endif
+
+//-- clock during a burst and while idle (MHz, from the board profile)
+#ifndef CPU_BURST_MHZ
+  #define CPU_BURST_MHZ BOARD_MAX_CPU_MHZ
+#endif
+
+#ifndef CPU_IDLE_MHZ
+  #define CPU_IDLE_MHZ BOARD_MIN_CPU_MHZ
+#endif
+
+//-- the clock only goes down after this long without a burst, so a stream
+//-- of short bursts does not switch it back and forth
+#ifndef CPU_IDLE_AFTER_MS
+  #define CPU_IDLE_AFTER_MS 500
+#endif
+
+struct cpuScalingStats
+{
+  uint16_t currentMhz;
+  uint32_t raises;
+  uint32_t lowers;
+  //-- total time spent at CPU_BURST_MHZ, the current stretch included
+  uint32_t burstMs;
+};
+
+//-- remember the loop task and go to CPU_BURST_MHZ (the rest of setup() is
+//-- a burst too); call once from setup()
+void cpuScalingBegin();
+
+//-- a burst of work starts / ends; callable from any task, they nest.
+//-- On the loop task the clock goes up at once, a burst in another task
+//-- raises it on the next cpuScalingService()
+void cpuBurstBegin();
+void cpuBurstEnd();
+
+//-- call from loop() before it idles; busy marks work that spans several
+//-- passes (an upload, a response). Raises the clock while there is a burst,
+//-- lowers it CPU_IDLE_AFTER_MS after the last one. The clock is only ever
+//-- changed on the loop task
+void cpuScalingService(bool busy);
+
+cpuScalingStats cpuScalingGetStats();
+
+//-- marks the scope it lives in as a burst
+class CpuBurst
+{
+  public:
+    CpuBurst()  { cpuBurstBegin(); }
+    ~CpuBurst() { cpuBurstEnd(); }
+
+  private:
+    CpuBurst(const CpuBurst &) = delete;
+    CpuBurst &operator=(const CpuBurst &) = delete;
+
+};   //   CpuBurst
+
+#endif   //   CPU_SCALING_ENABLED
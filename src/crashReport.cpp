@@ -0,0 +1,243 @@
+//--- Crash report: reset reason and a compact summary of a stored coredump, read once at boot
+
+#include "crashReport.h"
+
+#if CRASH_REPORT_ENABLED
+
+#include "logger.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_system.h>
+  #include <esp_partition.h>
+  #include <esp_core_dump.h>
+#endif
+
+//-- erasing the first sector blanks the image header; the panic handler
+//-- erases what it needs itself, so the other 60 KB can stay as they are
+#ifndef CRASH_CLEAR_BYTES
+  #define CRASH_CLEAR_BYTES 4096
+#endif
+
+static crashSummary summary = {};
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+static const char *resetReasonNames[] =
+{
+  "unknown", "poweron", "external", "software", "panic", "intwdt",
+  "taskwdt", "wdt", "deepsleep", "brownout", "sdio"
+};
+
+static bool isCrashReset(uint8_t reason)
+{
+  return reason == ESP_RST_PANIC || reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT
+         || reason == ESP_RST_WDT || reason == ESP_RST_BROWNOUT;
+
+}   //   isCrashReset()
+
+//-- the summary comes from the ELF notes of the image; it needs a core
+//-- that stores coredumps to flash in ELF format (the Arduino 2.x default)
+static void readCoredump()
+{
+  size_t imageAddress = 0;
+  size_t imageBytes   = 0;
+
+  if (esp_core_dump_image_get(&imageAddress, &imageBytes) != ESP_OK)
+  {
+    return;
+  }
+  summary.dumpFound = true;
+  summary.dumpBytes = (uint32_t)imageBytes;
+
+#if defined(CONFIG_ESP_COREDUMP_ENABLE_TO_FLASH) && defined(CONFIG_ESP_COREDUMP_DATA_FORMAT_ELF)
+  esp_core_dump_summary_t *dump = (esp_core_dump_summary_t *)malloc(sizeof(esp_core_dump_summary_t));
+  if (dump == nullptr || esp_core_dump_get_summary(dump) != ESP_OK)
+  {
+    summary.dumpUnreadable = true;
+    free(dump);
+    return;
+  }
+
+  strncpy(summary.task, dump->exc_task, sizeof(summary.task) - 1);
+  summary.pc = dump->exc_pc;
+  for (uint8_t index = 0; index < sizeof(summary.elfSha) - 1 && dump->app_elf_sha256[index] != 0; index++)
+  {
+    summary.elfSha[index] = (char)dump->app_elf_sha256[index];
+  }
+#if defined(__XTENSA__)
+  summary.cause   = dump->ex_info.exc_cause;
+  summary.address = dump->ex_info.exc_vaddr;
+  uint32_t depth  = dump->exc_bt_info.depth;
+  if (depth > CRASH_MAX_FRAMES)
+  {
+    depth = CRASH_MAX_FRAMES;
+  }
+  for (uint32_t frame = 0; frame < depth; frame++)
+  {
+    summary.backtrace[frame] = dump->exc_bt_info.bt[frame];
+  }
+  summary.depth            = (uint8_t)depth;
+  summary.backtraceCorrupt = dump->exc_bt_info.corrupted;
+#endif
+  free(dump);
+#else
+  summary.dumpUnreadable = true;
+#endif
+
+}   //   readCoredump()
+
+static void clearCoredump()
+{
+  const esp_partition_t *partition = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_COREDUMP, nullptr
+  );
+  if (partition == nullptr)
+  {
+    return;
+  }
+  uint32_t clearBytes = (partition->size < CRASH_CLEAR_BYTES) ? partition->size : CRASH_CLEAR_BYTES;
+  if (esp_partition_erase_range(partition, 0, clearBytes) != ESP_OK)
+  {
+    LOG_WARN("Warning: could not clear the coredump partition.\n");
+  }
+
+}   //   clearCoredump()
+
+#else   //   ARDUINO_ARCH_ESP8266
+
+static const char *resetReasonNames[] =
+{
+  "poweron", "hwwdt", "exception", "softwdt", "software", "deepsleep", "external"
+};
+
+static bool isCrashReset(uint8_t reason)
+{
+  return reason == REASON_WDT_RST || reason == REASON_EXCEPTION_RST || reason == REASON_SOFT_WDT_RST;
+
+}   //   isCrashReset()
+
+#endif
+
+bool crashReportCapture()
+{
+  memset(&summary, 0, sizeof(summary));
+
+#if defined(ARDUINO_ARCH_ESP32)
+  summary.resetReason = (uint8_t)esp_reset_reason();
+  summary.crashed     = isCrashReset(summary.resetReason);
+  readCoredump();
+  if (summary.dumpFound)
+  {
+    //-- the summary is in RAM now; a later crash must find an empty partition
+    clearCoredump();
+  }
+#else
+  const rst_info *info = ESP.getResetInfoPtr();
+  summary.resetReason  = (uint8_t)info->reason;
+  summary.crashed      = isCrashReset(summary.resetReason);
+  if (summary.crashed)
+  {
+    summary.pc           = info->epc1;
+    summary.cause        = info->exccause;
+    summary.address      = info->excvaddr;
+    summary.backtrace[0] = info->epc1;
+    summary.backtrace[1] = info->epc2;
+    summary.backtrace[2] = info->epc3;
+    summary.depth        = 3;
+  }
+#endif
+  return summary.crashed || summary.dumpFound;
+
+}   //   crashReportCapture()
+
+const crashSummary &crashReportGet()
+{
+  return summary;
+
+}   //   crashReportGet()
+
+//-- snprintf at buffer[length], the result is clipped to the buffer
+static size_t appendFormat(char *buffer, size_t bufferSize, size_t length, const char *format, ...)
+{
+  if (length >= bufferSize)
+  {
+    return length;
+  }
+  va_list arguments;
+  va_start(arguments, format);
+  int added = vsnprintf(&buffer[length], bufferSize - length, format, arguments);
+  va_end(arguments);
+  if (added < 0)
+  {
+    return length;
+  }
+  length += (size_t)added;
+  return (length < bufferSize) ? length : bufferSize - 1;
+
+}   //   appendFormat()
+
+size_t crashReportFormat(char *buffer, size_t bufferSize)
+{
+  if (bufferSize == 0)
+  {
+    return 0;
+  }
+  buffer[0] = '\0';
+
+  const uint8_t reasons = sizeof(resetReasonNames) / sizeof(resetReasonNames[0]);
+  size_t length = appendFormat(
+    buffer, bufferSize, 0,
+    "{\"reset\":\"%s\",\"crashed\":%s,\"dump\":%s",
+    (summary.resetReason < reasons) ? resetReasonNames[summary.resetReason] : "unknown",
+    summary.crashed ? "true" : "false",
+    summary.dumpFound ? "true" : "false"
+  );
+
+  if (summary.dumpFound)
+  {
+    length = appendFormat(
+      buffer, bufferSize, length,
+      ",\"bytes\":%u,\"readable\":%s",
+      (unsigned)summary.dumpBytes,
+      summary.dumpUnreadable ? "false" : "true"
+    );
+  }
+  if (summary.pc != 0)
+  {
+    length = appendFormat(
+      buffer, bufferSize, length,
+      ",\"task\":\"%s\",\"pc\":\"0x%08x\",\"cause\":%u,\"addr\":\"0x%08x\",\"elf\":\"%s\",\"bt\":[",
+      summary.task,
+      (unsigned)summary.pc,
+      (unsigned)summary.cause,
+      (unsigned)summary.address,
+      summary.elfSha
+    );
+    for (uint8_t frame = 0; frame < summary.depth; frame++)
+    {
+      length = appendFormat(buffer, bufferSize, length, "%s\"0x%08x\"", frame ? "," : "", (unsigned)summary.backtrace[frame]);
+    }
+    length = appendFormat(buffer, bufferSize, length, "],\"btCorrupt\":%s", summary.backtraceCorrupt ? "true" : "false");
+  }
+
+  return appendFormat(buffer, bufferSize, length, "}");
+
+}   //   crashReportFormat()
+
+void crashReportDump()
+{
+  char buffer[512];
+
+  memcpy(buffer, "CRASH ", 6);
+  size_t length = 6 + crashReportFormat(&buffer[6], sizeof(buffer) - 7);
+  buffer[length++] = '\n';
+
+  //-- longer than LOG_LINE_MAX, so queue it raw (and regardless of LOG_LEVEL)
+  logWriteRaw(buffer, length);
+
+}   //   crashReportDump()
+
+#endif   //   CRASH_REPORT_ENABLED
@@ -0,0 +1,60 @@
+//--- Crash report: reset reason and a compact summary of a stored coredump, read once at boot
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- selected with -DUSE_CRASH_REPORT
+//-- ESP32  : summary of the image in the "coredump" partition (task, PC, backtrace),
+//--          the partition is cleared after it was read
+//-- ESP8266: exception cause and PCs of the last reset (rst_info), there is no coredump
+//-- resolve the PCs with "xtensa-esp32-elf-addr2line -pfiaC -e firmware.elf <pc> ..."
+#if defined(USE_CRASH_REPORT) && (defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266))
+  #define CRASH_REPORT_ENABLED 1
+#else
+  #define CRASH_REPORT_ENABLED 0
+#endif
+
+#if CRASH_REPORT_ENABLED
+
+//-- backtrace frames kept (the coredump summary holds at most 16)
+#ifndef CRASH_MAX_FRAMES
+  #define CRASH_MAX_FRAMES 16
+#endif
+
+struct crashSummary
+{
+  //-- reason of the last reset (esp_reset_reason_t / rst_info.reason)
+  uint8_t  resetReason;
+  //-- the last reset was a panic, an exception or a watchdog
+  bool     crashed;
+  //-- a coredump image was found (it may be older than the last reset)
+  bool     dumpFound;
+  //-- the image was found but the summary could not be read from it
+  bool     dumpUnreadable;
+  uint32_t dumpBytes;
+  char     task[16];
+  uint32_t pc;
+  uint32_t cause;
+  uint32_t address;
+  uint32_t backtrace[CRASH_MAX_FRAMES];
+  uint8_t  depth;
+  bool     backtraceCorrupt;
+  //-- start of the ELF SHA256 of the crashed firmware, to pick the right firmware.elf
+  char     elfSha[9];
+};
+
+//-- read the reset reason and the coredump summary, then clear the coredump
+//-- partition; returns true when there is something to report
+bool crashReportCapture();
+
+//-- the summary of the last crashReportCapture()
+const crashSummary &crashReportGet();
+
+//-- format the summary as one line of compact JSON; returns the length
+size_t crashReportFormat(char *buffer, size_t bufferSize);
+
+//-- log the JSON line prefixed with "CRASH "
+void crashReportDump();
+
+#endif   //   CRASH_REPORT_ENABLED
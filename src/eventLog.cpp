@@ -0,0 +1,381 @@
+//--- Segmented append-only event log on LittleFS: fixed-size CRC records, written per page
+
+#include "eventLog.h"
+#include "logger.h"
+#include "crc32.h"
+#include "fsIndex.h"
+#include "fsUsage.h"
+#include "fsWalker.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const uint16_t pageRecords = EVENT_LOG_PAGE_BYTES / EVENT_LOG_RECORD_BYTES;
+
+static uint32_t recordCrc(const eventRecord &record)
+{
+  return crc32Update(0, (const uint8_t *)&record, offsetof(eventRecord, crc));
+
+}   //   recordCrc()
+
+const char *eventTypeName(uint8_t type)
+{
+  static const char *names[EVENT_TYPE_COUNT] = { "none", "boot", "state", "heap" };
+  return (type < EVENT_TYPE_COUNT) ? names[type] : "?";
+
+}   //   eventTypeName()
+
+bool EventLog::begin(fs::FS &logFileSystem, const char *logDirectory)
+{
+  fileSystem = &logFileSystem;
+  snprintf(directory, sizeof(directory), "%s", logDirectory);
+  pending    = 0;
+
+  if (!fileSystem->exists(directory))
+  {
+    bool created = (index != nullptr) ? index->makeDir(directory) : fileSystem->mkdir(directory);
+    if (!created)
+    {
+      LOG_ERROR("Error: cannot create the event log directory [%s]\n", directory);
+      fileSystem = nullptr;
+      return false;
+    }
+  }
+
+  //-- segment names are their number in hex ("0000002a.log"), the
+  //-- lowest is the oldest; only the directory entries are read
+  fsWalkOptions options;
+  options.maxDepth           = 0;
+  options.filter             = "*.log";
+  options.includeDirectories = false;
+
+  FsWalker    walker;
+  fsWalkEntry entry;
+  bool        found = false;
+
+  oldestSegment = 0;
+  newestSegment = 0;
+  segmentBytes  = 0;
+  if (walker.begin(*fileSystem, directory, options))
+  {
+    while (walker.next(entry))
+    {
+      char    *end     = nullptr;
+      uint32_t segment = (uint32_t)strtoul(entry.name, &end, 16);
+      if (end == entry.name || strcmp(end, ".log") != 0)
+      {
+        continue;
+      }
+      if (!found || segment < oldestSegment)
+      {
+        oldestSegment = segment;
+      }
+      if (!found || segment >= newestSegment)
+      {
+        newestSegment = segment;
+        segmentBytes  = entry.size;
+      }
+      found = true;
+    }
+    walker.end();
+  }
+
+  sequence = 0;
+  eventRecord last;
+  if (found && readTail(&last, 1) == 1)
+  {
+    sequence = last.sequence + 1;
+  }
+
+  //-- a torn last record would misalign every record after it
+  if (segmentBytes % EVENT_LOG_RECORD_BYTES != 0)
+  {
+    LOG_WARN("Warning: event log segment %08x ends in a partial record, starting a new one.\n", (unsigned)newestSegment);
+    startSegment();
+  }
+
+  LOG_INFO(
+    "Info: event log %s: %u segment(s), next record %u\n",
+    directory,
+    (unsigned)segmentCount(),
+    (unsigned)sequence
+  );
+  return true;
+
+}   //   begin()
+
+void EventLog::segmentPath(uint32_t segment, char *path, size_t size) const
+{
+  snprintf(path, size, "%s/%08x.log", directory, (unsigned)segment);
+
+}   //   segmentPath()
+
+bool EventLog::append(eventType type, const void *payload, uint8_t length)
+{
+  if (!isReady())
+  {
+    return false;
+  }
+  if (length > EVENT_LOG_PAYLOAD)
+  {
+    length = EVENT_LOG_PAYLOAD;
+  }
+
+  eventRecord &record = page[pending];
+  memset(&record, 0, sizeof(record));
+  record.timeMs   = millis();
+  record.sequence = sequence++;
+  record.type     = (uint8_t)type;
+  record.length   = length;
+  if (payload != nullptr)
+  {
+    memcpy(record.payload, payload, length);
+  }
+  record.crc = recordCrc(record);
+
+  if (pending == 0)
+  {
+    firstPendingMs = record.timeMs;
+  }
+  pending++;
+  statistics.appended++;
+
+  if (pending >= pageRecords)
+  {
+    return flush();
+  }
+  return true;
+
+}   //   append()
+
+bool EventLog::flush()
+{
+  if (pending == 0 || !isReady())
+  {
+    return true;
+  }
+
+  uint32_t startUs = micros();
+  bool     written = writeRecords(page, pending);
+  pending = 0;
+
+  statistics.lastFlushUs = micros() - startUs;
+  if (statistics.lastFlushUs > statistics.maxFlushUs)
+  {
+    statistics.maxFlushUs = statistics.lastFlushUs;
+  }
+  return written;
+
+}   //   flush()
+
+uint32_t EventLog::flushIfDue()
+{
+  if (pending == 0)
+  {
+    return 0;
+  }
+
+  uint32_t waitedMs = millis() - firstPendingMs;
+  if (waitedMs >= EVENT_LOG_FLUSH_MS)
+  {
+    flush();
+    return 0;
+  }
+  return EVENT_LOG_FLUSH_MS - waitedMs;
+
+}   //   flushIfDue()
+
+bool EventLog::writeRecords(const eventRecord *records, uint16_t count)
+{
+  bool retried = false;
+
+  while (count > 0)
+  {
+    uint32_t room = (EVENT_LOG_SEGMENT_BYTES - segmentBytes) / EVENT_LOG_RECORD_BYTES;
+    if (room == 0)
+    {
+      startSegment();
+      continue;
+    }
+
+    uint16_t step    = (count < room) ? count : (uint16_t)room;
+    size_t   written = appendToSegment(records, step);
+    if (written != (size_t)step * EVENT_LOG_RECORD_BYTES)
+    {
+      uint16_t done = (uint16_t)(written / EVENT_LOG_RECORD_BYTES);
+      records += done;
+      count   -= done;
+      if (retried)
+      {
+        statistics.dropped += count;
+        LOG_WARN("Warning: event log write failed, %u record(s) dropped.\n", (unsigned)count);
+        return false;
+      }
+      //-- most likely the filesystem is full: give up the oldest segment and
+      //-- retry once in a fresh one (a partial write left this one misaligned)
+      removeOldest();
+      startSegment();
+      retried = true;
+      continue;
+    }
+
+    records += step;
+    count   -= step;
+    statistics.pagesWritten++;
+  }
+  return true;
+
+}   //   writeRecords()
+
+size_t EventLog::appendToSegment(const eventRecord *records, uint16_t count)
+{
+  char path[sizeof(directory) + 16];
+  segmentPath(newestSegment, path, sizeof(path));
+
+  const uint8_t *data    = (const uint8_t *)records;
+  size_t         length  = (size_t)count * EVENT_LOG_RECORD_BYTES;
+  size_t         written = 0;
+
+  if (index != nullptr)
+  {
+    written = index->appendFile(path, data, length);
+  }
+  else
+  {
+    File file = fileSystem->open(path, "a");
+    if (file)
+    {
+      written = file.write(data, length);
+      file.close();
+    }
+  }
+
+  segmentBytes            += (uint32_t)written;
+  statistics.bytesWritten += (uint32_t)written;
+  return written;
+
+}   //   appendToSegment()
+
+bool EventLog::needsSpace() const
+{
+  if (usage == nullptr || !usage->isValid())
+  {
+    return false;
+  }
+  size_t reserveBytes = (usage->totalBytes() / 100) * EVENT_LOG_MIN_FREE_PERCENT + EVENT_LOG_SEGMENT_BYTES;
+  return usage->freeBytes() < reserveBytes;
+
+}   //   needsSpace()
+
+void EventLog::startSegment()
+{
+  newestSegment++;
+  segmentBytes = 0;
+  statistics.segmentsStarted++;
+
+  while (newestSegment - oldestSegment + 1 > EVENT_LOG_MAX_SEGMENTS || needsSpace())
+  {
+    if (!removeOldest())
+    {
+      break;
+    }
+  }
+
+}   //   startSegment()
+
+bool EventLog::removeOldest()
+{
+  //-- the segment being written is never removed
+  if (oldestSegment >= newestSegment)
+  {
+    return false;
+  }
+
+  char path[sizeof(directory) + 16];
+  segmentPath(oldestSegment, path, sizeof(path));
+  bool removed = (index != nullptr) ? index->removeFile(path) : fileSystem->remove(path);
+  if (removed)
+  {
+    statistics.segmentsRemoved++;
+  }
+  oldestSegment++;
+  return true;
+
+}   //   removeOldest()
+
+uint16_t EventLog::readTail(eventRecord *records, uint16_t count)
+{
+  if (!isReady() || count == 0)
+  {
+    return 0;
+  }
+
+  //-- records are filled in from the back, newest first
+  uint16_t position = count;
+  uint16_t fromRam  = (pending < count) ? pending : count;
+  memcpy(&records[count - fromRam], &page[pending - fromRam], (size_t)fromRam * EVENT_LOG_RECORD_BYTES);
+  position -= fromRam;
+
+  uint32_t segment = newestSegment;
+  while (position > 0)
+  {
+    char path[sizeof(directory) + 16];
+    segmentPath(segment, path, sizeof(path));
+
+    File file = fileSystem->open(path, "r");
+    if (file)
+    {
+      //-- records start at offset 0, a torn write can only be at the end
+      uint32_t end = (uint32_t)file.size();
+      end -= end % EVENT_LOG_RECORD_BYTES;
+
+      //-- one read per step; another step only when bad records were dropped
+      while (position > 0 && end > 0)
+      {
+        uint32_t available = end / EVENT_LOG_RECORD_BYTES;
+        uint16_t step      = (available < position) ? (uint16_t)available : position;
+        size_t   length    = (size_t)step * EVENT_LOG_RECORD_BYTES;
+
+        end -= (uint32_t)length;
+        if (!file.seek(end) || file.read((uint8_t *)&records[position - step], length) != length)
+        {
+          break;
+        }
+
+        //-- drop bad records, keeping the good ones packed towards the end
+        uint16_t keep = position;
+        for (uint16_t slot = position; slot > position - step; slot--)
+        {
+          eventRecord &candidate = records[slot - 1];
+          if (recordCrc(candidate) != candidate.crc)
+          {
+            statistics.crcErrors++;
+            continue;
+          }
+          keep--;
+          if (keep != slot - 1)
+          {
+            records[keep] = candidate;
+          }
+        }
+        position = keep;
+      }
+      file.close();
+    }
+
+    if (segment == oldestSegment)
+    {
+      break;
+    }
+    segment--;
+  }
+
+  uint16_t found = count - position;
+  if (position > 0)
+  {
+    memmove(records, &records[position], (size_t)found * EVENT_LOG_RECORD_BYTES);
+  }
+  return found;
+
+}   //   readTail()
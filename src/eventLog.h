@@ -0,0 +1,147 @@
+//--- Segmented append-only event log on LittleFS: fixed-size CRC records, written per page
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+class FsIndex;
+class FsUsage;
+
+//-- selected with -DUSE_EVENT_LOG (main.cpp logs boot, state and heap records)
+#if defined(USE_EVENT_LOG)
+  #define EVENT_LOG_ENABLED 1
+#else
+  #define EVENT_LOG_ENABLED 0
+#endif
+
+#ifndef EVENT_LOG_DIR
+  #define EVENT_LOG_DIR "/log"
+#endif
+
+//-- records are collected in RAM and written one page at a time; every
+//-- LittleFS append copies the partly used last block, so fewer is better
+#ifndef EVENT_LOG_PAGE_BYTES
+  #define EVENT_LOG_PAGE_BYTES 256
+#endif
+
+//-- a segment file is closed at this size and the next one is started
+#ifndef EVENT_LOG_SEGMENT_BYTES
+  #define EVENT_LOG_SEGMENT_BYTES 16384
+#endif
+
+//-- the oldest segment is removed when there are more than this ...
+#ifndef EVENT_LOG_MAX_SEGMENTS
+  #define EVENT_LOG_MAX_SEGMENTS 4
+#endif
+
+//-- ... or when a new segment would leave less than this percentage free
+#ifndef EVENT_LOG_MIN_FREE_PERCENT
+  #define EVENT_LOG_MIN_FREE_PERCENT 20
+#endif
+
+//-- records in RAM are written after this long even when the page is not full
+#ifndef EVENT_LOG_FLUSH_MS
+  #define EVENT_LOG_FLUSH_MS 60000
+#endif
+
+#define EVENT_LOG_PAYLOAD 18
+
+enum eventType : uint8_t
+{
+  EVENT_NONE = 0,
+  EVENT_BOOT,
+  EVENT_STATE,
+  EVENT_HEAP,
+  EVENT_TYPE_COUNT
+};
+
+//-- one record on flash, 32 bytes; crc covers everything before it
+struct eventRecord
+{
+  uint32_t timeMs;
+  uint32_t sequence;
+  uint8_t  type;
+  uint8_t  length;
+  uint8_t  payload[EVENT_LOG_PAYLOAD];
+  uint32_t crc;
+};
+
+#define EVENT_LOG_RECORD_BYTES 32
+
+static_assert(sizeof(eventRecord) == EVENT_LOG_RECORD_BYTES, "eventRecord must stay 32 bytes");
+static_assert(EVENT_LOG_PAGE_BYTES % EVENT_LOG_RECORD_BYTES == 0, "EVENT_LOG_PAGE_BYTES must hold whole records");
+static_assert(EVENT_LOG_SEGMENT_BYTES % EVENT_LOG_PAGE_BYTES == 0, "EVENT_LOG_SEGMENT_BYTES must hold whole pages");
+
+struct eventLogStats
+{
+  uint32_t appended;
+  uint32_t pagesWritten;
+  uint32_t bytesWritten;
+  uint32_t segmentsStarted;
+  uint32_t segmentsRemoved;
+  //-- records lost because a write failed (also after a retry in a new segment)
+  uint32_t dropped;
+  //-- records the tail reader skipped for a bad CRC
+  uint32_t crcErrors;
+  uint32_t lastFlushUs;
+  uint32_t maxFlushUs;
+};
+
+class EventLog
+{
+  public:
+    //-- find the segments in directory and continue the newest one
+    bool begin(fs::FS &fileSystem, const char *directory = EVENT_LOG_DIR);
+
+    //-- write through the index wrappers so listing and usage stay correct
+    void setIndex(FsIndex *fileIndex) { index = fileIndex; }
+
+    //-- free space decides when old segments go (see EVENT_LOG_MIN_FREE_PERCENT)
+    void setUsage(FsUsage *usageTracker) { usage = usageTracker; }
+
+    //-- add a record in RAM; a full page is written at once
+    bool append(eventType type, const void *payload, uint8_t length);
+
+    //-- write the records held in RAM
+    bool flush();
+
+    //-- flush when the oldest record in RAM waited EVENT_LOG_FLUSH_MS;
+    //-- returns the ms until the next call is useful (0 when RAM is empty)
+    uint32_t flushIfDue();
+
+    //-- the newest count records (oldest first), RAM included; reads one
+    //-- block from the end of each segment it needs, never a whole file
+    uint16_t readTail(eventRecord *records, uint16_t count);
+
+    bool                 isReady() const        { return fileSystem != nullptr; }
+    uint16_t             pendingCount() const   { return pending; }
+    uint32_t             segmentCount() const   { return isReady() ? newestSegment - oldestSegment + 1 : 0; }
+    uint32_t             nextSequence() const   { return sequence; }
+    const eventLogStats &stats() const          { return statistics; }
+
+  private:
+    void   segmentPath(uint32_t segment, char *path, size_t size) const;
+    bool   writeRecords(const eventRecord *records, uint16_t count);
+    size_t appendToSegment(const eventRecord *records, uint16_t count);
+    void   startSegment();
+    bool   removeOldest();
+    bool   needsSpace() const;
+
+    fs::FS        *fileSystem     = nullptr;
+    FsIndex       *index          = nullptr;
+    FsUsage       *usage          = nullptr;
+    char           directory[24]  = EVENT_LOG_DIR;
+    uint32_t       oldestSegment  = 0;
+    uint32_t       newestSegment  = 0;
+    uint32_t       segmentBytes   = 0;
+    uint32_t       sequence       = 0;
+    eventRecord    page[EVENT_LOG_PAGE_BYTES / EVENT_LOG_RECORD_BYTES];
+    uint16_t       pending        = 0;
+    uint32_t       firstPendingMs = 0;
+    eventLogStats  statistics     = {};
+
+};   //   EventLog
+
+//-- short name of a record type for listings ("boot", "state", ...)
+const char *eventTypeName(uint8_t type);
@@ -0,0 +1,153 @@
+//--- Compile-time LittleFS backend: the per-core differences in one policy type
+
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+#include "boardCaps.h"
+#include "logger.h"
+#include "workSlice.h"
+
+//-- -DUSE_FS_AUTO_FORMAT formats a partition that does not mount. Without it
+//-- the mount is one attempt and a failure leaves the flash as it is: the data
+//-- of a damaged partition survives for a retry, a read-out or an uploadfs
+#if defined(USE_FS_AUTO_FORMAT)
+  #define FS_AUTO_FORMAT_ENABLED 1
+#else
+  #define FS_AUTO_FORMAT_ENABLED 0
+#endif
+
+struct fsSpaceInfo
+{
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockBytes;
+};
+
+//-- LittleFS cache sizes in bytes; all 0 when the core does not tell
+struct fsCacheInfo
+{
+  uint16_t readSize;
+  uint16_t progSize;
+  uint16_t cacheSize;
+  uint16_t lookaheadSize;
+};
+
+//-- the sizes generateBoardProfile.py picked for the board and its partition
+static inline fsCacheInfo fsCacheProfile()
+{
+  fsCacheInfo info;
+  info.readSize      = BOARD_FS_READ_SIZE;
+  info.progSize      = BOARD_FS_PROG_SIZE;
+  info.cacheSize     = BOARD_FS_CACHE_SIZE;
+  info.lookaheadSize = BOARD_FS_LOOKAHEAD;
+  return info;
+
+}   //   fsCacheProfile()
+
+#if defined(ARDUINO_ARCH_ESP32)
+struct Esp32LittleFs
+{
+  //-- with FS_AUTO_FORMAT_ENABLED an unreadable partition is formatted; the
+  //-- format is one blocking call, so it is announced and the watchdog fed first
+  //-- (the flash driver yields between the erased sectors)
+  static inline bool mount()
+  {
+    if (LittleFS.begin(false))
+    {
+      return true;
+    }
+#if FS_AUTO_FORMAT_ENABLED
+    LOG_WARN("Warning: LittleFS mount failed, formatting the partition...\n");
+    workYield();
+    return LittleFS.begin(true);
+#else
+    LOG_WARN("Warning: LittleFS mount failed, the partition is left as it is (-DUSE_FS_AUTO_FORMAT formats it).\n");
+    return false;
+#endif
+  }
+
+  //-- esp_littlefs takes them from the sdkconfig the core's libraries were built with
+  static inline void caches(fsCacheInfo &info)
+  {
+#if defined(CONFIG_LITTLEFS_CACHE_SIZE)
+    info.readSize      = CONFIG_LITTLEFS_READ_SIZE;
+    info.progSize      = CONFIG_LITTLEFS_WRITE_SIZE;
+    info.cacheSize     = CONFIG_LITTLEFS_CACHE_SIZE;
+    info.lookaheadSize = CONFIG_LITTLEFS_LOOKAHEAD_SIZE;
+#else
+    info = fsCacheInfo();
+#endif
+  }
+
+  static inline bool space(fsSpaceInfo &info)
+  {
+    info.totalBytes = LittleFS.totalBytes();
+    info.usedBytes  = LittleFS.usedBytes();
+    //-- the ESP32 LittleFS port uses one flash sector per block
+    info.blockBytes = 4096;
+    return true;
+  }
+
+};   //   Esp32LittleFs
+
+typedef Esp32LittleFs LittleFsBackend;
+
+#elif defined(ARDUINO_ARCH_ESP8266)
+struct Esp8266LittleFs
+{
+  //-- the core formats a partition that does not mount unless told otherwise
+  static inline bool mount()
+  {
+    LittleFSConfig config(FS_AUTO_FORMAT_ENABLED);
+    LittleFS.setConfig(config);
+    if (LittleFS.begin())
+    {
+      return true;
+    }
+#if !FS_AUTO_FORMAT_ENABLED
+    LOG_WARN("Warning: LittleFS mount failed, the partition is left as it is (-DUSE_FS_AUTO_FORMAT formats it).\n");
+#endif
+    return false;
+  }
+
+  //-- fixed in the core's LittleFSImpl, not exposed
+  static inline void caches(fsCacheInfo &info) { info = fsCacheInfo(); }
+
+  static inline bool space(fsSpaceInfo &info)
+  {
+    FSInfo fsInfo;
+    if (!LittleFS.info(fsInfo))
+    {
+      return false;
+    }
+    info.totalBytes = fsInfo.totalBytes;
+    info.usedBytes  = fsInfo.usedBytes;
+    info.blockBytes = fsInfo.blockSize;
+    return true;
+  }
+
+};   //   Esp8266LittleFs
+
+typedef Esp8266LittleFs LittleFsBackend;
+
+#else
+struct GenericLittleFs
+{
+  static inline bool mount() { return LittleFS.begin(FS_AUTO_FORMAT_ENABLED); }
+
+  static inline void caches(fsCacheInfo &info) { info = fsCacheInfo(); }
+
+  static inline bool space(fsSpaceInfo &info)
+  {
+    info.totalBytes = LittleFS.totalBytes();
+    info.usedBytes  = LittleFS.usedBytes();
+    info.blockBytes = 4096;
+    return true;
+  }
+
+};   //   GenericLittleFs
+
+typedef GenericLittleFs LittleFsBackend;
+#endif
@@ -0,0 +1,297 @@
+//--- On-device LittleFS throughput benchmark (built by the *_bench envs)
+
+#include "fsBenchmark.h"
+
+#if defined(FS_BENCHMARK)
+
+#include "logger.h"
+#include "fsWalker.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_partition.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+  #include <flash_hal.h>
+#endif
+
+#include <stdlib.h>
+
+static const size_t   benchBufferSizes[] = { 64, 256, 1024, 4096 };
+static const size_t   BENCH_BUFFER_COUNT = sizeof(benchBufferSizes) / sizeof(benchBufferSizes[0]);
+static const size_t   BENCH_MAX_BUFFER   = 4096;
+static const uint16_t benchFileCounts[]  = { 10, 50, 100, FS_BENCH_MAX_FILES };
+static const size_t   BENCH_COUNT_STEPS  = sizeof(benchFileCounts) / sizeof(benchFileCounts[0]);
+
+static const char    *BENCH_DATA_FILE    = FS_BENCH_DIRECTORY "/data.bin";
+
+struct benchResult
+{
+  const char *test;
+  uint32_t    parameter;
+  uint32_t    rate;
+  const char *unit;
+  bool        failed;
+};
+
+//-- 4 * buffer sizes for seq/rnd read/write, 2 + steps for the file tests
+static benchResult benchResults[4 * BENCH_BUFFER_COUNT + 2 + BENCH_COUNT_STEPS];
+static uint8_t     benchResultCount = 0;
+
+static void addResult(const char *test, uint32_t parameter, uint32_t rate, const char *unit)
+{
+  if (benchResultCount < sizeof(benchResults) / sizeof(benchResults[0]))
+  {
+    benchResults[benchResultCount++] = { test, parameter, rate, unit, false };
+  }
+
+}   //   addResult()
+
+//-- a test that could not complete (short write: partition full or failing) gets no rate
+static void addFailed(const char *test, uint32_t parameter)
+{
+  if (benchResultCount < sizeof(benchResults) / sizeof(benchResults[0]))
+  {
+    benchResults[benchResultCount++] = { test, parameter, 0, "", true };
+  }
+
+}   //   addFailed()
+
+static uint32_t kbPerSecond(uint32_t bytes, uint32_t durationUs)
+{
+  if (durationUs == 0)
+  {
+    durationUs = 1;
+  }
+  return (uint32_t)(((uint64_t)bytes * 1000000ULL) / durationUs / 1024);
+
+}   //   kbPerSecond()
+
+static uint32_t perSecond(uint32_t operations, uint32_t durationUs)
+{
+  if (durationUs == 0)
+  {
+    durationUs = 1;
+  }
+  return (uint32_t)(((uint64_t)operations * 1000000ULL) / durationUs);
+
+}   //   perSecond()
+
+//-- small deterministic generator so every board does the same offsets
+static uint32_t benchRandom(uint32_t &state)
+{
+  state = state * 1664525UL + 1013904223UL;
+  return state >> 8;
+
+}   //   benchRandom()
+
+static void benchSequential(fs::FS &fileSystem, uint8_t *buffer, size_t bufferSize)
+{
+  uint32_t startUs = micros();
+  File     file    = fileSystem.open(BENCH_DATA_FILE, "w");
+  size_t   written = 0;
+  bool     failed  = !file;
+
+  while (!failed && written < FS_BENCH_FILE_SIZE)
+  {
+    size_t done = file.write(buffer, bufferSize);
+    written += done;
+    failed   = (done < bufferSize);
+    yield();
+  }
+  file.close();
+  if (failed)
+  {
+    addFailed("seq write", bufferSize);
+  }
+  else
+  {
+    addResult("seq write", bufferSize, kbPerSecond(written, micros() - startUs), "KB/s");
+  }
+
+  startUs     = micros();
+  file        = fileSystem.open(BENCH_DATA_FILE, "r");
+  size_t read = 0;
+  while (file && read < FS_BENCH_FILE_SIZE)
+  {
+    size_t got = file.read(buffer, bufferSize);
+    if (got == 0)
+    {
+      break;
+    }
+    read += got;
+    yield();
+  }
+  file.close();
+  addResult("seq read", bufferSize, kbPerSecond(read, micros() - startUs), "KB/s");
+
+}   //   benchSequential()
+
+static void benchRandomAccess(fs::FS &fileSystem, uint8_t *buffer, size_t bufferSize)
+{
+  uint32_t state     = 12345;
+  uint32_t positions = FS_BENCH_FILE_SIZE / bufferSize;
+  size_t   bytes     = 0;
+
+  uint32_t startUs = micros();
+  File     file    = fileSystem.open(BENCH_DATA_FILE, "r");
+  for (uint16_t operation = 0; file && operation < FS_BENCH_RANDOM_OPS; operation++)
+  {
+    file.seek((benchRandom(state) % positions) * bufferSize);
+    bytes += file.read(buffer, bufferSize);
+    yield();
+  }
+  file.close();
+  addResult("rnd read", bufferSize, kbPerSecond(bytes, micros() - startUs), "KB/s");
+
+  bytes   = 0;
+  startUs = micros();
+  file    = fileSystem.open(BENCH_DATA_FILE, "r+");
+  bool failed = !file;
+  for (uint16_t operation = 0; !failed && operation < FS_BENCH_RANDOM_OPS; operation++)
+  {
+    file.seek((benchRandom(state) % positions) * bufferSize);
+    size_t done = file.write(buffer, bufferSize);
+    bytes  += done;
+    failed  = (done < bufferSize);
+    yield();
+  }
+  file.close();
+  if (failed)
+  {
+    addFailed("rnd write", bufferSize);
+  }
+  else
+  {
+    addResult("rnd write", bufferSize, kbPerSecond(bytes, micros() - startUs), "KB/s");
+  }
+
+}   //   benchRandomAccess()
+
+static void benchFilePath(char *path, size_t pathSize, uint16_t index)
+{
+  snprintf(path, pathSize, FS_BENCH_DIRECTORY "/f%04u.txt", (unsigned)index);
+
+}   //   benchFilePath()
+
+static bool countEntry(const fsWalkEntry &entry, void *context)
+{
+  (void)entry;
+  (*(uint32_t *)context)++;
+  return true;
+
+}   //   countEntry()
+
+static void benchManyFiles(fs::FS &fileSystem)
+{
+  char     path[32];
+  uint16_t created   = 0;
+  uint32_t createUs  = 0;
+  static const uint8_t payload[32] = { 0 };
+
+  for (uint8_t step = 0; step < BENCH_COUNT_STEPS; step++)
+  {
+    uint32_t startUs = micros();
+    for (; created < benchFileCounts[step]; created++)
+    {
+      benchFilePath(path, sizeof(path), created);
+      File file = fileSystem.open(path, "w");
+      file.write(payload, sizeof(payload));
+      file.close();
+      yield();
+    }
+    createUs += micros() - startUs;
+
+    fsWalkOptions options;
+    uint32_t      entries = 0;
+    startUs = micros();
+    walkFiles(fileSystem, FS_BENCH_DIRECTORY, options, countEntry, &entries);
+    addResult("list ms", entries, (micros() - startUs) / 1000, "ms");
+  }
+  addResult("create", created, perSecond(created, createUs), "files/s");
+
+  uint32_t startUs = micros();
+  for (uint16_t index = 0; index < created; index++)
+  {
+    benchFilePath(path, sizeof(path), index);
+    fileSystem.remove(path);
+    yield();
+  }
+  addResult("delete", created, perSecond(created, micros() - startUs), "files/s");
+
+}   //   benchManyFiles()
+
+static void printPartitionInfo(size_t partitionBytes)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  const esp_partition_t *partition = esp_partition_find_first(
+    ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr
+  );
+  if (partition != nullptr)
+  {
+    LOG_INFO(
+      "Partition: %s @0x%06x size 0x%06x, LittleFS %u bytes\n",
+      partition->label,
+      (unsigned)partition->address,
+      (unsigned)partition->size,
+      (unsigned)partitionBytes
+    );
+    return;
+  }
+#elif defined(ARDUINO_ARCH_ESP8266)
+  LOG_INFO(
+    "Partition: @0x%06x size 0x%06x, LittleFS %u bytes\n",
+    (unsigned)FS_PHYS_ADDR,
+    (unsigned)FS_PHYS_SIZE,
+    (unsigned)partitionBytes
+  );
+  return;
+#endif
+  LOG_INFO("Partition: LittleFS %u bytes\n", (unsigned)partitionBytes);
+
+}   //   printPartitionInfo()
+
+void runFsBenchmark(fs::FS &fileSystem, size_t partitionBytes)
+{
+  uint8_t *buffer = (uint8_t *)malloc(BENCH_MAX_BUFFER);
+  if (buffer == nullptr)
+  {
+    LOG_ERROR("Error: no memory for the benchmark buffer.\n");
+    return;
+  }
+  for (size_t index = 0; index < BENCH_MAX_BUFFER; index++)
+  {
+    buffer[index] = (uint8_t)index;
+  }
+
+  LOG_INFO("Info: running LittleFS benchmark, this takes a while...\n");
+  fileSystem.mkdir(FS_BENCH_DIRECTORY);
+  benchResultCount = 0;
+
+  for (size_t step = 0; step < BENCH_BUFFER_COUNT; step++)
+  {
+    benchSequential(fileSystem, buffer, benchBufferSizes[step]);
+    benchRandomAccess(fileSystem, buffer, benchBufferSizes[step]);
+  }
+  fileSystem.remove(BENCH_DATA_FILE);
+  benchManyFiles(fileSystem);
+  fileSystem.rmdir(FS_BENCH_DIRECTORY);
+  free(buffer);
+
+  LOG_INFO("\n=== LittleFS benchmark (file %u bytes, %u random ops) ===\n",
+           (unsigned)FS_BENCH_FILE_SIZE, (unsigned)FS_BENCH_RANDOM_OPS);
+  printPartitionInfo(partitionBytes);
+  LOG_INFO("%-10s %8s %10s %s\n", "test", "param", "result", "unit");
+  for (uint8_t index = 0; index < benchResultCount; index++)
+  {
+    const benchResult &result = benchResults[index];
+    if (result.failed)
+    {
+      LOG_INFO("%-10s %8u %10s\n", result.test, (unsigned)result.parameter, "failed");
+      continue;
+    }
+    LOG_INFO("%-10s %8u %10u %s\n", result.test, (unsigned)result.parameter, (unsigned)result.rate, result.unit);
+  }
+  LOG_INFO("=== end of benchmark ===\n\n");
+
+}   //   runFsBenchmark()
+
+#endif   //   FS_BENCHMARK
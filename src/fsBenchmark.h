@@ -0,0 +1,34 @@
+//--- On-device LittleFS throughput benchmark (built by the *_bench envs)
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+//-- the benchmark is only compiled into the *_bench envs (-DFS_BENCHMARK)
+#if defined(FS_BENCHMARK)
+
+//-- size of the file used for the sequential and random tests
+#ifndef FS_BENCH_FILE_SIZE
+  #define FS_BENCH_FILE_SIZE (64 * 1024)
+#endif
+
+//-- number of random reads / writes per buffer size
+#ifndef FS_BENCH_RANDOM_OPS
+  #define FS_BENCH_RANDOM_OPS 64
+#endif
+
+//-- largest file count for the create / delete / enumeration tests
+#ifndef FS_BENCH_MAX_FILES
+  #define FS_BENCH_MAX_FILES 200
+#endif
+
+//-- scratch directory, removed again when the benchmark is done
+#ifndef FS_BENCH_DIRECTORY
+  #define FS_BENCH_DIRECTORY "/bench"
+#endif
+
+//-- run all tests on fileSystem (mounted) and print one result table
+void runFsBenchmark(fs::FS &fileSystem, size_t partitionBytes);
+
+#endif   //   FS_BENCHMARK
@@ -0,0 +1,545 @@
+//--- Cached in-RAM index of the LittleFS directory tree
+
+#include "fsIndex.h"
+#include "compressedFile.h"
+#include "logger.h"
+#include "fsWalker.h"
+#include "memoryPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//-- FNV-1a, spreads similar paths ("/log/0001", "/log/0002") over the slots
+static uint32_t pathHash(const char *path)
+{
+  uint32_t hash = 2166136261UL;
+  while (*path != '\0')
+  {
+    hash ^= (uint8_t)*path++;
+    hash *= 16777619UL;
+  }
+  return hash;
+
+}   //   pathHash()
+
+FsIndex::~FsIndex()
+{
+  scanWalker.end();
+  memFree(entries, (size_t)entryCapacity * sizeof(fsIndexEntry));
+  memFree(slots, ((size_t)slotMask + 1) * sizeof(uint16_t));
+#if defined(ARDUINO_ARCH_ESP32)
+  if (mutex != nullptr)
+  {
+    vSemaphoreDelete(mutex);
+  }
+#endif
+
+}   //   ~FsIndex()
+
+void FsIndex::lock() const
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  if (mutex != nullptr)
+  {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+  }
+#endif
+
+}   //   lock()
+
+void FsIndex::unlock() const
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  if (mutex != nullptr)
+  {
+    xSemaphoreGive(mutex);
+  }
+#endif
+
+}   //   unlock()
+
+bool FsIndex::begin(fs::FS &fileSystem, const char *rootPath, uint16_t capacity, bool deferScan)
+{
+  this->fileSystem = &fileSystem;
+  this->rootPath   = rootPath;
+
+#if defined(ARDUINO_ARCH_ESP32)
+  if (mutex == nullptr)
+  {
+    mutex = xSemaphoreCreateMutex();
+  }
+#endif
+
+  if (entries == nullptr)
+  {
+    //-- slot values are positions + 1 in 16 bits
+    if (capacity > 32768)
+    {
+      capacity = 32768;
+    }
+    //-- at least twice as many slots as entries keeps the probe sequences short
+    size_t slotCount = 2;
+    while (slotCount < (size_t)capacity * 2)
+    {
+      slotCount <<= 1;
+    }
+
+    //-- only walked on a rescan or a listing: cold, PSRAM when there is some
+    entries = (fsIndexEntry *)memAllocCold((size_t)capacity * sizeof(fsIndexEntry));
+    slots   = (uint16_t *)memAllocCold(slotCount * sizeof(uint16_t));
+    if (entries == nullptr || slots == nullptr)
+    {
+      LOG_ERROR("Error: no memory for a %u entry file index.\n", (unsigned)capacity);
+      memFree(entries, (size_t)capacity * sizeof(fsIndexEntry));
+      memFree(slots, slotCount * sizeof(uint16_t));
+      entries       = nullptr;
+      slots         = nullptr;
+      entryCapacity = 0;
+      return false;
+    }
+    entryCapacity = capacity;
+    slotMask      = (uint16_t)(slotCount - 1);
+  }
+
+  if (deferScan)
+  {
+    startRescan();
+    return true;
+  }
+  rescan();
+  return true;
+
+}   //   begin()
+
+void FsIndex::invalidate()
+{
+  stale = true;
+
+}   //   invalidate()
+
+bool FsIndex::rescanIfNeeded()
+{
+  if (!stale)
+  {
+    return false;
+  }
+  rescan();
+  return true;
+
+}   //   rescanIfNeeded()
+
+void FsIndex::rescan()
+{
+  if (!startRescan())
+  {
+    return;
+  }
+
+  //-- blocking, but every slice lets the idle task run and feeds the watchdog
+  WorkSlice slice;
+  slice.begin();
+  while (!continueRescan())
+  {
+    workYield();
+    if (slice.progressDue())
+    {
+      LOG_INFO("Info: indexing LittleFS, %u entries so far...\n", (unsigned)entryCount);
+    }
+  }
+
+}   //   rescan()
+
+bool FsIndex::startRescan()
+{
+  if (fileSystem == nullptr || entries == nullptr)
+  {
+    return false;
+  }
+
+  scanWalker.end();
+  lock();
+  entryCount = 0;
+  clearSlots();
+  layoutChanges++;
+  unlock();
+  overflowed = false;
+  //-- cleared at the start: an invalidate() during the walk asks for another one
+  stale      = false;
+  scanning   = scanWalker.begin(*fileSystem, rootPath);
+  return scanning;
+
+}   //   startRescan()
+
+bool FsIndex::continueRescan(uint32_t budgetUs)
+{
+  if (!scanning)
+  {
+    return true;
+  }
+
+  //-- at least one entry per call, then as many as fit in the budget
+  WorkSlice   slice(budgetUs);
+  fsWalkEntry entry;
+  slice.begin();
+  do
+  {
+    if (!scanWalker.next(entry))
+    {
+      if (scanWalker.skippedCount() > 0)
+      {
+        overflowed = true;
+      }
+      scanWalker.end();
+      scanning = false;
+      return true;
+    }
+    //-- locked per entry only, the walk itself reads the flash
+    lock();
+    upsert(entry.path, entry.size, entry.isDirectory);
+    unlock();
+  } while (!slice.isExpired());
+
+  return false;
+
+}   //   continueRescan()
+
+//-- the slot holding path, or the empty slot where it would go
+int FsIndex::slotOf(const char *path) const
+{
+  uint16_t slot = (uint16_t)(pathHash(path) & slotMask);
+  while (slots[slot] != 0 && strcmp(entries[slots[slot] - 1].path, path) != 0)
+  {
+    slot = (slot + 1) & slotMask;
+  }
+  return slot;
+
+}   //   slotOf()
+
+void FsIndex::clearSlots()
+{
+  if (slots != nullptr)
+  {
+    memset(slots, 0, ((size_t)slotMask + 1) * sizeof(uint16_t));
+  }
+
+}   //   clearSlots()
+
+//-- empty a slot and move later members of its probe sequence back into the
+//-- gap (no tombstones, so lookups never get slower after removals)
+void FsIndex::removeSlot(int slot)
+{
+  uint16_t gap     = (uint16_t)slot;
+  uint16_t current = gap;
+  for (;;)
+  {
+    current = (current + 1) & slotMask;
+    if (slots[current] == 0)
+    {
+      break;
+    }
+    uint16_t home = (uint16_t)(pathHash(entries[slots[current] - 1].path) & slotMask);
+    //-- movable when its home slot is not cyclically within (gap, current]
+    if (((current - home) & slotMask) >= ((current - gap) & slotMask))
+    {
+      slots[gap] = slots[current];
+      gap        = current;
+    }
+  }
+  slots[gap] = 0;
+
+}   //   removeSlot()
+
+int FsIndex::indexOf(const char *path) const
+{
+  if (slots == nullptr)
+  {
+    return -1;
+  }
+  uint16_t position = slots[slotOf(path)];
+  return (int)position - 1;
+
+}   //   indexOf()
+
+void FsIndex::upsert(const char *path, uint32_t size, bool isDirectory)
+{
+  if (slots == nullptr)
+  {
+    return;
+  }
+
+  int slot     = slotOf(path);
+  int position = (int)slots[slot] - 1;
+
+  if (position < 0)
+  {
+    if (entryCount >= entryCapacity || strlen(path) >= FS_INDEX_PATH_LEN)
+    {
+      //-- cannot be tracked, printListing() reports the index as incomplete
+      overflowed = true;
+      return;
+    }
+    position = entryCount++;
+    snprintf(entries[position].path, FS_INDEX_PATH_LEN, "%s", path);
+    slots[slot] = (uint16_t)(position + 1);
+  }
+
+  entries[position].size        = size;
+  entries[position].isDirectory = isDirectory;
+
+}   //   upsert()
+
+void FsIndex::erase(const char *path)
+{
+  if (slots == nullptr)
+  {
+    return;
+  }
+  int slot     = slotOf(path);
+  int position = (int)slots[slot] - 1;
+  if (position < 0)
+  {
+    return;
+  }
+  removeSlot(slot);
+  layoutChanges++;
+
+  //-- order is not significant: move the last entry into the hole
+  entryCount--;
+  if ((uint16_t)position != entryCount)
+  {
+    slots[slotOf(entries[entryCount].path)] = (uint16_t)(position + 1);
+    entries[position] = entries[entryCount];
+  }
+
+}   //   erase()
+
+//-- size of a file before it changes: from the index, or from the file itself
+//-- when the index does not hold it (overflowed, path too long, not scanned yet)
+uint32_t FsIndex::sizeOnFlash(const char *path) const
+{
+  {
+    FsIndexLock         guard(*this);
+    const fsIndexEntry *previous = find(path);
+    if (previous != nullptr)
+    {
+      return previous->size;
+    }
+  }
+
+  if (!fileSystem->exists(path))
+  {
+    return 0;
+  }
+  File     file = fileSystem->open(path, "r");
+  uint32_t size = file ? (uint32_t)file.size() : 0;
+  file.close();
+  return size;
+
+}   //   sizeOnFlash()
+
+size_t FsIndex::writeFile(const char *path, const uint8_t *data, size_t length)
+{
+  if (fileSystem == nullptr)
+  {
+    return 0;
+  }
+
+  //-- taken before "w" truncates the file
+  uint32_t oldSize = (usage != nullptr) ? sizeOnFlash(path) : 0;
+
+  File file = fileSystem->open(path, "w");
+  if (!file)
+  {
+    return 0;
+  }
+  size_t written = file.write(data, length);
+  file.close();
+
+  FsIndexLock guard(*this);
+  if (usage != nullptr)
+  {
+    usage->fileResized(oldSize, (uint32_t)written);
+  }
+  upsert(path, (uint32_t)written, false);
+  return written;
+
+}   //   writeFile()
+
+size_t FsIndex::appendFile(const char *path, const uint8_t *data, size_t length)
+{
+  if (fileSystem == nullptr)
+  {
+    return 0;
+  }
+
+  File file = fileSystem->open(path, "a");
+  if (!file)
+  {
+    return 0;
+  }
+  size_t written = file.write(data, length);
+  size_t newSize = file.size();
+  file.close();
+
+  //-- the old size comes from the file, not the index
+  FsIndexLock guard(*this);
+  if (usage != nullptr)
+  {
+    usage->fileResized((uint32_t)(newSize - written), (uint32_t)newSize);
+  }
+  upsert(path, (uint32_t)newSize, false);
+  return written;
+
+}   //   appendFile()
+
+bool FsIndex::removeFile(const char *path)
+{
+  if (fileSystem == nullptr)
+  {
+    return false;
+  }
+
+  uint32_t oldSize = (usage != nullptr) ? sizeOnFlash(path) : 0;
+  if (!fileSystem->remove(path))
+  {
+    return false;
+  }
+
+  FsIndexLock guard(*this);
+  if (usage != nullptr)
+  {
+    usage->fileRemoved(oldSize);
+  }
+  erase(path);
+  return true;
+
+}   //   removeFile()
+
+bool FsIndex::renameFile(const char *fromPath, const char *toPath)
+{
+  if (fileSystem == nullptr || !fileSystem->rename(fromPath, toPath))
+  {
+    return false;
+  }
+
+  FsIndexLock guard(*this);
+  int         position = indexOf(fromPath);
+  if (position < 0)
+  {
+    stale = true;
+    return true;
+  }
+
+  uint32_t size        = entries[position].size;
+  bool     isDirectory = entries[position].isDirectory;
+  erase(fromPath);
+  upsert(toPath, size, isDirectory);
+
+  //-- a renamed directory moves its children as well
+  if (isDirectory)
+  {
+    stale = true;
+  }
+  return true;
+
+}   //   renameFile()
+
+bool FsIndex::makeDir(const char *path)
+{
+  if (fileSystem == nullptr || !fileSystem->mkdir(path))
+  {
+    return false;
+  }
+  FsIndexLock guard(*this);
+  if (usage != nullptr && find(path) == nullptr)
+  {
+    usage->directoryCreated();
+  }
+  upsert(path, 0, true);
+  return true;
+
+}   //   makeDir()
+
+bool FsIndex::removeDir(const char *path)
+{
+  if (fileSystem == nullptr || !fileSystem->rmdir(path))
+  {
+    return false;
+  }
+
+  FsIndexLock guard(*this);
+  if (usage != nullptr)
+  {
+    usage->directoryRemoved();
+  }
+  erase(path);
+  return true;
+
+}   //   removeDir()
+
+uint32_t FsIndex::totalFileBytes() const
+{
+  FsIndexLock guard(*this);
+  uint32_t    totalBytes = 0;
+  for (uint16_t position = 0; position < entryCount; position++)
+  {
+    totalBytes += entries[position].size;
+  }
+  return totalBytes;
+
+}   //   totalFileBytes()
+
+const fsIndexEntry *FsIndex::entry(uint16_t position) const
+{
+  if (position >= entryCount)
+  {
+    return nullptr;
+  }
+  return &entries[position];
+
+}   //   entry()
+
+const fsIndexEntry *FsIndex::find(const char *path) const
+{
+  int position = indexOf(path);
+  return (position < 0) ? nullptr : &entries[position];
+
+}   //   find()
+
+void FsIndex::printListing() const
+{
+  LOG_INFO("\n");
+
+  if (entryCount == 0)
+  {
+    LOG_INFO("Info: No files found.\n");
+  }
+
+  for (uint16_t position = 0; position < entryCount; position++)
+  {
+    //-- a copy taken under the lock: the line of a compressed file reads its header
+    fsIndexEntry current;
+    {
+      FsIndexLock guard(*this);
+      if (position >= entryCount)
+      {
+        break;
+      }
+      current = entries[position];
+    }
+    if (current.isDirectory)
+    {
+      LOG_INFO("DIR : %s\n", current.path);
+    }
+    else if (fileSystem != nullptr)
+    {
+      compressedPrintFileLine(*fileSystem, 0, current.path, current.size);
+    }
+  }
+
+  if (overflowed)
+  {
+    LOG_WARN("Warning: file index full (%u entries), listing is incomplete.\n", (unsigned)entryCapacity);
+  }
+
+}   //   printListing()
@@ -0,0 +1,133 @@
+//--- Cached in-RAM index of the LittleFS directory tree
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "boardCaps.h"
+#include "fsUsage.h"
+#include "fsWalker.h"
+#include "workSlice.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/semphr.h>
+#endif
+
+//-- default number of entries the index can hold (more on boards with PSRAM)
+#ifndef FS_INDEX_MAX_ENTRIES
+  #define FS_INDEX_MAX_ENTRIES BOARD_FS_INDEX_ENTRIES
+#endif
+
+//-- maximum stored path length (including the terminating zero)
+#ifndef FS_INDEX_PATH_LEN
+  #define FS_INDEX_PATH_LEN 64
+#endif
+
+struct fsIndexEntry
+{
+  char     path[FS_INDEX_PATH_LEN];
+  uint32_t size;
+  bool     isDirectory;
+};
+
+class FsIndex
+{
+  public:
+    ~FsIndex();
+
+    //-- allocate the entry table once and build the index from rootPath;
+    //-- with deferScan the walk is only started, see continueRescan()
+    bool begin(fs::FS &fileSystem, const char *rootPath = "/", uint16_t capacity = FS_INDEX_MAX_ENTRIES, bool deferScan = false);
+
+    //-- keep usage up to date from the write wrappers (optional)
+    void setUsage(FsUsage *usageTracker) { usage = usageTracker; }
+
+    //-- request a full rescan on the next rescanIfNeeded()
+    void invalidate();
+
+    //-- rescan only when invalidate() was called (or a write failed to track)
+    //-- returns true when a rescan was done; the walk yields between slices
+    bool rescanIfNeeded();
+
+    //-- resumable rescan for callers that must not block: startRescan(), then
+    //-- continueRescan() until it returns true; lookups see a partial index meanwhile
+    bool startRescan();
+    bool continueRescan(uint32_t budgetUs = WORK_SLICE_BUDGET_US);
+
+    //-- write wrappers: perform the operation and keep the index up to date
+    size_t writeFile(const char *path, const uint8_t *data, size_t length);
+    size_t appendFile(const char *path, const uint8_t *data, size_t length);
+    bool   removeFile(const char *path);
+    bool   renameFile(const char *fromPath, const char *toPath);
+    bool   makeDir(const char *path);
+    bool   removeDir(const char *path);
+
+    uint16_t count() const { return entryCount; }
+    uint16_t capacity() const { return entryCapacity; }
+    bool     isStale() const { return stale; }
+    bool     isScanning() const { return scanning; }
+    bool     isOverflowed() const { return overflowed; }
+    uint32_t totalFileBytes() const;
+
+    //-- the returned entry is only stable while the index is locked (FsIndexLock)
+    //-- when the index can change on another task (RTOS filesystem worker)
+    const fsIndexEntry *entry(uint16_t position) const;
+    const fsIndexEntry *find(const char *path) const;
+
+    //-- changes whenever entries may move (a rescan starts, an entry is removed):
+    //-- a positional walk spread over several calls checks it between them
+    uint32_t layoutVersion() const { return layoutChanges; }
+
+    //-- the rescan and the write wrappers hold the lock for every change; ESP32
+    //-- builds use a FreeRTOS mutex, other targets have a single task
+    void lock() const;
+    void unlock() const;
+
+    //-- print the cached listing; only a compressed (".hs") file is opened, for
+    //-- the logical size in its header (compressedPrintFileLine())
+    void printListing() const;
+
+  private:
+    void rescan();
+    int  indexOf(const char *path) const;
+    int  slotOf(const char *path) const;
+    void clearSlots();
+    void removeSlot(int slot);
+    void upsert(const char *path, uint32_t size, bool isDirectory);
+    void erase(const char *path);
+    uint32_t sizeOnFlash(const char *path) const;
+
+    fs::FS       *fileSystem    = nullptr;
+    FsUsage      *usage         = nullptr;
+    const char   *rootPath      = "/";
+    fsIndexEntry *entries       = nullptr;
+    uint16_t      entryCount    = 0;
+    uint16_t      entryCapacity = 0;
+    //-- open addressing hash of the paths (linear probing, at most half full):
+    //-- entry position + 1 per slot, 0 = empty; makes lookups and upserts O(1)
+    uint16_t     *slots         = nullptr;
+    uint16_t      slotMask      = 0;
+    bool          stale         = true;
+    bool          overflowed    = false;
+    bool          scanning      = false;
+    uint32_t      layoutChanges = 0;
+    FsWalker      scanWalker;
+#if defined(ARDUINO_ARCH_ESP32)
+    SemaphoreHandle_t mutex     = nullptr;
+#endif
+
+};   //   FsIndex
+
+//-- holds the index lock for one scope
+class FsIndexLock
+{
+  public:
+    explicit FsIndexLock(const FsIndex &index) : index(index) { index.lock(); }
+    ~FsIndexLock() { index.unlock(); }
+
+  private:
+    const FsIndex &index;
+
+};   //   FsIndexLock
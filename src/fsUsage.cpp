@@ -0,0 +1,106 @@
+//--- LittleFS usage accounting: measured once, then kept up to date in RAM
+
+#include "fsUsage.h"
+#include "logger.h"
+#include "fsBackend.h"
+
+bool FsUsage::begin()
+{
+  return resync();
+
+}   //   begin()
+
+bool FsUsage::resync()
+{
+  fsSpaceInfo info;
+  if (!LittleFsBackend::space(info))
+  {
+    valid = false;
+    return false;
+  }
+  total     = info.totalBytes;
+  used      = info.usedBytes;
+  blockSize = info.blockBytes;
+
+  if (blockSize == 0)
+  {
+    blockSize = 4096;
+  }
+  valid = true;
+  checkLowWater();
+  return true;
+
+}   //   resync()
+
+size_t FsUsage::blocksFor(uint32_t size) const
+{
+  return (size + blockSize - 1) / blockSize;
+
+}   //   blocksFor()
+
+void FsUsage::addBlocks(int32_t blocks)
+{
+  if (!valid || blocks == 0)
+  {
+    return;
+  }
+
+  int64_t newUsed = (int64_t)used + (int64_t)blocks * (int64_t)blockSize;
+  if (newUsed < 0)
+  {
+    newUsed = 0;
+  }
+  if ((size_t)newUsed > total)
+  {
+    newUsed = total;
+  }
+  used = (size_t)newUsed;
+  checkLowWater();
+
+}   //   addBlocks()
+
+void FsUsage::fileResized(uint32_t oldSize, uint32_t newSize)
+{
+  addBlocks((int32_t)blocksFor(newSize) - (int32_t)blocksFor(oldSize));
+
+}   //   fileResized()
+
+void FsUsage::fileRemoved(uint32_t size)
+{
+  addBlocks(-(int32_t)blocksFor(size));
+
+}   //   fileRemoved()
+
+void FsUsage::directoryCreated()
+{
+  //-- a LittleFS directory occupies a metadata block pair
+  addBlocks(2);
+
+}   //   directoryCreated()
+
+void FsUsage::directoryRemoved()
+{
+  addBlocks(-2);
+
+}   //   directoryRemoved()
+
+void FsUsage::checkLowWater()
+{
+  size_t lowWaterBytes = (total / 100) * FS_LOW_WATER_PERCENT;
+
+  //-- leave the low state only a few blocks above the mark (hysteresis)
+  bool isLowNow = lowWater ? (freeBytes() < lowWaterBytes + 4 * blockSize)
+                           : (freeBytes() < lowWaterBytes);
+
+  //-- warn once when crossing the mark, not on every write below it
+  if (isLowNow && !lowWater)
+  {
+    LOG_WARN(
+      "Warning: LittleFS free space low: %u of %u bytes free.\n",
+      (unsigned)freeBytes(),
+      (unsigned)total
+    );
+  }
+  lowWater = isLowNow;
+
+}   //   checkLowWater()
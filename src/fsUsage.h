@@ -0,0 +1,46 @@
+//--- LittleFS usage accounting: measured once, then kept up to date in RAM
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- warn when free space drops below this percentage of the partition
+#ifndef FS_LOW_WATER_PERCENT
+  #define FS_LOW_WATER_PERCENT 10
+#endif
+
+class FsUsage
+{
+  public:
+    //-- query total/used bytes from LittleFS (the only flash walk)
+    bool begin();
+
+    //-- measure again, e.g. after an index invalidation
+    bool resync();
+
+    //-- bookkeeping from the write wrappers (see FsIndex)
+    void fileResized(uint32_t oldSize, uint32_t newSize);
+    void fileRemoved(uint32_t size);
+    void directoryCreated();
+    void directoryRemoved();
+
+    bool     isValid() const      { return valid; }
+    size_t   totalBytes() const   { return total; }
+    size_t   usedBytes() const    { return used; }
+    size_t   freeBytes() const    { return (used < total) ? total - used : 0; }
+    size_t   blockBytes() const   { return blockSize; }
+    //-- true while free space is below FS_LOW_WATER_PERCENT
+    bool     isLow() const        { return lowWater; }
+
+  private:
+    void   addBlocks(int32_t blocks);
+    void   checkLowWater();
+    size_t blocksFor(uint32_t size) const;
+
+    size_t total     = 0;
+    size_t used      = 0;
+    size_t blockSize = 4096;
+    bool   valid     = false;
+    bool   lowWater  = false;
+
+};   //   FsUsage
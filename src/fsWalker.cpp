@@ -0,0 +1,266 @@
+//--- Recursive, streaming directory walker with bounded memory
+
+#include "fsWalker.h"
+
+#include <string.h>
+
+bool fsGlobMatch(const char *pattern, const char *name)
+{
+  const char *starPattern = nullptr;
+  const char *starName    = nullptr;
+
+  while (*name)
+  {
+    if (*pattern == '*')
+    {
+      starPattern = ++pattern;
+      starName    = name;
+    }
+    else if (*pattern == '?' || *pattern == *name)
+    {
+      pattern++;
+      name++;
+    }
+    else if (starPattern != nullptr)
+    {
+      //-- let the last '*' swallow one more character and retry
+      pattern = starPattern;
+      name    = ++starName;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  while (*pattern == '*')
+  {
+    pattern++;
+  }
+  return (*pattern == '\0');
+
+}   //   fsGlobMatch()
+
+bool FsWalker::begin(fs::FS &fileSystem, const char *rootPath, const fsWalkOptions &options)
+{
+  end();
+
+  this->fileSystem = &fileSystem;
+  this->options    = options;
+  skipped          = 0;
+
+  size_t rootLength = strlen(rootPath);
+  if (rootLength == 0 || rootLength >= FS_WALK_PATH_LEN)
+  {
+    return false;
+  }
+  memcpy(path, rootPath, rootLength + 1);
+
+  //-- "/data/" -> "/data", but keep "/"
+  while (rootLength > 1 && path[rootLength - 1] == '/')
+  {
+    path[--rootLength] = '\0';
+  }
+
+#if defined(ARDUINO_ARCH_ESP8266)
+  levelHandle[0] = fileSystem.openDir(path);
+#else
+  levelHandle[0] = fileSystem.open(path);
+  if (!levelHandle[0] || !levelHandle[0].isDirectory())
+  {
+    levelHandle[0] = File();
+    return false;
+  }
+#endif
+
+  levelLength[0] = (uint16_t)rootLength;
+  depth          = 0;
+  return true;
+
+}   //   begin()
+
+void FsWalker::end()
+{
+  while (depth >= 0)
+  {
+    popDirectory();
+  }
+#if !defined(ARDUINO_ARCH_ESP8266)
+  childHandle = File();
+#endif
+
+}   //   end()
+
+bool FsWalker::readChild(const char *&name, uint32_t &size, bool &isDirectory)
+{
+#if defined(ARDUINO_ARCH_ESP8266)
+  if (!levelHandle[depth].next())
+  {
+    return false;
+  }
+  snprintf(nameBuffer, sizeof(nameBuffer), "%s", levelHandle[depth].fileName().c_str());
+  name        = nameBuffer;
+  isDirectory = levelHandle[depth].isDirectory();
+  size        = isDirectory ? 0 : (uint32_t)levelHandle[depth].fileSize();
+#else
+  childHandle = levelHandle[depth].openNextFile();
+  if (!childHandle)
+  {
+    return false;
+  }
+  name = childHandle.name();
+
+  //-- older ESP32 cores return the full path from File::name()
+  const char *lastSlash = strrchr(name, '/');
+  if (lastSlash != nullptr)
+  {
+    name = lastSlash + 1;
+  }
+  isDirectory = childHandle.isDirectory();
+  size        = isDirectory ? 0 : (uint32_t)childHandle.size();
+#endif
+  return true;
+
+}   //   readChild()
+
+bool FsWalker::pushDirectory()
+{
+#if defined(ARDUINO_ARCH_ESP8266)
+  levelHandle[depth + 1] = fileSystem->openDir(path);
+#else
+  levelHandle[depth + 1] = childHandle;
+  childHandle            = File();
+#endif
+  depth++;
+  levelLength[depth] = (uint16_t)strlen(path);
+  return true;
+
+}   //   pushDirectory()
+
+void FsWalker::popDirectory()
+{
+  if (depth < 0)
+  {
+    return;
+  }
+#if defined(ARDUINO_ARCH_ESP8266)
+  levelHandle[depth] = Dir();
+#else
+  levelHandle[depth].close();
+  levelHandle[depth] = File();
+#endif
+  depth--;
+
+}   //   popDirectory()
+
+bool FsWalker::next(fsWalkEntry &entry)
+{
+  while (depth >= 0)
+  {
+    const char *name;
+    uint32_t    size;
+    bool        isDirectory;
+
+    if (!readChild(name, size, isDirectory))
+    {
+      popDirectory();
+      continue;
+    }
+
+    //-- compose "<directory>/<name>" in place behind the directory path
+    uint16_t baseLength = levelLength[depth];
+    bool     needsSlash = (path[baseLength - 1] != '/');
+    size_t   nameLength = strlen(name);
+
+    if (baseLength + (needsSlash ? 1 : 0) + nameLength + 1 > FS_WALK_PATH_LEN)
+    {
+      skipped++;
+#if !defined(ARDUINO_ARCH_ESP8266)
+      childHandle.close();
+#endif
+      continue;
+    }
+
+    uint16_t nameOffset = baseLength + (needsSlash ? 1 : 0);
+    if (needsSlash)
+    {
+      path[baseLength] = '/';
+    }
+    memmove(&path[nameOffset], name, nameLength + 1);
+
+    uint8_t entryDepth = (uint8_t)depth;
+    bool    report;
+
+    if (isDirectory)
+    {
+      report = options.includeDirectories;
+      if (depth < options.maxDepth && depth + 1 < FS_WALK_MAX_DEPTH)
+      {
+        pushDirectory();
+      }
+      else
+      {
+        if (depth < options.maxDepth)
+        {
+          skipped++;
+        }
+#if !defined(ARDUINO_ARCH_ESP8266)
+        childHandle.close();
+#endif
+      }
+    }
+    else
+    {
+      report = (options.filter == nullptr || fsGlobMatch(options.filter, &path[nameOffset]));
+#if !defined(ARDUINO_ARCH_ESP8266)
+      childHandle.close();
+#endif
+    }
+
+    if (!report)
+    {
+      continue;
+    }
+
+    entry.path        = path;
+    entry.name        = &path[nameOffset];
+    entry.size        = size;
+    entry.depth       = entryDepth;
+    entry.isDirectory = isDirectory;
+    return true;
+  }
+
+  return false;
+
+}   //   next()
+
+uint32_t walkFiles(
+  fs::FS              &fileSystem,
+  const char          *rootPath,
+  const fsWalkOptions &options,
+  fsWalkCallback       callback,
+  void                *context
+)
+{
+  FsWalker    walker;
+  fsWalkEntry entry;
+  uint32_t    reported = 0;
+
+  if (!walker.begin(fileSystem, rootPath, options))
+  {
+    return 0;
+  }
+
+  while (walker.next(entry))
+  {
+    reported++;
+    if (!callback(entry, context))
+    {
+      break;
+    }
+  }
+  walker.end();
+
+  return reported;
+
+}   //   walkFiles()
@@ -0,0 +1,90 @@
+//--- Recursive, streaming directory walker with bounded memory
+
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+
+//-- maximum nesting depth; one directory handle is open per level
+#ifndef FS_WALK_MAX_DEPTH
+  #define FS_WALK_MAX_DEPTH 8
+#endif
+
+//-- size of the single shared path buffer
+#ifndef FS_WALK_PATH_LEN
+  #define FS_WALK_PATH_LEN 128
+#endif
+
+struct fsWalkOptions
+{
+  //-- 0 = only the entries of the start directory
+  uint8_t     maxDepth           = FS_WALK_MAX_DEPTH - 1;
+  //-- glob on the entry name ("*.json", "log_??.txt"), nullptr = everything
+  const char *filter             = nullptr;
+  //-- report directories as entries (they are always descended into)
+  bool        includeDirectories = true;
+};
+
+struct fsWalkEntry
+{
+  //-- full path, only valid until the next call to next()
+  const char *path;
+  //-- name part of path
+  const char *name;
+  uint32_t    size;
+  uint8_t     depth;
+  bool        isDirectory;
+};
+
+//-- return false to stop the walk
+typedef bool (*fsWalkCallback)(const fsWalkEntry &entry, void *context);
+
+class FsWalker
+{
+  public:
+    //-- start a walk at rootPath; returns false if it is not a directory
+    bool begin(fs::FS &fileSystem, const char *rootPath, const fsWalkOptions &options = fsWalkOptions());
+
+    //-- fetch the next matching entry; returns false when the walk is done
+    bool next(fsWalkEntry &entry);
+
+    //-- close all open handles
+    void end();
+
+    bool isActive() const { return depth >= 0; }
+    //-- entries skipped because their path did not fit or depth was exceeded
+    uint16_t skippedCount() const { return skipped; }
+
+  private:
+    bool readChild(const char *&name, uint32_t &size, bool &isDirectory);
+    bool pushDirectory();
+    void popDirectory();
+
+    fs::FS        *fileSystem = nullptr;
+    fsWalkOptions  options;
+    int8_t         depth      = -1;
+    uint16_t       skipped    = 0;
+    char           path[FS_WALK_PATH_LEN];
+    uint16_t       levelLength[FS_WALK_MAX_DEPTH];
+#if defined(ARDUINO_ARCH_ESP8266)
+    Dir            levelHandle[FS_WALK_MAX_DEPTH];
+    char           nameBuffer[FS_WALK_PATH_LEN];
+#else
+    File           levelHandle[FS_WALK_MAX_DEPTH];
+    File           childHandle;
+#endif
+
+};   //   FsWalker
+
+//-- glob match with '*' and '?' (case sensitive)
+bool fsGlobMatch(const char *pattern, const char *name);
+
+//-- walk rootPath and hand every matching entry to callback
+//-- returns the number of entries reported
+uint32_t walkFiles(
+  fs::FS              &fileSystem,
+  const char          *rootPath,
+  const fsWalkOptions &options,
+  fsWalkCallback       callback,
+  void                *context = nullptr
+);
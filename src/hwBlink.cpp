@@ -0,0 +1,193 @@
+//--- LED blinking generated by hardware (LEDC + esp_timer on ESP32, timer1 on ESP8266)
+
+#include "hwBlink.h"
+
+#if HW_BLINK_ENABLED
+
+#include "logger.h"
+
+static uint8_t           blinkPin     = 0;
+static volatile bool     ledOn        = false;
+static volatile uint32_t toggleCount  = 0;
+static volatile uint32_t phaseOnMs    = 1000;
+static volatile uint32_t phaseOffMs   = 1000;
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+#include <esp_timer.h>
+#include <esp_rom_gpio.h>
+#include <soc/gpio_sig_map.h>
+#include <soc/ledc_periph.h>
+
+static esp_timer_handle_t blinkTimer       = nullptr;
+static uint32_t           ledcSignal       = 0;
+static int64_t            nextEdgeUs       = 0;
+static const uint8_t      LEDC_RESOLUTION  = 8;
+
+//-- the LEDC alone could blink: on the classic ESP32 its 20 bit resolution from
+//-- the 80 MHz APB clock goes down to ~0.07 Hz (the S2/S3/C3 stop at 14 bits,
+//-- ~5 Hz). The PWM then makes the blink and cannot dim the LED at the same
+//-- time, so the LEDC runs at HW_BLINK_PWM_FREQ for the brightness and this
+//-- timer makes the edges on every variant.
+//-- runs in the esp_timer task; the edge itself is a single ROM call that
+//-- routes the pin to the LEDC PWM signal (on) or to the low GPIO latch (off)
+static void blinkTimerCallback(void *argument)
+{
+  (void)argument;
+
+  ledOn = !ledOn;
+  esp_rom_gpio_connect_out_signal(blinkPin, ledOn ? ledcSignal : SIG_GPIO_OUT_IDX, false, false);
+  toggleCount = toggleCount + 1;
+
+  //-- absolute edges: the callback latency does not accumulate
+  nextEdgeUs += (int64_t)(ledOn ? phaseOnMs : phaseOffMs) * 1000;
+  int64_t waitUs = nextEdgeUs - esp_timer_get_time();
+  if (waitUs < 50)
+  {
+    waitUs     = 50;
+    nextEdgeUs = esp_timer_get_time() + waitUs;
+  }
+  esp_timer_start_once(blinkTimer, (uint64_t)waitUs);
+
+}   //   blinkTimerCallback()
+
+bool hwBlinkBegin(uint8_t pin, uint32_t onMs, uint32_t offMs, uint8_t brightness)
+{
+  blinkPin = pin;
+  hwBlinkSetPattern(onMs, offMs);
+
+  //-- the GPIO latch stays low, it is what the pin shows while "off"
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  ledcAttachChannel(pin, HW_BLINK_PWM_FREQ, LEDC_RESOLUTION, HW_BLINK_LEDC_CHANNEL);
+#else
+  ledcSetup(HW_BLINK_LEDC_CHANNEL, HW_BLINK_PWM_FREQ, LEDC_RESOLUTION);
+  ledcAttachPin(pin, HW_BLINK_LEDC_CHANNEL);
+#endif
+  hwBlinkSetBrightness(brightness);
+
+  ledcSignal = ledc_periph_signal[HW_BLINK_LEDC_CHANNEL / 8].sig_out0_idx + (HW_BLINK_LEDC_CHANNEL % 8);
+  esp_rom_gpio_connect_out_signal(pin, SIG_GPIO_OUT_IDX, false, false);
+  ledOn = false;
+
+  esp_timer_create_args_t timerArguments = {};
+  timerArguments.callback = blinkTimerCallback;
+  timerArguments.name     = "hwBlink";
+
+  if (esp_timer_create(&timerArguments, &blinkTimer) != ESP_OK)
+  {
+    LOG_ERROR("Error: could not create the blink timer.\n");
+    return false;
+  }
+
+  //-- first edge (switch on) right away
+  nextEdgeUs = esp_timer_get_time() + 1000;
+  esp_timer_start_once(blinkTimer, 1000);
+
+  LOG_INFO("Using LEDC channel %d and esp_timer for the LED on pin %d\n", HW_BLINK_LEDC_CHANNEL, pin);
+  return true;
+
+}   //   hwBlinkBegin()
+
+void hwBlinkSetBrightness(uint8_t brightness)
+{
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+  ledcWrite(blinkPin, brightness);
+#else
+  ledcWrite(HW_BLINK_LEDC_CHANNEL, brightness);
+#endif
+
+}   //   hwBlinkSetBrightness()
+
+#elif defined(ARDUINO_ARCH_ESP8266)
+
+//-- timer1 at 80 MHz / 256 = 312.5 kHz, 23 bit counter (~26 s max)
+static const uint32_t TIMER1_MAX_TICKS = 0x7FFFFF;
+
+static inline uint32_t msToTicks(uint32_t ms)
+{
+  uint64_t ticks = ((uint64_t)ms * 625) / 2;
+  if (ticks > TIMER1_MAX_TICKS)
+  {
+    ticks = TIMER1_MAX_TICKS;
+  }
+  return (ticks < 10) ? 10 : (uint32_t)ticks;
+
+}   //   msToTicks()
+
+static void IRAM_ATTR blinkTimerIsr()
+{
+  ledOn = !ledOn;
+
+  if (blinkPin < 16)
+  {
+    if (ledOn)
+    {
+      GPOS = (1 << blinkPin);
+    }
+    else
+    {
+      GPOC = (1 << blinkPin);
+    }
+  }
+  else
+  {
+    GP16O = ledOn ? 1 : 0;
+  }
+
+  toggleCount = toggleCount + 1;
+  timer1_write(msToTicks(ledOn ? phaseOnMs : phaseOffMs));
+
+}   //   blinkTimerIsr()
+
+bool hwBlinkBegin(uint8_t pin, uint32_t onMs, uint32_t offMs, uint8_t brightness)
+{
+  (void)brightness;
+
+  blinkPin = pin;
+  hwBlinkSetPattern(onMs, offMs);
+  ledOn      = false;
+
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+
+  timer1_attachInterrupt(blinkTimerIsr);
+  timer1_enable(TIM_DIV256, TIM_EDGE, TIM_SINGLE);
+  timer1_write(msToTicks(1));
+
+  LOG_INFO("Using timer1 for the LED on pin %d\n", pin);
+  return true;
+
+}   //   hwBlinkBegin()
+
+void hwBlinkSetBrightness(uint8_t brightness)
+{
+  //-- analogWrite() would need timer1 as well
+  (void)brightness;
+
+}   //   hwBlinkSetBrightness()
+
+#endif
+
+void hwBlinkSetPattern(uint32_t onMs, uint32_t offMs)
+{
+  phaseOnMs  = (onMs == 0) ? 1 : onMs;
+  phaseOffMs = (offMs == 0) ? 1 : offMs;
+
+}   //   hwBlinkSetPattern()
+
+bool hwBlinkIsOn()
+{
+  return ledOn;
+
+}   //   hwBlinkIsOn()
+
+uint32_t hwBlinkToggleCount()
+{
+  return toggleCount;
+
+}   //   hwBlinkToggleCount()
+
+#endif   //   HW_BLINK_ENABLED
@@ -0,0 +1,42 @@
+//--- LED blinking generated by hardware (LEDC + esp_timer on ESP32, timer1 on ESP8266)
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- selected with -DUSE_HW_BLINK next to -DUSE_LED
+#if defined(USE_LED) && defined(USE_HW_BLINK) && (defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266))
+  #define HW_BLINK_ENABLED 1
+#else
+  #define HW_BLINK_ENABLED 0
+#endif
+
+#if HW_BLINK_ENABLED
+
+//-- LED brightness while "on" (0..255), ESP32 only (ESP8266 has no free PWM)
+#ifndef HW_BLINK_BRIGHTNESS
+  #define HW_BLINK_BRIGHTNESS 255
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #ifndef HW_BLINK_LEDC_CHANNEL
+    #define HW_BLINK_LEDC_CHANNEL 0
+  #endif
+  #ifndef HW_BLINK_PWM_FREQ
+    #define HW_BLINK_PWM_FREQ 5000
+  #endif
+#endif
+
+//-- start blinking pin: onMs high (at brightness), offMs low, no CPU in between
+bool hwBlinkBegin(uint8_t pin, uint32_t onMs, uint32_t offMs, uint8_t brightness = HW_BLINK_BRIGHTNESS);
+
+//-- change on/off times, takes effect at the next edge
+void hwBlinkSetPattern(uint32_t onMs, uint32_t offMs);
+
+//-- change the "on" brightness (ignored on ESP8266)
+void hwBlinkSetBrightness(uint8_t brightness);
+
+bool     hwBlinkIsOn();
+uint32_t hwBlinkToggleCount();
+
+#endif   //   HW_BLINK_ENABLED
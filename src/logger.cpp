@@ -0,0 +1,297 @@
+//--- Buffered serial logger: ring buffer, log levels and deferred flushing
+
+#include "logger.h"
+
+#include "memoryPool.h"
+
+#include <atomic>
+#include <stdarg.h>
+
+#if LOG_FLUSH_TASK
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+  #include <freertos/semphr.h>
+#endif
+
+static const uint32_t LOG_MASK = LOG_BUFFER_SIZE - 1;
+
+//-- single-producer/single-consumer ring: head is only written by the
+//-- (serialised) producer side, tail only by the flushing side
+//-- allocated by logBegin() with memAllocCold(); until then messages go straight out
+static char                 *logBuffer = nullptr;
+static std::atomic<uint32_t> logHead(0);
+static std::atomic<uint32_t> logTail(0);
+//-- statistic only; a lost increment under contention is acceptable
+static volatile uint32_t     logDropped = 0;
+
+#if LOG_FLUSH_TASK
+//-- producers on both cores are serialised by this (very short) section
+static portMUX_TYPE      logProducerMux     = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t      logFlushTaskHandle = nullptr;
+//-- without the flush task several tasks drain the ring: one at a time
+static SemaphoreHandle_t logConsumerLock    = nullptr;
+#endif
+
+static inline uint32_t logUsed()
+{
+  return logHead.load(std::memory_order_acquire) - logTail.load(std::memory_order_acquire);
+
+}   //   logUsed()
+
+//-- consumer side: write at most maxBytes of queued data to the UART
+static size_t logDrain(size_t maxBytes)
+{
+  uint32_t tail    = logTail.load(std::memory_order_relaxed);
+  uint32_t used    = logHead.load(std::memory_order_acquire) - tail;
+  size_t   written = 0;
+
+  while (used > 0 && written < maxBytes)
+  {
+    uint32_t offset = tail & LOG_MASK;
+    size_t   chunk  = LOG_BUFFER_SIZE - offset;
+    if (chunk > used)
+    {
+      chunk = used;
+    }
+    if (chunk > maxBytes - written)
+    {
+      chunk = maxBytes - written;
+    }
+
+    Serial.write((const uint8_t *)&logBuffer[offset], chunk);
+
+    tail    += chunk;
+    used    -= chunk;
+    written += chunk;
+    logTail.store(tail, std::memory_order_release);
+  }
+
+  return written;
+
+}   //   logDrain()
+
+//-- logDrain() for every consumer but the flush task; gives up when another
+//-- task is draining and does not finish within waitMs
+static void logDrainShared(size_t maxBytes, uint32_t waitMs)
+{
+#if LOG_FLUSH_TASK
+  if (logConsumerLock != nullptr)
+  {
+    if (xSemaphoreTake(logConsumerLock, pdMS_TO_TICKS(waitMs)) == pdTRUE)
+    {
+      logDrain(maxBytes);
+      xSemaphoreGive(logConsumerLock);
+    }
+    return;
+  }
+#else
+  (void)waitMs;
+#endif
+  logDrain(maxBytes);
+
+}   //   logDrainShared()
+
+#if LOG_FLUSH_TASK
+static void logFlushTask(void *parameter)
+{
+  (void)parameter;
+
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_FLUSH_INTERVAL_MS));
+    logDrain(LOG_BUFFER_SIZE);
+  }
+
+}   //   logFlushTask()
+#endif
+
+void logBegin()
+{
+  if (logBuffer == nullptr)
+  {
+    logBuffer = (char *)memAllocCold(LOG_BUFFER_SIZE);
+  }
+
+#if LOG_FLUSH_TASK
+  if (logFlushTaskHandle != nullptr)
+  {
+    return;
+  }
+  if (logConsumerLock == nullptr)
+  {
+    logConsumerLock = xSemaphoreCreateMutex();
+  }
+  if (xTaskCreatePinnedToCore(logFlushTask, "logFlush", 3072, nullptr, LOG_FLUSH_PRIORITY, &logFlushTaskHandle, 0) != pdPASS)
+  {
+    logFlushTaskHandle = nullptr;
+    Serial.println("Error: could not start log flush task, flushing from loop().");
+  }
+#endif
+
+}   //   logBegin()
+
+//-- producer side: copy length bytes in, or drop the whole message
+static bool logPush(const char *data, size_t length)
+{
+  if (length == 0)
+  {
+    return true;
+  }
+  if (logBuffer == nullptr)
+  {
+    //-- before logBegin() (or without memory): synchronous, as Serial.printf() did
+    Serial.write((const uint8_t *)data, length);
+    return true;
+  }
+  if (length > LOG_BUFFER_SIZE)
+  {
+    length = LOG_BUFFER_SIZE;
+  }
+
+#if LOG_FLUSH_TASK
+  //-- give the flush task a moment to make room, but never wait long; a task
+  //-- above it (the output task) must not block here at all
+  bool     mayWait     = (uxTaskPriorityGet(nullptr) <= LOG_FLUSH_PRIORITY);
+  uint32_t waitStartMs = millis();
+  while (LOG_BUFFER_SIZE - logUsed() < length)
+  {
+    if (!mayWait || millis() - waitStartMs >= LOG_FULL_WAIT_MS)
+    {
+      logDropped = logDropped + 1;
+      return false;
+    }
+    if (logFlushTaskHandle == nullptr)
+    {
+      //-- no flush task: the producer drains, serialised with the other consumers
+      logDrainShared(length, LOG_FULL_WAIT_MS);
+      continue;
+    }
+    xTaskNotifyGive(logFlushTaskHandle);
+    vTaskDelay(1);
+  }
+
+  portENTER_CRITICAL(&logProducerMux);
+  //-- another producer may have taken the room while we were waiting
+  if (LOG_BUFFER_SIZE - logUsed() < length)
+  {
+    portEXIT_CRITICAL(&logProducerMux);
+    logDropped = logDropped + 1;
+    return false;
+  }
+#else
+  //-- no flush task: make room by draining synchronously (the old behaviour)
+  while (LOG_BUFFER_SIZE - logUsed() < length)
+  {
+    logDrain(length);
+  }
+#endif
+
+  uint32_t head   = logHead.load(std::memory_order_relaxed);
+  uint32_t offset = head & LOG_MASK;
+  size_t   first  = LOG_BUFFER_SIZE - offset;
+  if (first > length)
+  {
+    first = length;
+  }
+  memcpy(&logBuffer[offset], data, first);
+  memcpy(&logBuffer[0], data + first, length - first);
+  logHead.store(head + length, std::memory_order_release);
+
+#if LOG_FLUSH_TASK
+  portEXIT_CRITICAL(&logProducerMux);
+#endif
+  return true;
+
+}   //   logPush()
+
+void logWrite(uint8_t level, const char *format, ...)
+{
+  char    line[LOG_LINE_MAX];
+  va_list arguments;
+
+  va_start(arguments, format);
+  int length = vsnprintf(line, sizeof(line), format, arguments);
+  va_end(arguments);
+
+  if (length < 0)
+  {
+    return;
+  }
+  if ((size_t)length >= sizeof(line))
+  {
+    length = sizeof(line) - 1;
+  }
+
+  logPush(line, (size_t)length);
+
+#if LOG_FLUSH_TASK
+  //-- errors and a half full buffer are flushed right away
+  if (logFlushTaskHandle != nullptr && (level <= LOG_LEVEL_ERROR || logUsed() > LOG_BUFFER_SIZE / 2))
+  {
+    xTaskNotifyGive(logFlushTaskHandle);
+  }
+#else
+  (void)level;
+#endif
+
+}   //   logWrite()
+
+void logWriteRaw(const char *data, size_t length)
+{
+  logPush(data, length);
+
+}   //   logWriteRaw()
+
+size_t logFlush()
+{
+#if LOG_FLUSH_TASK
+  if (logFlushTaskHandle != nullptr)
+  {
+    return logUsed();
+  }
+#endif
+
+  int room = Serial.availableForWrite();
+  if (room > 0)
+  {
+    logDrainShared((size_t)room, 0);
+  }
+  return logUsed();
+
+}   //   logFlush()
+
+void logFlushAll()
+{
+#if LOG_FLUSH_TASK
+  //-- the flush task is the only consumer, wait for it to catch up
+  if (logFlushTaskHandle != nullptr)
+  {
+    while (logUsed() > 0)
+    {
+      xTaskNotifyGive(logFlushTaskHandle);
+      vTaskDelay(1);
+    }
+    Serial.flush();
+    return;
+  }
+#endif
+
+  while (logUsed() > 0)
+  {
+    logDrainShared(LOG_BUFFER_SIZE, 1);
+  }
+  Serial.flush();
+
+}   //   logFlushAll()
+
+size_t logPending()
+{
+  return logUsed();
+
+}   //   logPending()
+
+uint32_t logDroppedCount()
+{
+  return logDropped;
+
+}   //   logDroppedCount()
@@ -0,0 +1,102 @@
+//--- Buffered serial logger: ring buffer, log levels and deferred flushing
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "boardCaps.h"
+
+#define LOG_LEVEL_NONE  0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_INFO  3
+#define LOG_LEVEL_DEBUG 4
+
+//-- compile-time filter: calls above this level compile to nothing
+#ifndef LOG_LEVEL
+  #define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+//-- ring buffer size in bytes, must be a power of two (default from the board profile)
+#ifndef LOG_BUFFER_SIZE
+  #define LOG_BUFFER_SIZE BOARD_LOG_BUFFER_SIZE
+#endif
+
+//-- longest single formatted message (longer ones are truncated)
+#ifndef LOG_LINE_MAX
+  #define LOG_LINE_MAX 160
+#endif
+
+//-- ESP32 flushes from a background task, other targets from loop() idle time
+#if defined(ARDUINO_ARCH_ESP32)
+  #define LOG_FLUSH_TASK 1
+#else
+  #define LOG_FLUSH_TASK 0
+#endif
+
+#if LOG_FLUSH_TASK
+  //-- interval the flush task wakes up at when nobody signals it
+  #ifndef LOG_FLUSH_INTERVAL_MS
+    #define LOG_FLUSH_INTERVAL_MS 20
+  #endif
+  //-- how long a producer may wait for room before the message is dropped
+  #ifndef LOG_FULL_WAIT_MS
+    #define LOG_FULL_WAIT_MS 5
+  #endif
+  //-- FreeRTOS priority of the flush task; a producer above it (the output task)
+  //-- never waits for room, its message is dropped instead
+  #ifndef LOG_FLUSH_PRIORITY
+    #define LOG_FLUSH_PRIORITY 1
+  #endif
+#endif
+
+static_assert((LOG_BUFFER_SIZE & (LOG_BUFFER_SIZE - 1)) == 0, "LOG_BUFFER_SIZE must be a power of two");
+
+//-- start the flush task (ESP32); call right after Serial.begin()
+void logBegin();
+
+//-- format and queue a message. With room in the ring it never waits for the
+//-- UART; a full ring is drained synchronously without a flush task (ESP8266),
+//-- on ESP32 the producer waits up to LOG_FULL_WAIT_MS for room and then drops
+//-- the message, a producer above LOG_FLUSH_PRIORITY drops it at once
+void logWrite(uint8_t level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+//-- queue raw bytes, same rules as logWrite()
+void logWriteRaw(const char *data, size_t length);
+
+//-- move queued bytes to the UART without blocking (loop() idle time)
+//-- returns the number of bytes still queued
+size_t logFlush();
+
+//-- drain everything, blocking (before a reset or deep sleep)
+void logFlushAll();
+
+//-- bytes currently queued
+size_t logPending();
+
+//-- messages dropped because the buffer was full
+uint32_t logDroppedCount();
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+  #define LOG_ERROR(...) logWrite(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+  #define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+  #define LOG_WARN(...) logWrite(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+  #define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+  #define LOG_INFO(...) logWrite(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+  #define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+  #define LOG_DEBUG(...) logWrite(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+  #define LOG_DEBUG(...) do {} while (0)
+#endif
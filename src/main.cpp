@@ -4,13 +4,47 @@
 #include <FS.h>
 #include <LittleFS.h>
 
+#include "logger.h"
+#include "boardCaps.h"
+#include "cpuScaling.h"
+#include "taskScheduler.h"
+#include "rtosTasks.h"
+#include "fsIndex.h"
+#include "fsWalker.h"
+#include "compressedFile.h"
+#include "workSlice.h"
+#include "rmtNeoPixel.h"
+#include "pixelEffects.h"
+#include "pixelFrame.h"
+#include "hwBlink.h"
+#include "bootProfile.h"
+#include "runtimeMetrics.h"
+#include "memoryPool.h"
+#include "fsBenchmark.h"
+#include "assetPack.h"
+#include "serialConsole.h"
+#include "outputBackend.h"
+#include "outputMachine.h"
+#include "fsBackend.h"
+#include "sleepMode.h"
+#include "configStore.h"
+#include "otaUpdate.h"
+#include "telemetryServer.h"
+#include "crashReport.h"
+#include "eventLog.h"
+
 const char* PROG_VERSION = "1.2.0";
 
-#ifdef USE_NEOPIXEL
+#if defined(USE_NEOPIXEL) && !NEOPIXEL_RMT_ENABLED
   #include <Adafruit_NeoPixel.h>
 #endif
 
-#ifdef USE_NEOPIXEL
+#if NEOPIXEL_RMT_ENABLED
+RmtNeoPixel neoPixel(
+  NEOPIXEL_COUNT,
+  NEOPIXEL_PIN
+);
+#elif defined(USE_NEOPIXEL)
 Adafruit_NeoPixel neoPixel(
   NEOPIXEL_COUNT,
   NEOPIXEL_PIN,
@@ -18,86 +52,305 @@ Adafruit_NeoPixel neoPixel(
 );
 #endif
 
+//-- optional second strip on its own pin (-DNEOPIXEL2_PIN), refreshed in the same batch
+#if defined(USE_NEOPIXEL) && defined(NEOPIXEL2_PIN)
+  #define NEOPIXEL2_ENABLED 1
+  #ifndef NEOPIXEL2_COUNT
+    #define NEOPIXEL2_COUNT NEOPIXEL_COUNT
+  #endif
+#else
+  #define NEOPIXEL2_ENABLED 0
+#endif
+
+#if NEOPIXEL2_ENABLED && NEOPIXEL_RMT_ENABLED
+  #ifndef NEOPIXEL2_RMT_CHANNEL
+    #define NEOPIXEL2_RMT_CHANNEL RMT_CHANNEL_1
+  #endif
+RmtNeoPixel neoPixel2(
+  NEOPIXEL2_COUNT,
+  NEOPIXEL2_PIN,
+  NEOPIXEL2_RMT_CHANNEL
+);
+#elif NEOPIXEL2_ENABLED
+Adafruit_NeoPixel neoPixel2(
+  NEOPIXEL2_COUNT,
+  NEOPIXEL2_PIN,
+  NEO_GRB + NEO_KHZ800
+);
+#endif
+
+#ifdef USE_NEOPIXEL
+//-- what each strip shows; the batch pushes only the changed pixels
+PixelFrame pixelFrame(NEOPIXEL_COUNT);
+PixelBatch pixelBatch;
+#endif
+#if NEOPIXEL2_ENABLED
+PixelFrame pixelFrame2(NEOPIXEL2_COUNT);
+#endif
+
+//-- the blink outputs of this build, each one a backend type chosen at compile time;
+//-- list more backends in the OutputSet to drive several outputs from one toggle
+#if defined(USE_LED) && !HW_BLINK_ENABLED && defined(USE_LED_LEDC) && defined(ARDUINO_ARCH_ESP32)
+  #ifndef LED_LEDC_CHANNEL
+    #define LED_LEDC_CHANNEL 0
+  #endif
+typedef LedcLedOutput<LED_PIN, LED_LEDC_CHANNEL> ledOutput;
+#elif defined(USE_LED) && !HW_BLINK_ENABLED
+typedef GpioLedOutput<LED_PIN> ledOutput;
+#else
+typedef NoOutput ledOutput;
+#endif
+
+#if NEOPIXEL_RMT_ENABLED && !PIXEL_EFFECTS_ENABLED
+typedef NeoPixelOutput<RmtNeoPixel, neoPixel, pixelFrame> pixelOutput;
+#elif defined(USE_NEOPIXEL) && !PIXEL_EFFECTS_ENABLED
+typedef NeoPixelOutput<Adafruit_NeoPixel, neoPixel, pixelFrame> pixelOutput;
+#else
+typedef NoOutput pixelOutput;
+#endif
+
+#if NEOPIXEL2_ENABLED && NEOPIXEL_RMT_ENABLED && !PIXEL_EFFECTS_ENABLED
+typedef NeoPixelOutput<RmtNeoPixel, neoPixel2, pixelFrame2> pixel2Output;
+#elif NEOPIXEL2_ENABLED && !PIXEL_EFFECTS_ENABLED
+typedef NeoPixelOutput<Adafruit_NeoPixel, neoPixel2, pixelFrame2> pixel2Output;
+#else
+typedef NoOutput pixel2Output;
+#endif
+
+OutputSet<ledOutput, pixelOutput, pixel2Output> outputs;
+bool     outputIsOn        = false;
+uint32_t outputToggleCount = 0;
+
+//-- the blink outputs follow a state machine: the blink tick, console and
+//-- network commands and the button reach it as events (outputMachine.h)
+#define OUTPUT_MACHINE_ENABLED (!HW_BLINK_ENABLED && !PIXEL_EFFECTS_ENABLED)
+#if OUTPUT_MACHINE_ENABLED
+OutputMachine outputMachine;
+#endif
+
+//-- -DOUTPUT_BUTTON_PIN=<pin>: a button to GND toggles (and holds) the output
+#if defined(OUTPUT_BUTTON_PIN) && OUTPUT_MACHINE_ENABLED
+  #define OUTPUT_BUTTON_ENABLED 1
+  #ifndef OUTPUT_BUTTON_DEBOUNCE_MS
+    #define OUTPUT_BUTTON_DEBOUNCE_MS 50
+  #endif
+  //-- single loop scheduler: nothing wakes the loop for a press, it looks this often
+  #ifndef OUTPUT_BUTTON_POLL_MS
+    #define OUTPUT_BUTTON_POLL_MS 10
+  #endif
+#else
+  #define OUTPUT_BUTTON_ENABLED 0
+#endif
+
+#if PIXEL_EFFECTS_ENABLED
+uint8_t      effectFrame[NEOPIXEL_COUNT * 3];
+PixelEffects effects(effectFrame, NEOPIXEL_COUNT);
+#endif
+
 uint32_t delayTime = 2000;
 
-void listFiles(fs::FS &fileSystem, const char *directoryPath)
+//-- "on" colour and brightness; the console only stores them,
+//-- the output context applies them (see applyOutputSettings())
+volatile uint32_t outputColor      = 0x0000FF;
+#ifdef USE_NEOPIXEL
+volatile uint8_t  outputBrightness = 20;
+#else
+volatile uint8_t  outputBrightness = 255;
+#endif
+volatile bool outputSettingsChanged = false;
+
+//-- number of toggles between two LittleFS reports
+const uint32_t REPORT_EVERY_TOGGLES = 11;
+
+//-- longest wait for the serial port at boot (USB CDC without a host)
+const uint32_t SERIAL_READY_TIMEOUT_MS = 200;
+
+//-- interval for the heap watermark samples
+const uint32_t METRICS_HEAP_SAMPLE_MS = 1000;
+
+//-- idle slice while log output is pending (~ one UART FIFO at 115200 baud)
+const uint32_t LOG_IDLE_SLICE_MS = 5;
+
+//-- a console command is assumed to take this long; it waits while that could
+//-- make the toggle later than OUTPUT_MAX_LATE_US
+const uint32_t CONSOLE_HEADROOM_MS = 2;
+
+//-- most a toggle (or effects frame) may be late against its deadline; other work
+//-- is held back while its longest run so far could push the toggle past this
+#ifndef OUTPUT_MAX_LATE_US
+  #define OUTPUT_MAX_LATE_US 1000
+#endif
+
+//-- a due settings write that found no room before the next toggle tries again after this
+const uint32_t CONFIG_ROOM_RETRY_MS = 10;
+
+//-- limits for the "period" console command
+const uint32_t CONSOLE_PERIOD_MIN_MS = 50;
+const uint32_t CONSOLE_PERIOD_MAX_MS = 60000;
+
+TaskScheduler scheduler;
+int toggleTaskId = -1;
+int reportTaskId = -1;
+
+FsIndex fsIndex;
+FsUsage fsUsage;
+bool littleFsMounted = false;
+
+//-- single loop scheduler: an index walk runs one slice per loop pass (fsScanTask),
+//-- short enough that a toggle due meanwhile is late by at most this much
+const uint32_t FS_SCAN_SLICE_US = 2000;
+int       fsScanTaskId  = -1;
+bool      fsScanAtBoot  = false;
+uint32_t  fsScanStartUs = 0;
+WorkSlice fsScanProgress;
+
+ConfigStore  configStore;
+deviceConfig defaultConfig = {};
+int          configTaskId  = -1;
+
+#if OTA_UPDATE_ENABLED
+OtaUpdater otaUpdater;
+//-- the only buffer of an update: one chunk from the UART to the flash
+uint8_t    otaChunk[OTA_CHUNK_SIZE];
+#endif
+
+SerialConsole console;
+//-- next index entry for the paced "ls" listing, UINT16_MAX when idle
+uint16_t consoleListPosition = UINT16_MAX;
+//-- file a running "cat" prints, a chunk per loop like the listing
+CompressedFile consoleCatFile;
+
+#if ASSET_PACK_ENABLED
+AssetPack assetPack;
+#endif
+
+#if TELEMETRY_ENABLED
+TelemetryServer telemetry;
+#endif
+
+#if EVENT_LOG_ENABLED
+EventLog eventLog;
+//-- records the "events" command prints, read with one tail read
+const uint16_t CONSOLE_EVENTS_MAX  = 16;
+uint16_t       consoleEventCount   = 8;
+
+//-- record payloads, little endian like the records themselves
+struct bootEventPayload
+{
+  uint32_t periodMs;
+  uint32_t toggleUs;
+  uint8_t  resetReason;
+};
+
+struct stateEventPayload
+{
+  uint32_t toggleCount;
+  uint32_t periodMs;
+  uint8_t  isOn;
+};
+
+struct heapEventPayload
 {
-  Serial.println();
-#if defined(ARDUINO_ARCH_ESP32)
-  File rootDirectory = fileSystem.open(directoryPath);
+  uint32_t internalFree;
+  uint32_t internalMinFree;
+  uint32_t internalLargest;
+  uint32_t fsFree;
+};
+#endif
 
-  if (!rootDirectory || !rootDirectory.isDirectory())
+//-- print one walker entry, indented by depth
+static bool printFileEntry(const fsWalkEntry &entry, void *context)
+{
+  (void)context;
+  if (entry.isDirectory)
   {
-    Serial.println("Error: Could not open root directory.");
-    return;
+    LOG_INFO("%*sDIR : %s\n", entry.depth * 2, "", entry.path);
   }
-
-  File currentEntry = rootDirectory.openNextFile();
-  if (!currentEntry)
+  else
   {
-    Serial.println("Info: No files found.");
+    compressedPrintFileLine(LittleFS, entry.depth, entry.path, entry.size);
   }
+  return true;
 
-  while (currentEntry)
-  {
-    Serial.printf(
-      "%s%s",
-      currentEntry.isDirectory() ? "DIR : " : "FILE: ",
-      currentEntry.name()
-    );
+}   //   printFileEntry()
 
-    if (!currentEntry.isDirectory())
-    {
-      Serial.printf("\tSIZE: %u\n", (unsigned)currentEntry.size());
-    }
-    else
-    {
-      Serial.println();
-    }
+//-- recursive listing, streamed entry by entry (see fsWalker.h for the limits)
+void listFiles(
+  fs::FS     &fileSystem,
+  const char *directoryPath,
+  uint8_t     maxDepth = FS_WALK_MAX_DEPTH - 1,
+  const char *filter   = nullptr
+)
+{
+#if CPU_SCALING_ENABLED
+  CpuBurst burst;
+#endif
+  LOG_INFO("\n");
+  uint32_t startUs = micros();
+
+  fsWalkOptions options;
+  options.maxDepth = maxDepth;
+  options.filter   = filter;
 
-    currentEntry = rootDirectory.openNextFile();
+  FsWalker    walker;
+  fsWalkEntry entry;
+
+  if (!walker.begin(fileSystem, directoryPath, options))
+  {
+    LOG_ERROR("Error: Could not open root directory.\n");
+    return;
   }
-#elif defined(ARDUINO_ARCH_ESP8266)
-  Dir directory = fileSystem.openDir(directoryPath);
-  bool hasFiles = false;
 
-  while (directory.next())
+  //-- a big tree is walked in slices, each one ends with a yield and a watchdog feed
+  WorkSlice slice;
+  uint32_t  reported = 0;
+  slice.begin();
+  while (walker.next(entry))
   {
-    hasFiles = true;
-    File currentEntry = directory.openFile("r");
+    printFileEntry(entry, nullptr);
+    reported++;
+    slice.pace();
+  }
+  slice.endSlice();
 
-    Serial.printf(
-      "%s%s",
-      currentEntry.isDirectory() ? "DIR : " : "FILE: ",
-      directory.fileName().c_str()
+  if (reported == 0)
+  {
+    LOG_INFO("Info: No files found.\n");
+  }
+  else if (slice.sliceCount() > 1)
+  {
+    LOG_INFO(
+      "Info: %u entries listed in %u ms, %u slices (longest %u us).\n",
+      (unsigned)reported,
+      (unsigned)slice.elapsedMs(),
+      (unsigned)slice.sliceCount(),
+      (unsigned)slice.maxSliceUs()
     );
-
-    if (!currentEntry.isDirectory())
-    {
-      Serial.printf("\tSIZE: %u\n", (unsigned)directory.fileSize());
-    }
-    else
-    {
-      Serial.println();
-    }
   }
-
-  if (!hasFiles)
+  if (walker.skippedCount() > 0)
   {
-    Serial.println("Info: No files found.");
+    LOG_WARN("Warning: %u entries skipped (depth or path length).\n", (unsigned)walker.skippedCount());
   }
-#else
-  Serial.println("Error: Unsupported architecture for file listing.");
-#endif
+
+  metricsFsTime(METRICS_FS_LIST, micros() - startUs);
 
 }   //   listFiles()
 
+//-- usage from the in-RAM accounting (fsUsage.h), measured on flash only after mounting
 void printLittleFsUsage()
 {
-  Serial.println();
-#if defined(ARDUINO_ARCH_ESP32)
-  size_t totalBytes = LittleFS.totalBytes();
-  size_t usedBytes  = LittleFS.usedBytes();
+  LOG_INFO("\n");
+  uint32_t startUs = micros();
+
+  if (!fsUsage.isValid() && !fsUsage.begin())
+  {
+    LOG_ERROR("Error: Unable to read LittleFS usage.\n");
+    return;
+  }
+
+  size_t totalBytes = fsUsage.totalBytes();
+  size_t usedBytes  = fsUsage.usedBytes();
+  metricsFsTime(METRICS_FS_USAGE, micros() - startUs);
 
   float usedPercent = 0.0F;
   if (totalBytes > 0)
@@ -105,128 +358,1602 @@ void printLittleFsUsage()
     usedPercent = (float)usedBytes * 100.0F / (float)totalBytes;
   }
 
-  Serial.printf("LittleFS total bytes: %u\n", (unsigned)totalBytes);
-  Serial.printf("LittleFS used bytes : %u\n", (unsigned)usedBytes);
-  Serial.printf("LittleFS usage      : %.2f%%\n", usedPercent);
-#elif defined(ARDUINO_ARCH_ESP8266)
-  FSInfo fsInfo;
-  if (!LittleFS.info(fsInfo))
+  LOG_INFO("LittleFS total bytes: %u\n", (unsigned)totalBytes);
+  LOG_INFO("LittleFS used bytes : %u\n", (unsigned)usedBytes);
+  LOG_INFO("LittleFS usage      : %.2f%%\n", usedPercent);
+
+  if (fsUsage.isLow())
   {
-    Serial.println("Error: Unable to read LittleFS usage.");
-    return;
+    LOG_WARN("Warning: LittleFS free space is below %d%%.\n", FS_LOW_WATER_PERCENT);
   }
 
-  float usedPercent = 0.0F;
-  if (fsInfo.totalBytes > 0)
+}   //   printLittleFsUsage()
+
+#if PIXEL_EFFECTS_ENABLED
+//-- take a rendered effects frame; refreshPixels() sends what changed
+void showEffectFrame(const uint8_t *rgbFrame, uint16_t pixelCount)
+{
+  pixelFrame.copyFrom(rgbFrame, pixelCount);
+#if NEOPIXEL2_ENABLED
+  //-- the second strip mirrors the first one
+  pixelFrame2.copyFrom(rgbFrame, pixelCount);
+#endif
+
+}   //   showEffectFrame()
+#endif
+
+#if NEOPIXEL_RMT_ENABLED
+//-- send the frames show() postponed while an RMT channel was busy or the strip
+//-- latching; true while one still waits. Runs where the strip is owned: the
+//-- output task (RTOS tasks) or loop()
+bool servicePixelStrips()
+{
+  bool pending = neoPixel.poll();
+#if NEOPIXEL2_ENABLED
+  pending = neoPixel2.poll() || pending;
+#endif
+  return pending;
+
+}   //   servicePixelStrips()
+#endif
+
+//-- one scheduled refresh for every strip: untouched strips are skipped,
+//-- changed ones get their dirty span and are shown together
+void refreshPixels()
+{
+#ifdef USE_NEOPIXEL
+  pixelBatch.refresh();
+#endif
+
+}   //   refreshPixels()
+
+#if OUTPUT_MACHINE_ENABLED
+void printOutputMachine()
+{
+  outputMachineStats machine = outputMachine.stats();
+  LOG_INFO(
+    "Output: %s, %u events (%u changed the state, %u dropped), latency %u us (max %u us)\n",
+    OutputMachine::stateName(outputMachine.state()),
+    (unsigned)machine.processed,
+    (unsigned)machine.transitions,
+    (unsigned)machine.dropped,
+    (unsigned)machine.lastLatencyUs,
+    (unsigned)machine.maxLatencyUs
+  );
+
+}   //   printOutputMachine()
+#endif
+
+//-- lateness of the toggles against their absolute deadlines
+void printOutputTiming()
+{
+#if !HW_BLINK_ENABLED
+  schedulerTiming timing = {};
+#if RTOS_TASKS_ENABLED
+  if (toggleTaskId < 0)
+  {
+    rtosOutputTiming(timing);
+  }
+#endif
+  if (toggleTaskId >= 0)
   {
-    usedPercent = (float)fsInfo.usedBytes * 100.0F / (float)fsInfo.totalBytes;
+    scheduler.timing(toggleTaskId, timing);
+    //-- the tasks that were held back for it
+    schedulerTiming other;
+    for (int taskId = 0; scheduler.timing(taskId, other); taskId++)
+    {
+      if (taskId != toggleTaskId)
+      {
+        timing.deferred += other.deferred;
+      }
+    }
   }
+  LOG_INFO(
+    "Timing: %u runs, late %u us (mean %u us, max %u us), %u over %u us, %u jobs held back\n",
+    (unsigned)timing.runs,
+    (unsigned)timing.lastLateUs,
+    (unsigned)(timing.runs > 0 ? timing.totalLateUs / timing.runs : 0),
+    (unsigned)timing.maxLateUs,
+    (unsigned)timing.overBound,
+    (unsigned)OUTPUT_MAX_LATE_US,
+    (unsigned)timing.deferred
+  );
+#endif
 
-  Serial.printf("LittleFS total bytes: %u\n", (unsigned)fsInfo.totalBytes);
-  Serial.printf("LittleFS used bytes : %u\n", (unsigned)fsInfo.usedBytes);
-  Serial.printf("LittleFS usage      : %.2f%%\n", usedPercent);
-#else
-  Serial.println("Error: Unsupported architecture for LittleFS usage.");
+}   //   printOutputTiming()
+
+//-- statistics of the output modes that do not log every toggle
+void printOutputStats()
+{
+#if SLEEP_MODE_ENABLED
+  sleepReport();
+#endif
+#if CPU_SCALING_ENABLED
+  cpuScalingStats cpu = cpuScalingGetStats();
+  LOG_INFO(
+    "CPU: %u MHz now, %u ms at %u MHz, %u raises, %u lowers\n",
+    (unsigned)cpu.currentMhz,
+    (unsigned)cpu.burstMs,
+    (unsigned)CPU_BURST_MHZ,
+    (unsigned)cpu.raises,
+    (unsigned)cpu.lowers
+  );
+#endif
+#if PIXEL_EFFECTS_ENABLED
+  const effectStats &stats = effects.stats();
+  LOG_INFO(
+    "Effects: frames %u, dropped %u, render %u us (max %u us)\n",
+    (unsigned)stats.framesRendered,
+    (unsigned)stats.framesDropped,
+    (unsigned)stats.lastRenderUs,
+    (unsigned)stats.maxRenderUs
+  );
+#endif
+#ifdef USE_NEOPIXEL
+  const pixelBatchStats &pixels = pixelBatch.stats();
+  LOG_INFO(
+    "Pixels: refreshes %u (nothing changed %u), shows %u, pixels sent %u, refresh %u us (max %u us)\n",
+    (unsigned)pixels.refreshes,
+    (unsigned)pixels.skippedRefreshes,
+    (unsigned)pixels.shows,
+    (unsigned)pixels.pixelsPushed,
+    (unsigned)pixels.lastRefreshUs,
+    (unsigned)pixels.maxRefreshUs
+  );
+#endif
+#if OUTPUT_MACHINE_ENABLED
+  printOutputMachine();
+#endif
+  printOutputTiming();
+#if HW_BLINK_ENABLED
+  LOG_INFO(
+    "LED is %s (%u hardware toggles)\n",
+    hwBlinkIsOn() ? "ON" : "OFF",
+    (unsigned)hwBlinkToggleCount()
+  );
 #endif
 
-}   //   printLittleFsUsage()
+}   //   printOutputStats()
+
+//-- one log line per output after a toggle
+void logOutputState(const char *name, bool isOn)
+{
+  LOG_INFO("%s is %s\n", name, isOn ? "ON" : "OFF");
+
+}   //   logOutputState()
+
+#if OUTPUT_MACHINE_ENABLED
+//-- the state machine's writer: called when the level of the outputs changes
+void writeOutputs(bool isOn, void *context)
+{
+  (void)context;
+  outputIsOn = isOn;
+  outputToggleCount++;
+  outputs.write(outputIsOn);
+  outputs.forEachState(logOutputState);
+
+}   //   writeOutputs()
+
+//-- (re)start the state machine at the level the outputs show now
+void beginOutputMachine()
+{
+  outputMachine.begin(writeOutputs, nullptr, outputIsOn ? OUTPUT_BLINK_ON : OUTPUT_BLINK_OFF);
+
+}   //   beginOutputMachine()
+
+//-- queued events, handled in the context that owns the outputs
+void serviceOutputEvents()
+{
+  if (outputMachine.process() > 0)
+  {
+    refreshPixels();
+  }
+
+}   //   serviceOutputEvents()
+
+//-- console and network commands, both posted from the loop task
+bool postOutputCommand(const char *command)
+{
+  outputEvent event;
+  return OutputMachine::parseEvent(command, event) && outputMachine.post(OUTPUT_SOURCE_TASK, event);
+
+}   //   postOutputCommand()
+#endif
+
+#if OUTPUT_BUTTON_ENABLED
+//-- in IRAM like post(); a bouncing contact gives one event per press
+void IRAM_ATTR outputButtonIsr()
+{
+  static uint32_t lastPressUs = 0;
+  uint32_t        nowUs       = micros();
+
+  if (nowUs - lastPressUs < OUTPUT_BUTTON_DEBOUNCE_MS * 1000UL)
+  {
+    return;
+  }
+  lastPressUs = nowUs;
+  outputMachine.post(OUTPUT_SOURCE_ISR, OUTPUT_EVENT_TOGGLE);
+
+}   //   outputButtonIsr()
+#endif
+
+void toggleOutput()
+{
+#if OUTPUT_MACHINE_ENABLED
+  //-- events queued before the tick go first, the tick sees the state they left
+  outputMachine.process();
+  outputMachine.dispatch(OUTPUT_EVENT_TICK);
+#endif
+
+}   //   toggleOutput()
 
 void initOutput()
 {
-#ifdef USE_LED
-  pinMode(LED_PIN, OUTPUT);
-  digitalWrite(LED_PIN, LOW);
-  Serial.printf("Using LED on pin %d\n", LED_PIN);
+  outputs.begin();
+  outputs.setColor(outputColor);
+  outputs.setBrightness(outputBrightness);
+
+#if HW_BLINK_ENABLED
+  hwBlinkBegin(LED_PIN, delayTime, delayTime, outputBrightness);
+#elif defined(USE_LED) && defined(USE_LED_LEDC) && defined(ARDUINO_ARCH_ESP32)
+  LOG_INFO("Using LED on pin %d (LEDC channel %d)\n", LED_PIN, LED_LEDC_CHANNEL);
+#elif defined(USE_LED)
+  LOG_INFO("Using LED on pin %d\n", LED_PIN);
 #endif
 
 #ifdef USE_NEOPIXEL
+#if PIXEL_EFFECTS_ENABLED
+  //-- the effects engine owns the strip, it is not one of the blink outputs
   neoPixel.begin();
-  neoPixel.setBrightness(20);
+  neoPixel.setBrightness(outputBrightness);
   neoPixel.clear();
   neoPixel.show();
-  Serial.printf("Using NeoPixel on pin %d\n", NEOPIXEL_PIN);
+  pixelFrame.begin();
+  pixelFrame.markClean();
+#if NEOPIXEL2_ENABLED
+  neoPixel2.begin();
+  neoPixel2.setBrightness(outputBrightness);
+  neoPixel2.clear();
+  neoPixel2.show();
+  pixelFrame2.begin();
+  pixelFrame2.markClean();
+#endif
+
+  effectConfig config;
+  config.type     = EFFECT_BREATHE;
+  config.colorA   = outputColor;
+  config.periodMs = (uint16_t)delayTime;
+  effects.setTargetFps(EFFECTS_TARGET_FPS);
+  effects.setEffect(config);
+  effects.setOutput(showEffectFrame);
+#endif
+
+  pixelBatch.attach(pixelFrame, neoPixel);
+#if NEOPIXEL_RMT_ENABLED
+  LOG_INFO("Using NeoPixel on pin %d (RMT channel %d)\n", NEOPIXEL_PIN, (int)NEOPIXEL_RMT_CHANNEL);
+#else
+  LOG_INFO("Using NeoPixel on pin %d\n", NEOPIXEL_PIN);
+#endif
+#if NEOPIXEL2_ENABLED
+  pixelBatch.attach(pixelFrame2, neoPixel2);
+#if NEOPIXEL_RMT_ENABLED
+  LOG_INFO("Using NeoPixel on pin %d (RMT channel %d)\n", NEOPIXEL2_PIN, (int)NEOPIXEL2_RMT_CHANNEL);
+#else
+  LOG_INFO("Using NeoPixel on pin %d\n", NEOPIXEL2_PIN);
+#endif
+#endif
+#endif
+
+#if OUTPUT_MACHINE_ENABLED
+  beginOutputMachine();
+#endif
+#if OUTPUT_BUTTON_ENABLED
+  pinMode(OUTPUT_BUTTON_PIN, INPUT_PULLUP);
+  attachInterrupt(digitalPinToInterrupt(OUTPUT_BUTTON_PIN), outputButtonIsr, FALLING);
+  LOG_INFO("Using button on pin %d\n", OUTPUT_BUTTON_PIN);
 #endif
 
 }   //   initOutput()
 
-void toggleOutput()
+uint32_t outputPeriodMs()
 {
-#ifdef USE_LED
-  digitalWrite(LED_PIN, !digitalRead(LED_PIN));
-  Serial.printf(
-    "LED is %s\n",
-    digitalRead(LED_PIN) ? "ON" : "OFF"
-  );
+#if PIXEL_EFFECTS_ENABLED
+  return effects.framePeriodMs();
+#else
+  return delayTime;
 #endif
 
-#ifdef USE_NEOPIXEL
-  static bool isOn = false;
+}   //   outputPeriodMs()
 
-  if (isOn)
-  {
-    neoPixel.clear();
-    Serial.println("NeoPixel is OFF");
-  }
-  else
+//-- take over console changes in the context that owns the strip
+void applyOutputSettings()
+{
+  outputSettingsChanged = false;
+
+  outputs.setColor(outputColor);
+  outputs.setBrightness(outputBrightness);
+#if HW_BLINK_ENABLED
+  hwBlinkSetBrightness(outputBrightness);
+#endif
+#if PIXEL_EFFECTS_ENABLED
+  neoPixel.setBrightness(outputBrightness);
+  pixelFrame.markAllDirty();
+#if NEOPIXEL2_ENABLED
+  neoPixel2.setBrightness(outputBrightness);
+  pixelFrame2.markAllDirty();
+#endif
+  effectConfig config = effects.getEffect();
+  config.colorA   = outputColor;
+  config.periodMs = (uint16_t)delayTime;
+  effects.setEffect(config);
+#endif
+
+}   //   applyOutputSettings()
+
+//-- the periodic output job: a blink toggle or one effects frame
+void runOutput()
+{
+  if (outputSettingsChanged)
   {
-    neoPixel.setPixelColor(0, neoPixel.Color(0, 0, 255));
-    Serial.println("NeoPixel is ON");
+    applyOutputSettings();
   }
+  metricsOutputTick(outputPeriodMs());
 
-  neoPixel.show();
-  isOn = !isOn;
+#if PIXEL_EFFECTS_ENABLED
+  effects.renderFrame(millis());
+#else
+  toggleOutput();
 #endif
+  refreshPixels();
 
-}   //   toggleOutput()
+}   //   runOutput()
 
-void initLittleFs()
+//-- follow a changed delayTime in whichever mode drives the output
+void applyOutputPeriod()
 {
-  Serial.println("\n\nInitializing LittleFS...");
-#if defined(ARDUINO_ARCH_ESP32)
-  if (!LittleFS.begin(true))
-#elif defined(ARDUINO_ARCH_ESP8266)
-  if (!LittleFS.begin())
+#if HW_BLINK_ENABLED
+  hwBlinkSetPattern(delayTime, delayTime);
 #else
-  if (!LittleFS.begin())
+  scheduler.setPeriod(toggleTaskId, outputPeriodMs());
+#if RTOS_TASKS_ENABLED
+  setRtosOutputPeriod(outputPeriodMs());
+#endif
 #endif
+
+}   //   applyOutputPeriod()
+
+//-- the persistent settings as they are in use right now
+deviceConfig currentConfig()
+{
+  deviceConfig config = {};
+  config.delayTime  = delayTime;
+  config.color      = outputColor;
+  config.brightness = outputBrightness;
+  return config;
+
+}   //   currentConfig()
+
+//-- copy settings into the variables the output reads (those stay plain globals)
+void applyConfig(const deviceConfig &config)
+{
+  if (config.delayTime >= CONSOLE_PERIOD_MIN_MS && config.delayTime <= CONSOLE_PERIOD_MAX_MS)
   {
-    Serial.println("Error: LittleFS initialization failed.");
-    delayTime = 1000;
-    return;
+    delayTime = config.delayTime;
   }
+  outputColor           = config.color;
+  outputBrightness      = config.brightness;
+  outputSettingsChanged = true;
 
-  Serial.println("Info: LittleFS initialization OK.");
-  printLittleFsUsage();
-  listFiles(LittleFS, "/");
+}   //   applyConfig()
+
+//-- read the stored settings; the compiled-in values are the defaults
+void loadConfig()
+{
+  defaultConfig = currentConfig();
+  if (configStore.begin(defaultConfig))
+  {
+    applyConfig(configStore.get());
+  }
 
-  Serial.println("\n");
+}   //   loadConfig()
 
-}   //   initLittleFs()
+//-- true while flash work of flashUs started now cannot make a toggle later than
+//-- OUTPUT_MAX_LATE_US; work longer than the period goes right after a toggle
+bool outputHasRoomFor(uint32_t flashUs)
+{
+  uint32_t periodUs = delayTime * 1000UL;
+  if (flashUs > periodUs)
+  {
+    flashUs = periodUs;
+  }
+#if RTOS_TASKS_ENABLED
+  return rtosOutputHasRoomFor(flashUs);
+#else
+  return scheduler.hasRoomFor(flashUs);
+#endif
 
-void setup()
+}   //   outputHasRoomFor()
+
+//-- scheduler task: write the settings once they have settled
+void configTask()
 {
-  Serial.begin(115200);
-  delay(200);
+  //-- the commit may erase a flash sector, it waits for a gap between two toggles
+  if (configStore.isDue() && !outputHasRoomFor(configStore.maxCommitUs()))
+  {
+    scheduler.trigger(configTaskId, CONFIG_ROOM_RETRY_MS);
+    return;
+  }
 
-  Serial.printf("Program version: %s\n", PROG_VERSION);
+  uint32_t waitMs = configStore.commitIfDue();
+  if (waitMs > 0)
+  {
+    scheduler.trigger(configTaskId, waitMs);
+  }
 
-  initOutput();
-  initLittleFs();
+}   //   configTask()
 
-}   //   setup()
+//-- a setting was changed at runtime: keep it in RAM, (re)arm the lazy write
+void configChanged()
+{
+  uint32_t waitMs = configStore.update(currentConfig());
+  if (waitMs > 0)
+  {
+    scheduler.trigger(configTaskId, waitMs);
+  }
 
-void loop()
+}   //   configChanged()
+
+//-- the LittleFS caches of the core next to the ones the board profile picked
+void printFsCaches()
 {
-  static int count = 5;
-  toggleOutput();
-  delay(delayTime);
-  if (count > 10)
+  fsCacheInfo used;
+  fsCacheInfo profile = fsCacheProfile();
+  LittleFsBackend::caches(used);
+
+  if (BOARD_FS_BYTES > 0)
+  {
+    LOG_INFO("LittleFS partition: %lu KB (board profile)\n", (unsigned long)(BOARD_FS_BYTES / 1024));
+  }
+
+  if (used.cacheSize == 0)
   {
-    initLittleFs();
-    count = 0;
-    delay(delayTime/2);
+    LOG_INFO(
+      "LittleFS caches: set by the core (board profile: read %u, prog %u, cache %u, lookahead %u)\n",
+      (unsigned)profile.readSize,
+      (unsigned)profile.progSize,
+      (unsigned)profile.cacheSize,
+      (unsigned)profile.lookaheadSize
+    );
     return;
   }
-  count++;
+  LOG_INFO(
+    "LittleFS caches: read %u, prog %u, cache %u, lookahead %u\n",
+    (unsigned)used.readSize,
+    (unsigned)used.progSize,
+    (unsigned)used.cacheSize,
+    (unsigned)used.lookaheadSize
+  );
+  if (used.cacheSize != profile.cacheSize || used.lookaheadSize != profile.lookaheadSize
+      || used.readSize != profile.readSize || used.progSize != profile.progSize)
+  {
+    LOG_INFO(
+      "Info: the board profile picks read %u, prog %u, cache %u, lookahead %u (see the note in platformio.ini).\n",
+      (unsigned)profile.readSize,
+      (unsigned)profile.progSize,
+      (unsigned)profile.cacheSize,
+      (unsigned)profile.lookaheadSize
+    );
+  }
+
+}   //   printFsCaches()
+
+//-- mount LittleFS once; the index and the listing follow in completeLittleFsInit()
+bool initLittleFs()
+{
+  LOG_INFO("\n\nInitializing LittleFS...\n");
+  uint32_t startUs = micros();
+  bool mounted = LittleFsBackend::mount();
+  uint32_t mountUs = micros() - startUs;
+  metricsFsTime(METRICS_FS_MOUNT, mountUs);
+
+  if (!mounted)
+  {
+    LOG_ERROR("Error: LittleFS initialization failed.\n");
+    delayTime = 1000;
+    return false;
+  }
+
+  littleFsMounted = true;
+  LOG_INFO(
+    "Info: LittleFS initialization OK, mounted in %u.%03u ms.\n",
+    (unsigned)(mountUs / 1000),
+    (unsigned)(mountUs % 1000)
+  );
+  printFsCaches();
+  return true;
+
+}   //   initLittleFs()
+
+#if EVENT_LOG_ENABLED
+//-- one record per boot, then the records of the periodic report
+void logBootEvent()
+{
+  bootEventPayload payload = {};
+  payload.periodMs = delayTime;
+  payload.toggleUs = bootStageUs("toggle");
+#if CRASH_REPORT_ENABLED
+  payload.resetReason = crashReportGet().resetReason;
+#endif
+  eventLog.append(EVENT_BOOT, &payload, sizeof(payload));
+
+}   //   logBootEvent()
+
+void logReportEvents()
+{
+  stateEventPayload state = {};
+  state.toggleCount = outputToggleCount;
+  state.periodMs    = delayTime;
+  state.isOn        = outputIsOn ? 1 : 0;
+  eventLog.append(EVENT_STATE, &state, sizeof(state));
+
+  memoryStats      memory;
+  heapEventPayload heap = {};
+  memGetStats(memory);
+  heap.internalFree    = memory.internalFree;
+  heap.internalMinFree = memory.internalMinFree;
+  heap.internalLargest = memory.internalLargest;
+  heap.fsFree          = fsUsage.isValid() ? (uint32_t)fsUsage.freeBytes() : 0;
+  eventLog.append(EVENT_HEAP, &heap, sizeof(heap));
+
+  //-- a page is written when it is full, or here once it waited too long
+  eventLog.flushIfDue();
+
+}   //   logReportEvents()
+
+void printEvents(uint16_t count)
+{
+  static eventRecord records[CONSOLE_EVENTS_MAX];
+#if CPU_SCALING_ENABLED
+  CpuBurst           burst;
+#endif
+
+  if (!eventLog.isReady())
+  {
+    LOG_WARN("Warning: the event log is not open.\n");
+    return;
+  }
+  uint16_t found = eventLog.readTail(records, (count < CONSOLE_EVENTS_MAX) ? count : CONSOLE_EVENTS_MAX);
+  for (uint16_t position = 0; position < found; position++)
+  {
+    const eventRecord &record = records[position];
+    uint32_t           values[4] = {};
+    memcpy(values, record.payload, (record.length < sizeof(values)) ? record.length : sizeof(values));
+    LOG_INFO(
+      "Event %u at %u ms: %-5s %u %u %u %u\n",
+      (unsigned)record.sequence,
+      (unsigned)record.timeMs,
+      eventTypeName(record.type),
+      (unsigned)values[0],
+      (unsigned)values[1],
+      (unsigned)values[2],
+      (unsigned)values[3]
+    );
+  }
+  const eventLogStats &stats = eventLog.stats();
+  LOG_INFO(
+    "Info: %u event(s) shown, %u segment(s), %u pages written, %u dropped, flush max %u us\n",
+    (unsigned)found,
+    (unsigned)eventLog.segmentCount(),
+    (unsigned)stats.pagesWritten,
+    (unsigned)stats.dropped,
+    (unsigned)stats.maxFlushUs
+  );
+
+}   //   printEvents()
+#endif
+
+//-- second half of the start-up, once the index is complete
+void finishLittleFsInit()
+{
+  if (littleFsMounted)
+  {
+    metricsFsTime(METRICS_FS_INDEX, micros() - fsScanStartUs);
+    bootMark("index");
+    printLittleFsUsage();
+    fsIndex.printListing();
+    bootMark("listing");
+
+    LOG_INFO("\n\n");
+  }
+
+#if ASSET_PACK_ENABLED
+  //-- the pack lives outside LittleFS, mapping it only touches the MMU
+  if (!assetPack.isMapped() && assetPack.begin())
+  {
+    assetPack.printListing();
+    bootMark("assets");
+  }
+#endif
+
+  bootReport();
+
+}   //   finishLittleFsInit()
+
+//-- hand a started index walk to fsScanTask(); false when there is no such
+//-- task (RTOS worker), the caller then walks at once (paced, see FsIndex::rescan())
+bool scheduleIndexScan(bool atBoot)
+{
+  if (fsScanTaskId < 0 || !fsIndex.isScanning())
+  {
+    return false;
+  }
+  fsScanAtBoot = atBoot;
+  fsScanProgress.begin();
+  scheduler.trigger(fsScanTaskId, 0);
+  return true;
+
+}   //   scheduleIndexScan()
+
+//-- scheduler task: one slice of the index walk, re-armed until it is done
+void fsScanTask()
+{
+  if (!fsIndex.continueRescan(FS_SCAN_SLICE_US))
+  {
+    if (fsScanProgress.progressDue())
+    {
+      LOG_INFO("Info: indexing LittleFS, %u entries so far...\n", (unsigned)fsIndex.count());
+    }
+    scheduler.trigger(fsScanTaskId, 0);
+    return;
+  }
+
+  if (fsScanAtBoot)
+  {
+    fsScanAtBoot = false;
+    finishLittleFsInit();
+    return;
+  }
+  fsUsage.resync();
+  metricsFsTime(METRICS_FS_INDEX, micros() - fsScanStartUs);
+  LOG_INFO("Info: LittleFS index rebuilt, %u entries.\n", (unsigned)fsIndex.count());
+
+}   //   fsScanTask()
+
+//-- non-critical part of the LittleFS start-up, deferred until after the first toggle
+void completeLittleFsInit()
+{
+  if (littleFsMounted)
+  {
+    fsScanStartUs = micros();
+    fsUsage.begin();
+    fsIndex.setUsage(&fsUsage);
+    fsIndex.begin(LittleFS, "/", FS_INDEX_MAX_ENTRIES, fsScanTaskId >= 0);
+    configStore.setIndex(&fsIndex);
+#if EVENT_LOG_ENABLED
+    eventLog.setIndex(&fsIndex);
+    eventLog.setUsage(&fsUsage);
+    if (eventLog.begin(LittleFS))
+    {
+      logBootEvent();
+    }
+#endif
+    if (scheduleIndexScan(true))
+    {
+      return;
+    }
+  }
+  finishLittleFsInit();
+
+}   //   completeLittleFsInit()
+
+//-- periodic report from the cached index; only rescans after an invalidation
+void reportLittleFs()
+{
+  if (!littleFsMounted)
+  {
+    if (initLittleFs())
+    {
+      completeLittleFsInit();
+    }
+    return;
+  }
+
+  if (fsIndex.isScanning())
+  {
+    LOG_INFO("Info: LittleFS index is being rebuilt, %u entries so far.\n", (unsigned)fsIndex.count());
+  }
+  else if (fsIndex.isStale())
+  {
+    fsScanStartUs = micros();
+    if (fsScanTaskId >= 0)
+    {
+      fsIndex.startRescan();
+      scheduleIndexScan(false);
+    }
+    else if (fsIndex.rescanIfNeeded())
+    {
+      fsUsage.resync();
+      metricsFsTime(METRICS_FS_INDEX, micros() - fsScanStartUs);
+      LOG_INFO("Info: LittleFS index rebuilt.\n");
+    }
+  }
+  printLittleFsUsage();
+  fsIndex.printListing();
+#if EVENT_LOG_ENABLED
+  logReportEvents();
+#endif
+
+  LOG_INFO("\n\n");
+
+}   //   reportLittleFs()
+
+//-- scheduler task: periodic LittleFS report
+void reportTask()
+{
+#if CPU_SCALING_ENABLED
+  CpuBurst burst;
+#endif
+  uint32_t oldDelayTime = delayTime;
+
+  reportLittleFs();
+  printOutputStats();
+
+  //-- initLittleFs() lowers delayTime on failure, follow it with the output
+  if (delayTime != oldDelayTime)
+  {
+    applyOutputPeriod();
+  }
+
+}   //   reportTask()
+
+#if RTOS_TASKS_ENABLED
+//-- runs in the filesystem worker task (RTOS_FS_WORKER_CORE)
+void handleFsCommand(fsWorkerCommand command)
+{
+#if CPU_SCALING_ENABLED
+  //-- not the loop task: the clock goes up on the next loop pass
+  CpuBurst burst;
+#endif
+  uint32_t oldDelayTime = delayTime;
+
+  switch (command)
+  {
+    case FS_CMD_REPORT:
+      reportLittleFs();
+      printOutputStats();
+      break;
+    case FS_CMD_USAGE:
+      printLittleFsUsage();
+      break;
+    case FS_CMD_LIST:
+      listFiles(LittleFS, "/");
+      break;
+    case FS_CMD_INVALIDATE:
+      fsIndex.invalidate();
+      break;
+    case FS_CMD_BOOT:
+      completeLittleFsInit();
+      break;
+    case FS_CMD_EVENTS:
+#if EVENT_LOG_ENABLED
+      printEvents(consoleEventCount);
+#endif
+      break;
+  }
+
+  if (delayTime != oldDelayTime)
+  {
+    applyOutputPeriod();
+  }
+
+}   //   handleFsCommand()
+
+//-- scheduler task: hand the periodic report to the filesystem worker
+void postReportTask()
+{
+  postFsCommand(FS_CMD_REPORT);
+
+}   //   postReportTask()
+#endif
+
+//-- parse a decimal console argument within [minValue, maxValue]
+bool parseConsoleNumber(const char *text, uint32_t minValue, uint32_t maxValue, uint32_t &value)
+{
+  if (text == nullptr || *text == '\0')
+  {
+    return false;
+  }
+
+  char          *end    = nullptr;
+  unsigned long  parsed = strtoul(text, &end, 10);
+  if (*end != '\0' || parsed < minValue || parsed > maxValue)
+  {
+    LOG_WARN("Warning: [%s] is not a number in %u..%u\n", text, (unsigned)minValue, (unsigned)maxValue);
+    return false;
+  }
+  value = (uint32_t)parsed;
+  return true;
+
+}   //   parseConsoleNumber()
+
+void consoleHelp(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+  LOG_INFO("Commands:\n");
+  console.printHelp();
+
+}   //   consoleHelp()
+
+void consoleList(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+  if (!littleFsMounted)
+  {
+    LOG_WARN("Warning: LittleFS is not mounted.\n");
+    return;
+  }
+#if RTOS_TASKS_ENABLED
+  //-- a live recursive walk, off the output core
+  if (postFsCommand(FS_CMD_LIST))
+  {
+    return;
+  }
+#endif
+  //-- printed from the (recursive) index a few lines per loop, see continueConsoleList()
+  LOG_INFO("\n");
+  consoleListPosition = 0;
+
+}   //   consoleList()
+
+void consoleCat(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    LOG_WARN("Warning: usage: cat <path>\n");
+    return;
+  }
+  if (!littleFsMounted)
+  {
+    LOG_WARN("Warning: LittleFS is not mounted.\n");
+    return;
+  }
+  //-- "/name" also finds "/name.hs", printed a chunk per loop, see continueConsoleCat()
+  if (!consoleCatFile.open(LittleFS, argv[1]))
+  {
+    LOG_WARN("Warning: cannot open [%s].\n", argv[1]);
+    return;
+  }
+  LOG_INFO(
+    "Info: %s, %u bytes (%u on flash%s)\n",
+    argv[1],
+    (unsigned)consoleCatFile.size(),
+    (unsigned)consoleCatFile.storedSize(),
+    consoleCatFile.isCompressed() ? ", compressed" : ""
+  );
+
+}   //   consoleCat()
+
+void consoleUsage(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+#if RTOS_TASKS_ENABLED
+  if (postFsCommand(FS_CMD_USAGE))
+  {
+    return;
+  }
+#endif
+  printLittleFsUsage();
+
+}   //   consoleUsage()
+
+void consolePeriod(int argc, char *argv[])
+{
+  uint32_t periodMs = 0;
+  if (argc < 2)
+  {
+    LOG_INFO("Blink period: %u ms\n", (unsigned)delayTime);
+    return;
+  }
+  if (!parseConsoleNumber(argv[1], CONSOLE_PERIOD_MIN_MS, CONSOLE_PERIOD_MAX_MS, periodMs))
+  {
+    return;
+  }
+
+  delayTime = periodMs;
+  applyOutputPeriod();
+  outputSettingsChanged = true;
+  configChanged();
+  LOG_INFO("Info: blink period set to %u ms\n", (unsigned)delayTime);
+
+}   //   consolePeriod()
+
+void consoleColor(int argc, char *argv[])
+{
+#ifdef USE_NEOPIXEL
+  uint32_t red, green, blue;
+  if (argc < 4
+      || !parseConsoleNumber(argv[1], 0, 255, red)
+      || !parseConsoleNumber(argv[2], 0, 255, green)
+      || !parseConsoleNumber(argv[3], 0, 255, blue))
+  {
+    LOG_WARN("Warning: usage: color <red> <green> <blue>\n");
+    return;
+  }
+  outputColor           = neoPixel.Color((uint8_t)red, (uint8_t)green, (uint8_t)blue);
+  outputSettingsChanged = true;
+  configChanged();
+  LOG_INFO("Info: NeoPixel colour set to %u,%u,%u\n", (unsigned)red, (unsigned)green, (unsigned)blue);
+#else
+  (void)argc;
+  (void)argv;
+  LOG_WARN("Warning: this build has no NeoPixel.\n");
+#endif
+
+}   //   consoleColor()
+
+void consoleBrightness(int argc, char *argv[])
+{
+  uint32_t brightness = 0;
+  if (argc < 2 || !parseConsoleNumber(argv[1], 0, 255, brightness))
+  {
+    LOG_WARN("Warning: usage: bright <0..255>\n");
+    return;
+  }
+  //-- used by the NeoPixel and LEDC backends, a plain GPIO LED ignores it
+  outputBrightness      = (uint8_t)brightness;
+  outputSettingsChanged = true;
+  configChanged();
+  LOG_INFO("Info: output brightness set to %u\n", (unsigned)brightness);
+
+}   //   consoleBrightness()
+
+void consoleOutput(int argc, char *argv[])
+{
+#if OUTPUT_MACHINE_ENABLED
+  if (argc < 2)
+  {
+    printOutputMachine();
+    return;
+  }
+  outputEvent event;
+  if (!OutputMachine::parseEvent(argv[1], event))
+  {
+    LOG_WARN("Warning: usage: out [on|off|toggle|blink]\n");
+    return;
+  }
+  if (!outputMachine.post(OUTPUT_SOURCE_TASK, event))
+  {
+    LOG_WARN("Warning: output event queue is full.\n");
+  }
+#else
+  (void)argc;
+  (void)argv;
+  LOG_WARN("Warning: this output mode takes no commands.\n");
+#endif
+
+}   //   consoleOutput()
+
+void consoleTiming(int argc, char *argv[])
+{
+  if (argc > 1 && strcmp(argv[1], "reset") == 0)
+  {
+    scheduler.resetTiming();
+#if RTOS_TASKS_ENABLED
+    resetRtosOutputTiming();
+#endif
+    LOG_INFO("Info: timing statistics reset.\n");
+    return;
+  }
+  printOutputTiming();
+
+}   //   consoleTiming()
+
+void consoleMetrics(int argc, char *argv[])
+{
+  if (argc > 1 && strcmp(argv[1], "reset") == 0)
+  {
+    metricsReset();
+    LOG_INFO("Info: metrics reset.\n");
+    return;
+  }
+  metricsDump();
+
+}   //   consoleMetrics()
+
+#if EVENT_LOG_ENABLED
+void consoleEvents(int argc, char *argv[])
+{
+  uint32_t count = consoleEventCount;
+  if (argc > 1 && !parseConsoleNumber(argv[1], 1, CONSOLE_EVENTS_MAX, count))
+  {
+    return;
+  }
+  consoleEventCount = (uint16_t)count;
+#if RTOS_TASKS_ENABLED
+  //-- the log is written by the filesystem worker, read it there as well
+  if (postFsCommand(FS_CMD_EVENTS))
+  {
+    return;
+  }
+#endif
+  printEvents(consoleEventCount);
+
+}   //   consoleEvents()
+#endif
+
+#if CRASH_REPORT_ENABLED
+void consoleCrash(int argc, char *argv[])
+{
+  (void)argc;
+  (void)argv;
+  crashReportDump();
+
+}   //   consoleCrash()
+#endif
+
+void consoleConfig(int argc, char *argv[])
+{
+  if (argc > 1 && strcmp(argv[1], "save") == 0)
+  {
+    configStore.commit();
+    return;
+  }
+  if (argc > 1 && strcmp(argv[1], "reset") == 0)
+  {
+    applyConfig(defaultConfig);
+    applyOutputPeriod();
+    configChanged();
+    LOG_INFO("Info: settings reset to the defaults.\n");
+    return;
+  }
+
+  LOG_INFO(
+    "Settings: period %u ms, colour 0x%06x, brightness %u (%s, %u writes, %u coalesced)\n",
+    (unsigned)delayTime,
+    (unsigned)outputColor,
+    (unsigned)outputBrightness,
+    configStore.isDirty() ? "unsaved" : "saved",
+    (unsigned)configStore.writeCount(),
+    (unsigned)configStore.coalescedCount()
+  );
+
+}   //   consoleConfig()
+
+#if OTA_UPDATE_ENABLED
+//-- one protocol line for otaUpload.py, never filtered by LOG_LEVEL; written
+//-- straight to the UART, a full log ring would drop it and stall the sender.
+//-- The leading newline ends a log line the flush task may be halfway through
+void otaReply(const char *format, uint32_t value)
+{
+  char line[32];
+  int  length = snprintf(line, sizeof(line), format, (unsigned)value);
+  Serial.write((const uint8_t *)line, (size_t)length);
+
+}   //   otaReply()
+
+//-- true while the next flash access of the update cannot make a toggle late
+bool otaHasOutputRoom()
+{
+  return outputHasRoomFor(otaUpdater.maxFlashUs());
+
+}   //   otaHasOutputRoom()
+
+//-- scheduler task: start the new image once the last lines are out
+void otaRestartTask()
+{
+  logFlushAll();
+  Serial.flush();
+  esp_restart();
+
+}   //   otaRestartTask()
+
+//-- scheduler task: a fresh image has run OTA_CONFIRM_AFTER_MS, keep it if it works;
+//-- the check is the output only: LittleFS may stay unmounted on a healthy image
+//-- (an unformatted partition, see initLittleFs())
+void otaConfirmTask()
+{
+#if HW_BLINK_ENABLED
+  bool outputRunning = (hwBlinkToggleCount() > 1);
+#elif PIXEL_EFFECTS_ENABLED
+  bool outputRunning = (effects.stats().framesRendered > 1);
+#else
+  bool outputRunning = (outputToggleCount > 1);
+#endif
+  otaConfirmBoot(outputRunning);
+
+}   //   otaConfirmTask()
+
+void consoleOta(int argc, char *argv[])
+{
+  uint32_t imageBytes = 0;
+  if (argc < 3 || !parseConsoleNumber(argv[1], 1, UINT32_MAX, imageBytes))
+  {
+    LOG_WARN("Warning: usage: ota <bytes> <sha256>\n");
+    return;
+  }
+  if (!otaUpdater.begin(imageBytes, argv[2]))
+  {
+    otaReply("\nOTA fail %u\n", 0);
+    return;
+  }
+  //-- from here on the serial input is image data, see serviceOtaTransfer()
+  otaReply("\nOTA ready %u\n", OTA_CHUNK_SIZE);
+
+}   //   consoleOta()
+
+//-- move at most one chunk from the UART into the passive slot per loop;
+//-- the sender waits for an "OTA ack" after every chunk (flow control)
+void serviceOtaTransfer()
+{
+  if ((millis() - otaUpdater.lastWriteMs()) > OTA_IDLE_TIMEOUT_MS)
+  {
+    LOG_ERROR("Error: OTA timed out.\n");
+    otaUpdater.abort();
+    otaReply("\nOTA fail %u\n", 0);
+    return;
+  }
+  //-- a flash write (with its sector erase) must not run into a toggle deadline
+  if (!otaHasOutputRoom())
+  {
+    return;
+  }
+
+  uint32_t received = otaUpdater.receivedBytes();
+  if (received >= otaUpdater.imageBytes())
+  {
+    //-- the last chunk is in; finish() writes otadata, so it waits for room as well
+    if (otaUpdater.finish())
+    {
+      otaReply("\nOTA ok %u\n", received);
+      scheduler.addOneShot("restart", otaRestartTask, 500);
+    }
+    else
+    {
+      otaReply("\nOTA fail %u\n", received);
+    }
+    return;
+  }
+
+  uint32_t remaining = otaUpdater.imageBytes() - received;
+  size_t   wanted    = (remaining < OTA_CHUNK_SIZE) ? remaining : OTA_CHUNK_SIZE;
+  size_t   length    = 0;
+  while (length < wanted && Serial.available() > 0)
+  {
+    otaChunk[length++] = (uint8_t)Serial.read();
+  }
+  if (length == 0)
+  {
+    return;
+  }
+
+  if (!otaUpdater.write(otaChunk, length))
+  {
+    otaReply("\nOTA fail %u\n", 0);
+    return;
+  }
+
+  received = otaUpdater.receivedBytes();
+  if (received < otaUpdater.imageBytes() && (received % OTA_CHUNK_SIZE) == 0)
+  {
+    otaReply("\nOTA ack %u\n", received);
+  }
+
+}   //   serviceOtaTransfer()
+#endif
+
+//-- the commands initConsole() registers in this build
+const uint8_t CONSOLE_COMMAND_COUNT = 11 + OTA_UPDATE_ENABLED + EVENT_LOG_ENABLED + CRASH_REPORT_ENABLED;
+static_assert(CONSOLE_COMMAND_COUNT <= CONSOLE_MAX_COMMANDS, "CONSOLE_MAX_COMMANDS cannot hold every console command");
+
+void initConsole()
+{
+  console.addCommand("help",    consoleHelp,       "this list");
+  console.addCommand("ls",      consoleList,       "list all files (recursive)");
+  console.addCommand("cat",     consoleCat,        "<path> print a file (decompresses <path>.hs)");
+  console.addCommand("df",      consoleUsage,      "LittleFS usage");
+  console.addCommand("period",  consolePeriod,     "[ms] show or set the blink period");
+  console.addCommand("color",   consoleColor,      "<r> <g> <b> NeoPixel colour");
+  console.addCommand("bright",  consoleBrightness, "<0..255> NeoPixel / LEDC LED brightness");
+  console.addCommand("out",     consoleOutput,     "[on|off|toggle|blink] hold the output or let it blink");
+  console.addCommand("config",  consoleConfig,     "[save|reset] show, write now or reset the settings");
+#if OTA_UPDATE_ENABLED
+  console.addCommand("ota",     consoleOta,        "<bytes> <sha256> receive a firmware image (otaUpload.py)");
+#endif
+  console.addCommand("metrics", consoleMetrics,    "[reset] dump or reset the runtime metrics");
+  console.addCommand("timing",  consoleTiming,     "[reset] lateness of the toggles against their deadlines");
+#if EVENT_LOG_ENABLED
+  console.addCommand("events",  consoleEvents,     "[n] the newest n records of the event log");
+#endif
+#if CRASH_REPORT_ENABLED
+  console.addCommand("crash",   consoleCrash,      "reset reason and the coredump summary of this boot");
+#endif
+
+}   //   initConsole()
+
+//-- a few lines of a running "ls" per loop, only while the log ring has room
+void continueConsoleList()
+{
+  while (consoleListPosition < fsIndex.count() && logPending() < LOG_BUFFER_SIZE / 2)
+  {
+    //-- a copy taken under the lock, the filesystem worker may change the index
+    fsIndexEntry current;
+    {
+      FsIndexLock         guard(fsIndex);
+      const fsIndexEntry *found = fsIndex.entry(consoleListPosition++);
+      if (found == nullptr)
+      {
+        break;
+      }
+      current = *found;
+    }
+    if (current.isDirectory)
+    {
+      LOG_INFO("DIR : %s\n", current.path);
+    }
+    else
+    {
+      compressedPrintFileLine(LittleFS, 0, current.path, current.size);
+    }
+  }
+
+  if (consoleListPosition != UINT16_MAX && consoleListPosition >= fsIndex.count())
+  {
+    LOG_INFO("Info: %u entries.\n", (unsigned)fsIndex.count());
+    consoleListPosition = UINT16_MAX;
+  }
+
+}   //   continueConsoleList()
+
+//-- the next chunks of a running "cat", only while the log ring has room
+void continueConsoleCat()
+{
+  char chunk[LOG_LINE_MAX];
+
+  while (logPending() < LOG_BUFFER_SIZE / 2)
+  {
+    size_t length = consoleCatFile.read((uint8_t *)chunk, sizeof(chunk));
+    if (length == 0)
+    {
+      if (consoleCatFile.isDamaged())
+      {
+        LOG_WARN("\nWarning: the compressed data is damaged.\n");
+      }
+      LOG_INFO("\n");
+      consoleCatFile.close();
+      return;
+    }
+    logWriteRaw(chunk, length);
+  }
+
+}   //   continueConsoleCat()
+
+//-- read the console every loop, but run a command only when it cannot push
+//-- back a scheduled output toggle (the RTOS output task is never affected)
+void serviceConsole()
+{
+#if OTA_UPDATE_ENABLED
+  if (otaUpdater.isActive())
+  {
+    serviceOtaTransfer();
+    return;
+  }
+#endif
+  if (console.poll())
+  {
+    if (scheduler.hasRoomFor(CONSOLE_HEADROOM_MS * 1000UL))
+    {
+      console.dispatch();
+    }
+  }
+  if (consoleListPosition != UINT16_MAX)
+  {
+    continueConsoleList();
+  }
+  if (consoleCatFile)
+  {
+    continueConsoleCat();
+  }
+
+}   //   serviceConsole()
+
+//-- what the board profile (boardCaps.h) chose for this build
+void printBoardProfile()
+{
+#if defined(USE_NEOPIXEL)
+  const char *output = NEOPIXEL_RMT_ENABLED ? "NeoPixel (RMT)" : "NeoPixel (bit-bang)";
+#elif HW_BLINK_ENABLED
+  const char *output = "LED (hardware blink)";
+#else
+  const char *output = "LED";
+#endif
+
+  LOG_INFO(
+    "Board: %s (%s), %u core(s), %u MHz, flash %u KB, PSRAM %s, RMT %u\n",
+    BOARD_PROFILE_ENV,
+    BOARD_PROFILE_MCU,
+    (unsigned)BOARD_CPU_CORES,
+    (unsigned)BOARD_F_CPU_MHZ,
+    (unsigned)(BOARD_FLASH_BYTES / 1024),
+    BOARD_PSRAM ? "yes" : "no",
+    (unsigned)BOARD_RMT_TX_CHANNELS
+  );
+  LOG_INFO(
+    "Board: %s scheduler, log ring %u bytes, index %u entries, output %s\n",
+    RTOS_TASKS_ENABLED ? "RTOS task" : "single loop",
+    (unsigned)LOG_BUFFER_SIZE,
+    (unsigned)FS_INDEX_MAX_ENTRIES,
+    output
+  );
+
+}   //   printBoardProfile()
+
+//-- wait until the serial port can be used instead of a fixed delay;
+//-- a UART is ready at once, USB CDC waits (bounded) for the host
+void waitForSerial()
+{
+  uint32_t waitStartMs = millis();
+  while (!Serial && (millis() - waitStartMs) < SERIAL_READY_TIMEOUT_MS)
+  {
+    delay(1);
+  }
+
+}   //   waitForSerial()
+
+void setup()
+{
+  bootMark("setup");
+  memBegin();
+  Serial.begin(115200);
+  waitForSerial();
+  logBegin();
+  bootMark("serial");
+
+  LOG_INFO("Program version: %s\n", PROG_VERSION);
+  printBoardProfile();
+#if CPU_SCALING_ENABLED
+  cpuScalingBegin();
+#endif
+#if OTA_UPDATE_ENABLED
+  otaCheckTrialBoot();
+#endif
+  initConsole();
+
+#if !CONFIG_STORE_NEEDS_FS
+  //-- NVS is ready at once, the first toggle already uses the stored settings
+  loadConfig();
+#endif
+
+  initOutput();
+#if SLEEP_MODE_ENABLED
+#if defined(USE_LED)
+  sleepBegin(LED_PIN);
+#else
+  sleepBegin();
+#endif
+  //-- after a deep sleep carry on where the last wake-up stopped
+  if (sleepRestore(outputIsOn, outputToggleCount, delayTime))
+  {
+    outputs.write(outputIsOn);
+    refreshPixels();
+    beginOutputMachine();
+  }
+#endif
+  bootMark("output");
+
+  //-- first toggle before anything that is not needed for it
+#if !HW_BLINK_ENABLED
+  runOutput();
+#endif
+  bootMark("toggle");
+
+#if SLEEP_MODE_ENABLED && (SLEEP_MODE == SLEEP_MODE_DEEP)
+  if (sleepResumed())
+  {
+    //-- wake-up fast path: the toggle was all this boot was for
+    sleepRecordBootUs(bootStageUs("toggle"));
+    sleepSave(outputIsOn, outputToggleCount, delayTime);
+    sleepFor(outputPeriodMs());
+  }
+#endif
+
+#if CRASH_REPORT_ENABLED
+  //-- once per boot: the coredump partition is cleared after this read
+  if (crashReportCapture())
+  {
+    crashReportDump();
+  }
+  bootMark("crash");
+#endif
+
+  initLittleFs();
+  bootMark("mount");
+
+#if CONFIG_STORE_NEEDS_FS
+  if (littleFsMounted)
+  {
+    loadConfig();
+    applyOutputPeriod();
+  }
+#endif
+
+#if defined(FS_BENCHMARK)
+  if (littleFsMounted)
+  {
+    fsSpaceInfo space;
+    if (LittleFsBackend::space(space))
+    {
+      runFsBenchmark(LittleFS, space.totalBytes);
+    }
+  }
+#endif
+
+#if TELEMETRY_ENABLED
+  //-- connects in the background, poll() starts listening once it is up
+  telemetry.begin(&fsIndex, &fsUsage);
+#if OUTPUT_MACHINE_ENABLED
+  telemetry.setCommandHandler(postOutputCommand);
+#endif
+#endif
+
+  metricsSampleHeap();
+  scheduler.addPeriodic("heap", metricsSampleHeap, METRICS_HEAP_SAMPLE_MS, METRICS_HEAP_SAMPLE_MS);
+  configTaskId = scheduler.addOneShot("config", configTask, 0);
+#if OTA_UPDATE_ENABLED
+  if (otaIsUnconfirmed())
+  {
+    scheduler.addOneShot("otaConfirm", otaConfirmTask, OTA_CONFIRM_AFTER_MS);
+  }
+#endif
+
+#if RTOS_TASKS_ENABLED && OUTPUT_MACHINE_ENABLED
+  //-- a posted event wakes the output task, which handles it at once
+  setRtosOutputEventHandler(serviceOutputEvents);
+  outputMachine.setWakeup(wakeRtosOutputTask);
+#endif
+#if RTOS_TASKS_ENABLED && NEOPIXEL_RMT_ENABLED
+  setRtosOutputServiceHandler(servicePixelStrips);
+#endif
+#if RTOS_TASKS_ENABLED
+  setRtosOutputBound(OUTPUT_MAX_LATE_US);
+  if (startRtosTasks(
+        HW_BLINK_ENABLED ? nullptr : runOutput,
+        handleFsCommand,
+        outputPeriodMs(),
+        REPORT_EVERY_TOGGLES * delayTime / outputPeriodMs()))
+  {
+    postFsCommand(FS_CMD_BOOT);
+#if HW_BLINK_ENABLED
+    //-- there is no output task to pace the reports, post them from loop()
+    reportTaskId = scheduler.addPeriodic(
+      "report",
+      postReportTask,
+      REPORT_EVERY_TOGGLES * delayTime,
+      6 * delayTime
+    );
+#endif
+    return;
+  }
+#if OUTPUT_MACHINE_ENABLED
+  outputMachine.setWakeup(nullptr);
+#endif
+  LOG_WARN("Warning: falling back to the single loop scheduler.\n");
+#endif
+
+  //-- armed by scheduleIndexScan(), before "fsBoot" so the boot walk can use it
+  fsScanTaskId = scheduler.addOneShot("fsScan", fsScanTask, 0);
+  scheduler.cancel(fsScanTaskId);
+  scheduler.addOneShot("fsBoot", completeLittleFsInit, 0);
+#if !HW_BLINK_ENABLED
+  toggleTaskId = scheduler.addPeriodic("output", runOutput, outputPeriodMs(), outputPeriodMs());
+  scheduler.setLatencyBound(toggleTaskId, OUTPUT_MAX_LATE_US);
+#endif
+  reportTaskId = scheduler.addPeriodic(
+    "report",
+    reportTask,
+    REPORT_EVERY_TOGGLES * delayTime,
+    6 * delayTime
+  );
+
+}   //   setup()
+
+void loop()
+{
+  uint32_t loopStartUs = micros();
+
+  scheduler.run();
+  serviceConsole();
+
+#if TELEMETRY_ENABLED
+  //-- the console's headroom rule: a response chunk never pushes back a toggle
+  if (scheduler.hasRoomFor(CONSOLE_HEADROOM_MS * 1000UL))
+  {
+    telemetry.poll();
+  }
+#endif
+
+#if NEOPIXEL_RMT_ENABLED
+  //-- send a frame that was postponed because the RMT was still busy
+  //-- (with RTOS tasks only the output task touches the strip)
+  if (toggleTaskId >= 0)
+  {
+    servicePixelStrips();
+  }
+#endif
+
+#if HW_BLINK_ENABLED
+  //-- no output job runs with the hardware blink, the loop applies "bright" and
+  //-- loaded settings (the LEDC duty is a single register write)
+  if (outputSettingsChanged)
+  {
+    applyOutputSettings();
+  }
+#endif
+
+#if OUTPUT_MACHINE_ENABLED
+  //-- single loop scheduler: the loop owns the outputs and takes the events
+  if (toggleTaskId >= 0 && outputMachine.hasPending())
+  {
+    serviceOutputEvents();
+  }
+#endif
+
+  //-- without a flush task the log drains here; wake up often while it is not empty
+  size_t logBytesPending = logFlush();
+  metricsLoopTime(micros() - loopStartUs);
+
+  //-- an update in progress needs the loop back quickly for the next chunk
+  bool serialBusy = false;
+#if OTA_UPDATE_ENABLED
+  serialBusy = otaUpdater.isActive();
+#endif
+  //-- same for a telemetry response that is still being sent
+  bool networkBusy = false;
+#if TELEMETRY_ENABLED
+  networkBusy = telemetry.isBusy();
+#endif
+
+#if CPU_SCALING_ENABLED
+  //-- an index walk in slices is a burst spread over many passes
+  cpuScalingService(serialBusy || networkBusy || fsIndex.isScanning());
+#endif
+
+#if SLEEP_MODE_ENABLED
+  //-- sleep through the whole wait instead of idling awake (deep sleep does not return)
+#if SLEEP_MODE == SLEEP_MODE_DEEP
+  //-- a deep sleep ends in a reboot that toggles: sleep to the toggle deadline, the
+  //-- other tasks (heap samples, reports) do not outlive this boot; overdue work runs first
+  uint32_t waitMs = (scheduler.msUntilNext() > 0) ? scheduler.msUntilTask(toggleTaskId) : 0;
+#else
+  uint32_t waitMs = scheduler.msUntilNext();
+#endif
+  if (waitMs >= SLEEP_MIN_MS && !console.hasLine() && consoleListPosition == UINT16_MAX && !consoleCatFile && !serialBusy)
+  {
+#if SLEEP_MODE == SLEEP_MODE_DEEP
+    //-- RAM does not survive, write pending settings first
+    configStore.commit();
+#endif
+    sleepSave(outputIsOn, outputToggleCount, delayTime);
+    sleepFor(waitMs);
+    return;
+  }
+#endif
+
+  if (logBytesPending > 0 || serialBusy || networkBusy)
+  {
+    scheduler.idle(LOG_IDLE_SLICE_MS);
+  }
+#if OUTPUT_BUTTON_ENABLED
+  else if (toggleTaskId >= 0)
+  {
+    scheduler.idle(OUTPUT_BUTTON_POLL_MS);
+  }
+#endif
+  else
+  {
+    scheduler.idle();
+  }
 
 }   //   loop()
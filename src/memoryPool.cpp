@@ -0,0 +1,232 @@
+//--- Memory placement: large cold buffers to PSRAM, small frequent blocks from a fixed pool
+
+#include "memoryPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_heap_caps.h>
+  #include <esp_idf_version.h>
+  #if ESP_IDF_VERSION_MAJOR >= 5
+    #include <esp_memory_utils.h>
+  #else
+    #include <soc/soc_memory_layout.h>
+  #endif
+  #include <freertos/FreeRTOS.h>
+  //-- the pool and the counters are used from tasks on both cores
+  static portMUX_TYPE memMux = portMUX_INITIALIZER_UNLOCKED;
+  #define MEM_LOCK()   portENTER_CRITICAL(&memMux)
+  #define MEM_UNLOCK() portEXIT_CRITICAL(&memMux)
+#else
+  #define MEM_LOCK()   noInterrupts()
+  #define MEM_UNLOCK() interrupts()
+#endif
+
+static uint32_t  coldBytes     = 0;
+static uint32_t  coldFallbacks = 0;
+static uint32_t  poolMisses    = 0;
+static BlockPool smallPool;
+
+bool memBegin()
+{
+  return smallPool.begin(MEM_SMALL_BLOCK_SIZE, MEM_SMALL_BLOCK_COUNT);
+
+}   //   memBegin()
+
+void *memAllocCold(size_t size)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) > 0)
+  {
+    void *block = heap_caps_calloc(1, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (block != nullptr)
+    {
+      MEM_LOCK();
+      coldBytes += size;
+      MEM_UNLOCK();
+      return block;
+    }
+  }
+#endif
+
+  MEM_LOCK();
+  coldFallbacks++;
+  MEM_UNLOCK();
+  return memAllocHot(size);
+
+}   //   memAllocCold()
+
+void *memAllocHot(size_t size)
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  return heap_caps_calloc(1, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+  return calloc(1, size);
+#endif
+
+}   //   memAllocHot()
+
+void memFree(void *block, size_t size)
+{
+  if (block == nullptr)
+  {
+    return;
+  }
+
+#if defined(ARDUINO_ARCH_ESP32)
+  if (esp_ptr_external_ram(block))
+  {
+    MEM_LOCK();
+    coldBytes = (coldBytes > size) ? coldBytes - size : 0;
+    MEM_UNLOCK();
+  }
+  heap_caps_free(block);
+#else
+  (void)size;
+  free(block);
+#endif
+
+}   //   memFree()
+
+void *memSmallAlloc(size_t size)
+{
+  if (size <= MEM_SMALL_BLOCK_SIZE)
+  {
+    void *block = smallPool.allocate();
+    if (block != nullptr)
+    {
+      return block;
+    }
+  }
+
+  MEM_LOCK();
+  poolMisses++;
+  MEM_UNLOCK();
+  return memAllocHot(size);
+
+}   //   memSmallAlloc()
+
+void memSmallFree(void *block)
+{
+  if (block == nullptr)
+  {
+    return;
+  }
+  if (smallPool.owns(block))
+  {
+    smallPool.release(block);
+    return;
+  }
+  memFree(block, 0);
+
+}   //   memSmallFree()
+
+void memGetStats(memoryStats &stats)
+{
+  memset(&stats, 0, sizeof(stats));
+
+#if defined(ARDUINO_ARCH_ESP32)
+  stats.internalFree    = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  stats.internalMinFree = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  stats.internalLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  stats.psramTotal      = heap_caps_get_total_size(MALLOC_CAP_SPIRAM);
+  stats.psramFree       = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+#elif defined(ARDUINO_ARCH_ESP8266)
+  stats.internalFree    = ESP.getFreeHeap();
+  stats.internalLargest = ESP.getMaxFreeBlockSize();
+#endif
+
+  MEM_LOCK();
+  stats.coldBytes     = coldBytes;
+  stats.coldFallbacks = coldFallbacks;
+  stats.poolMisses    = poolMisses;
+  stats.poolUsed      = smallPool.used();
+  stats.poolPeak      = smallPool.peak();
+  MEM_UNLOCK();
+
+}   //   memGetStats()
+
+BlockPool::~BlockPool()
+{
+  memFree(storage, blockSize * blockCount);
+
+}   //   ~BlockPool()
+
+bool BlockPool::begin(size_t size, uint16_t count)
+{
+  if (storage != nullptr || count == 0)
+  {
+    return storage != nullptr;
+  }
+
+  //-- every block must be able to hold the free-list link, pointer aligned
+  if (size < sizeof(freeBlock))
+  {
+    size = sizeof(freeBlock);
+  }
+  size = (size + sizeof(freeBlock) - 1) & ~(sizeof(freeBlock) - 1);
+
+  //-- one allocation for the lifetime of the firmware, always internal (hot)
+  storage = (uint8_t *)memAllocHot(size * count);
+  if (storage == nullptr)
+  {
+    return false;
+  }
+
+  blockSize  = size;
+  blockCount = count;
+  freeList   = nullptr;
+  for (int index = count - 1; index >= 0; index--)
+  {
+    freeBlock *block = (freeBlock *)&storage[(size_t)index * size];
+    block->next = freeList;
+    freeList    = block;
+  }
+  return true;
+
+}   //   begin()
+
+void *BlockPool::allocate()
+{
+  MEM_LOCK();
+  freeBlock *block = freeList;
+  if (block != nullptr)
+  {
+    freeList = block->next;
+    usedCount++;
+    if (usedCount > peakCount)
+    {
+      peakCount = usedCount;
+    }
+  }
+  MEM_UNLOCK();
+  return block;
+
+}   //   allocate()
+
+void BlockPool::release(void *block)
+{
+  if (!owns(block))
+  {
+    return;
+  }
+
+  MEM_LOCK();
+  freeBlock *released = (freeBlock *)block;
+  released->next = freeList;
+  freeList       = released;
+  usedCount--;
+  MEM_UNLOCK();
+
+}   //   release()
+
+bool BlockPool::owns(const void *block) const
+{
+  const uint8_t *address = (const uint8_t *)block;
+  return storage != nullptr
+         && address >= storage
+         && address < storage + blockSize * blockCount
+         && ((size_t)(address - storage) % blockSize) == 0;
+
+}   //   owns()
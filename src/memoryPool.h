@@ -0,0 +1,81 @@
+//--- Memory placement: large cold buffers to PSRAM, small frequent blocks from a fixed pool
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- blocks of the shared small-object pool (memSmallAlloc())
+#ifndef MEM_SMALL_BLOCK_SIZE
+  #define MEM_SMALL_BLOCK_SIZE 64
+#endif
+#ifndef MEM_SMALL_BLOCK_COUNT
+  #define MEM_SMALL_BLOCK_COUNT 32
+#endif
+
+struct memoryStats
+{
+  uint32_t internalFree;
+  uint32_t internalMinFree;
+  uint32_t internalLargest;
+  uint32_t psramTotal;
+  uint32_t psramFree;
+  uint32_t coldBytes;        // memAllocCold() bytes that live in PSRAM
+  uint32_t coldFallbacks;    // memAllocCold() calls served from internal RAM
+  uint16_t poolUsed;
+  uint16_t poolPeak;
+  uint32_t poolMisses;       // memSmallAlloc() calls the pool could not serve
+};
+
+//-- create the shared small-object pool; call once in setup() before any task
+//-- uses memSmallAlloc() (until then it serves every request from the heap)
+bool memBegin();
+
+//-- large, rarely touched buffers (index, log ring, frame buffers): PSRAM when
+//-- the board has it, internal RAM otherwise; zero filled
+void *memAllocCold(size_t size);
+
+//-- latency sensitive data, always internal RAM; zero filled
+void *memAllocHot(size_t size);
+
+//-- release memory from memAllocCold()/memAllocHot(); size is the requested size
+void memFree(void *block, size_t size);
+
+//-- small, short lived objects: a fixed block from the shared pool when size
+//-- fits MEM_SMALL_BLOCK_SIZE, internal heap otherwise; O(1), no fragmentation
+void *memSmallAlloc(size_t size);
+void  memSmallFree(void *block);
+
+void memGetStats(memoryStats &stats);
+
+//-- fixed-size block allocator over one internal allocation (free list in the blocks)
+class BlockPool
+{
+  public:
+    ~BlockPool();
+
+    bool begin(size_t blockSize, uint16_t blockCount);
+
+    //-- nullptr when all blocks are in use
+    void *allocate();
+    void  release(void *block);
+
+    bool     owns(const void *block) const;
+    uint16_t capacity() const   { return blockCount; }
+    uint16_t used() const       { return usedCount; }
+    uint16_t peak() const       { return peakCount; }
+    size_t   blockBytes() const { return blockSize; }
+
+  private:
+    struct freeBlock
+    {
+      freeBlock *next;
+    };
+
+    uint8_t   *storage    = nullptr;
+    freeBlock *freeList   = nullptr;
+    size_t     blockSize  = 0;
+    uint16_t   blockCount = 0;
+    uint16_t   usedCount  = 0;
+    uint16_t   peakCount  = 0;
+
+};   //   BlockPool
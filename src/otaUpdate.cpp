@@ -0,0 +1,315 @@
+//--- Streaming OTA into the passive app slot, SHA-256 checked, with first-boot rollback
+
+#include "otaUpdate.h"
+
+#if OTA_UPDATE_ENABLED
+
+#include "logger.h"
+
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_idf_version.h>
+
+//-- mbedtls 3 (IDF 5, Arduino core 3) dropped the _ret suffix
+#if ESP_IDF_VERSION_MAJOR >= 5
+  #define mbedtls_sha256_starts_ret mbedtls_sha256_starts
+  #define mbedtls_sha256_update_ret mbedtls_sha256_update
+  #define mbedtls_sha256_finish_ret mbedtls_sha256_finish
+#endif
+
+//-- survives a software or panic reset (not a power cycle); tells a trial boot
+//-- of a fresh image from a normal one
+struct otaTrialState
+{
+  uint32_t magic;
+  uint32_t trialBoots;
+  uint32_t previousAddress;
+  uint32_t newAddress;
+};
+
+static const uint32_t otaTrialMagic = 0x4F544131;   // "OTA1"
+
+RTC_NOINIT_ATTR static otaTrialState otaTrial;
+
+static bool unconfirmed = false;
+
+static void recordFlashUs(uint32_t &longestUs, uint32_t startUs)
+{
+  uint32_t busyUs = micros() - startUs;
+  if (busyUs > longestUs)
+  {
+    longestUs = busyUs;
+  }
+
+}   //   recordFlashUs()
+
+//-- the bootloader rollback (CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE) is honoured too:
+//-- tell the Arduino core not to confirm a pending image by itself
+extern "C" bool verifyRollbackLater()
+{
+  return true;
+
+}   //   verifyRollbackLater()
+
+static int hexValue(char digit)
+{
+  if (digit >= '0' && digit <= '9')
+  {
+    return digit - '0';
+  }
+  if (digit >= 'a' && digit <= 'f')
+  {
+    return digit - 'a' + 10;
+  }
+  if (digit >= 'A' && digit <= 'F')
+  {
+    return digit - 'A' + 10;
+  }
+  return -1;
+
+}   //   hexValue()
+
+static const esp_partition_t *partitionAt(uint32_t address)
+{
+  const esp_partition_t *candidate = esp_ota_get_next_update_partition(nullptr);
+  if (candidate != nullptr && candidate->address == address)
+  {
+    return candidate;
+  }
+  candidate = esp_ota_get_running_partition();
+  if (candidate != nullptr && candidate->address == address)
+  {
+    return candidate;
+  }
+  return nullptr;
+
+}   //   partitionAt()
+
+bool OtaUpdater::fail(const char *reason)
+{
+  LOG_ERROR("Error: OTA %s at %u of %u bytes.\n", reason, (unsigned)received, (unsigned)expected);
+  abort();
+  return false;
+
+}   //   fail()
+
+bool OtaUpdater::begin(uint32_t imageSize, const char *sha256Hex)
+{
+  if (active)
+  {
+    abort();
+  }
+
+  if (sha256Hex == nullptr || strlen(sha256Hex) != 64)
+  {
+    LOG_ERROR("Error: OTA needs a 64 digit SHA-256.\n");
+    return false;
+  }
+  for (int i = 0; i < 32; i++)
+  {
+    int high = hexValue(sha256Hex[i * 2]);
+    int low  = hexValue(sha256Hex[i * 2 + 1]);
+    if (high < 0 || low < 0)
+    {
+      LOG_ERROR("Error: OTA SHA-256 is not hexadecimal.\n");
+      return false;
+    }
+    expectedHash[i] = (uint8_t)((high << 4) | low);
+  }
+
+  partition = esp_ota_get_next_update_partition(nullptr);
+  if (partition == nullptr)
+  {
+    LOG_ERROR("Error: no passive app slot, the partition table has no app1.\n");
+    return false;
+  }
+  if (imageSize == 0 || imageSize > partition->size)
+  {
+    LOG_ERROR("Error: OTA image of %u bytes does not fit slot [%s] (%u bytes).\n",
+              (unsigned)imageSize, partition->label, (unsigned)partition->size);
+    return false;
+  }
+
+  //-- sequential writes erase sector by sector while the data comes in,
+  //-- instead of one multi-second erase of the whole slot up front
+  esp_err_t result = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &handle);
+  if (result != ESP_OK)
+  {
+    LOG_ERROR("Error: esp_ota_begin() failed (%s).\n", esp_err_to_name(result));
+    return false;
+  }
+
+  mbedtls_sha256_init(&hashContext);
+  mbedtls_sha256_starts_ret(&hashContext, 0);
+
+  expected       = imageSize;
+  received       = 0;
+  lastActivityMs = millis();
+  active         = true;
+  LOG_INFO("Info: OTA into [%s] started, %u bytes.\n", partition->label, (unsigned)imageSize);
+  return true;
+
+}   //   begin()
+
+bool OtaUpdater::write(const uint8_t *data, size_t length)
+{
+  if (!active)
+  {
+    return false;
+  }
+  if (length > expected - received)
+  {
+    return fail("image longer than announced");
+  }
+
+  mbedtls_sha256_update_ret(&hashContext, data, length);
+  uint32_t  startUs = micros();
+  esp_err_t result  = esp_ota_write(handle, data, length);
+  recordFlashUs(longestFlashUs, startUs);
+  if (result != ESP_OK)
+  {
+    return fail("flash write failed");
+  }
+
+  received      += length;
+  lastActivityMs = millis();
+  return true;
+
+}   //   write()
+
+bool OtaUpdater::finish()
+{
+  if (!active)
+  {
+    return false;
+  }
+  if (received != expected)
+  {
+    return fail("image incomplete");
+  }
+
+  uint8_t hash[32];
+  mbedtls_sha256_finish_ret(&hashContext, hash);
+  mbedtls_sha256_free(&hashContext);
+  if (memcmp(hash, expectedHash, sizeof(hash)) != 0)
+  {
+    return fail("SHA-256 mismatch");
+  }
+
+  //-- esp_ota_end() checks the image header and its own checksum
+  uint32_t  startUs = micros();
+  esp_err_t result  = esp_ota_end(handle);
+  active = false;
+  if (result != ESP_OK)
+  {
+    LOG_ERROR("Error: OTA image rejected (%s).\n", esp_err_to_name(result));
+    return false;
+  }
+  result = esp_ota_set_boot_partition(partition);
+  recordFlashUs(longestFlashUs, startUs);
+  if (result != ESP_OK)
+  {
+    LOG_ERROR("Error: cannot select boot slot [%s] (%s).\n", partition->label, esp_err_to_name(result));
+    return false;
+  }
+
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  otaTrial.magic           = otaTrialMagic;
+  otaTrial.trialBoots      = 0;
+  otaTrial.previousAddress = running ? running->address : 0;
+  otaTrial.newAddress      = partition->address;
+
+  LOG_INFO("Info: OTA complete, [%s] boots next.\n", partition->label);
+  return true;
+
+}   //   finish()
+
+void OtaUpdater::abort()
+{
+  if (active)
+  {
+    esp_ota_abort(handle);
+    mbedtls_sha256_free(&hashContext);
+  }
+  active   = false;
+  received = 0;
+
+}   //   abort()
+
+void otaCheckTrialBoot()
+{
+  const esp_partition_t *running = esp_ota_get_running_partition();
+
+  //-- the bootloader marks a fresh image as pending when rollback is built in
+  esp_ota_img_states_t state = ESP_OTA_IMG_UNDEFINED;
+  if (running != nullptr && esp_ota_get_state_partition(running, &state) == ESP_OK
+      && state == ESP_OTA_IMG_PENDING_VERIFY)
+  {
+    unconfirmed = true;
+  }
+
+  //-- without that, the RTC record counts the resets of the new image
+  if (otaTrial.magic == otaTrialMagic && running != nullptr && running->address == otaTrial.newAddress)
+  {
+    unconfirmed = true;
+    otaTrial.trialBoots++;
+    if (otaTrial.trialBoots > OTA_MAX_TRIAL_BOOTS)
+    {
+      const esp_partition_t *previous = partitionAt(otaTrial.previousAddress);
+      otaTrial.magic = 0;
+      if (previous != nullptr && esp_ota_set_boot_partition(previous) == ESP_OK)
+      {
+        LOG_ERROR("Error: new image reset %u times, back to [%s].\n", (unsigned)OTA_MAX_TRIAL_BOOTS, previous->label);
+        logFlushAll();
+        esp_restart();
+      }
+    }
+  }
+  else
+  {
+    otaTrial.magic = 0;
+  }
+
+  if (unconfirmed)
+  {
+    LOG_WARN("Warning: running an unconfirmed OTA image (trial boot %u).\n", (unsigned)otaTrial.trialBoots);
+  }
+
+}   //   otaCheckTrialBoot()
+
+bool otaIsUnconfirmed()
+{
+  return unconfirmed;
+
+}   //   otaIsUnconfirmed()
+
+void otaConfirmBoot(bool healthy)
+{
+  if (!unconfirmed)
+  {
+    return;
+  }
+
+  if (healthy)
+  {
+    esp_ota_mark_app_valid_cancel_rollback();
+    otaTrial.magic = 0;
+    unconfirmed    = false;
+    LOG_INFO("Info: OTA image confirmed.\n");
+    return;
+  }
+
+  LOG_ERROR("Error: OTA image failed its health check, rolling back.\n");
+  logFlushAll();
+  const esp_partition_t *previous = partitionAt(otaTrial.previousAddress);
+  otaTrial.magic = 0;
+  //-- returns only when the bootloader has no pending image to roll back
+  esp_ota_mark_app_invalid_rollback_and_reboot();
+  if (previous != nullptr && esp_ota_set_boot_partition(previous) == ESP_OK)
+  {
+    esp_restart();
+  }
+
+}   //   otaConfirmBoot()
+
+#endif   // OTA_UPDATE_ENABLED
@@ -0,0 +1,93 @@
+//--- Streaming OTA into the passive app slot, SHA-256 checked, with first-boot rollback
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- selected with -DUSE_OTA_UPDATE; needs a partition table with two app slots
+//-- (app0/app1 + otadata, as in partitions_esp32_s3_n8r8.csv)
+#if defined(USE_OTA_UPDATE) && defined(ARDUINO_ARCH_ESP32)
+  #define OTA_UPDATE_ENABLED 1
+#else
+  #define OTA_UPDATE_ENABLED 0
+#endif
+
+#if OTA_UPDATE_ENABLED
+
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+
+//-- bytes taken per write(); also the receive buffer of the serial transport
+#ifndef OTA_CHUNK_SIZE
+  #define OTA_CHUNK_SIZE 256
+#endif
+
+//-- an update that receives nothing for this long is aborted
+#ifndef OTA_IDLE_TIMEOUT_MS
+  #define OTA_IDLE_TIMEOUT_MS 10000
+#endif
+
+//-- assumed duration of one flash write until one has been measured; a write that
+//-- starts a sector erases it first (~45 ms for 4 KB), stalling both caches
+#ifndef OTA_FLASH_BUSY_US
+  #define OTA_FLASH_BUSY_US 50000
+#endif
+
+//-- a new image must run this long (and pass the health check) to be kept
+#ifndef OTA_CONFIRM_AFTER_MS
+  #define OTA_CONFIRM_AFTER_MS 30000
+#endif
+
+//-- resets of an unconfirmed image before the previous slot is booted again
+#ifndef OTA_MAX_TRIAL_BOOTS
+  #define OTA_MAX_TRIAL_BOOTS 3
+#endif
+
+class OtaUpdater
+{
+  public:
+    //-- open the passive slot for an image of imageSize bytes; sha256Hex is 64 hex digits
+    bool begin(uint32_t imageSize, const char *sha256Hex);
+
+    //-- hash and write the next part of the image (any length, in order)
+    bool write(const uint8_t *data, size_t length);
+
+    //-- check size and hash, validate the image and make it the boot slot
+    bool finish();
+
+    //-- drop a running update, the passive slot is left unbootable
+    void abort();
+
+    bool     isActive() const      { return active; }
+    uint32_t receivedBytes() const { return received; }
+    uint32_t imageBytes() const    { return expected; }
+    uint32_t lastWriteMs() const   { return lastActivityMs; }
+    //-- longest flash access of write() or finish() so far, the estimate for the next one
+    uint32_t maxFlashUs() const    { return longestFlashUs; }
+
+  private:
+    bool fail(const char *reason);
+
+    const esp_partition_t  *partition      = nullptr;
+    esp_ota_handle_t        handle         = 0;
+    mbedtls_sha256_context  hashContext;
+    uint8_t                 expectedHash[32];
+    uint32_t                expected       = 0;
+    uint32_t                received       = 0;
+    uint32_t                lastActivityMs = 0;
+    uint32_t                longestFlashUs = OTA_FLASH_BUSY_US;
+    bool                    active         = false;
+
+};   //   OtaUpdater
+
+//-- call early in setup(): counts trial boots of an unconfirmed image and
+//-- goes back to the previous slot when it keeps resetting
+void otaCheckTrialBoot();
+
+//-- true while the running image still has to prove itself
+bool otaIsUnconfirmed();
+
+//-- keep the running image (healthy) or boot the previous one (not healthy)
+void otaConfirmBoot(bool healthy);
+
+#endif   // OTA_UPDATE_ENABLED
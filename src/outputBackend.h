@@ -0,0 +1,234 @@
+//--- Compile-time output backends: every output is a type, a build drives an OutputSet of them
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "pixelFrame.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <soc/gpio_struct.h>
+#endif
+
+//-- every backend offers the same inline interface (no virtual calls):
+//--   begin(), write(on), isOn(), setColor(rgb), setBrightness(level), name()
+//-- calls a backend does not support are empty and vanish after inlining
+
+//-- placeholder for an output that is not part of this build
+class NoOutput
+{
+  public:
+    static const bool present = false;
+
+    void begin() {}
+    void write(bool on) { (void)on; }
+    bool isOn() const { return false; }
+    void setColor(uint32_t color) { (void)color; }
+    void setBrightness(uint8_t level) { (void)level; }
+    const char *name() const { return ""; }
+
+};   //   NoOutput
+
+//-- plain LED on a GPIO; write() is a single set/clear register store
+template <uint8_t PIN, bool ACTIVE_HIGH = true>
+class GpioLedOutput
+{
+  public:
+    static const bool present = true;
+
+    void begin()
+    {
+      pinMode(PIN, OUTPUT);
+      write(false);
+    }
+
+    inline void write(bool on)
+    {
+      state = on;
+      if (on == ACTIVE_HIGH)
+      {
+        setPin();
+      }
+      else
+      {
+        clearPin();
+      }
+    }
+
+    bool isOn() const { return state; }
+    void setColor(uint32_t color) { (void)color; }
+    void setBrightness(uint8_t level) { (void)level; }
+    const char *name() const { return "LED"; }
+
+  private:
+    //-- PIN is a constant, so only one branch of these survives
+    static inline void setPin()
+    {
+#if defined(ARDUINO_ARCH_ESP32)
+      if (PIN < 32) { GPIO.out_w1ts = (1UL << (PIN & 31)); }
+      else          { GPIO.out1_w1ts.val = (1UL << (PIN & 31)); }
+#elif defined(ARDUINO_ARCH_ESP8266)
+      if (PIN < 16) { GPOS = (1UL << PIN); }
+      else          { GP16O |= 1; }
+#else
+      digitalWrite(PIN, HIGH);
+#endif
+    }
+
+    static inline void clearPin()
+    {
+#if defined(ARDUINO_ARCH_ESP32)
+      if (PIN < 32) { GPIO.out_w1tc = (1UL << (PIN & 31)); }
+      else          { GPIO.out1_w1tc.val = (1UL << (PIN & 31)); }
+#elif defined(ARDUINO_ARCH_ESP8266)
+      if (PIN < 16) { GPOC = (1UL << PIN); }
+      else          { GP16O &= ~1UL; }
+#else
+      digitalWrite(PIN, LOW);
+#endif
+    }
+
+    bool state = false;
+
+};   //   GpioLedOutput
+
+#if defined(ARDUINO_ARCH_ESP32)
+//-- LED on a LEDC channel, "on" is shown at the console brightness
+template <uint8_t PIN, uint8_t CHANNEL, uint32_t PWM_FREQ = 5000>
+class LedcLedOutput
+{
+  public:
+    static const bool present = true;
+
+    void begin()
+    {
+      ledcSetup(CHANNEL, PWM_FREQ, 8);
+      ledcAttachPin(PIN, CHANNEL);
+      write(false);
+    }
+
+    inline void write(bool on)
+    {
+      state = on;
+      ledcWrite(CHANNEL, on ? brightness : 0);
+    }
+
+    bool isOn() const { return state; }
+    void setColor(uint32_t color) { (void)color; }
+    void setBrightness(uint8_t level)
+    {
+      brightness = level;
+      write(state);
+    }
+    const char *name() const { return "LED"; }
+
+  private:
+    bool    state      = false;
+    uint8_t brightness = 255;
+
+};   //   LedcLedOutput
+#endif
+
+//-- first pixel of a strip; STRIP is Adafruit_NeoPixel (bit-bang) or RmtNeoPixel,
+//-- the strip object itself is a template argument so no pointer is stored
+//-- write() only changes the strip's PixelFrame; the PixelBatch the frame is
+//-- attached to sends it (and skips the show() when nothing changed)
+template <typename STRIP, STRIP &strip, PixelFrame &frame>
+class NeoPixelOutput
+{
+  public:
+    static const bool present = true;
+
+    void begin()
+    {
+      strip.begin();
+      strip.clear();
+      strip.show();
+      //-- the strip is black now and so is a new frame
+      frame.begin();
+      frame.markClean();
+    }
+
+    inline void write(bool on)
+    {
+      state = on;
+      frame.setPixel(0, on ? color : 0);
+    }
+
+    bool isOn() const { return state; }
+    void setColor(uint32_t newColor) { color = newColor; }
+    void setBrightness(uint8_t level)
+    {
+      //-- the strips scale when a pixel is set: every pixel has to be set again
+      strip.setBrightness(level);
+      frame.markAllDirty();
+    }
+    const char *name() const { return "NeoPixel"; }
+
+  private:
+    bool     state = false;
+    uint32_t color = 0x0000FF;
+
+};   //   NeoPixelOutput
+
+//-- several outputs driven as one; every call is forwarded to each backend in turn
+template <typename... OUTPUTS>
+class OutputSet;
+
+template <>
+class OutputSet<>
+{
+  public:
+    void begin() {}
+    void write(bool on) { (void)on; }
+    void setColor(uint32_t color) { (void)color; }
+    void setBrightness(uint8_t level) { (void)level; }
+
+    //-- calls report(name, isOn) for every present backend
+    template <typename REPORT>
+    void forEachState(REPORT report) const { (void)report; }
+
+};   //   OutputSet<>
+
+template <typename FIRST, typename... REST>
+class OutputSet<FIRST, REST...> : public OutputSet<REST...>
+{
+  public:
+    void begin()
+    {
+      first.begin();
+      OutputSet<REST...>::begin();
+    }
+
+    inline void write(bool on)
+    {
+      first.write(on);
+      OutputSet<REST...>::write(on);
+    }
+
+    void setColor(uint32_t color)
+    {
+      first.setColor(color);
+      OutputSet<REST...>::setColor(color);
+    }
+
+    void setBrightness(uint8_t level)
+    {
+      first.setBrightness(level);
+      OutputSet<REST...>::setBrightness(level);
+    }
+
+    template <typename REPORT>
+    void forEachState(REPORT report) const
+    {
+      if (FIRST::present)
+      {
+        report(first.name(), first.isOn());
+      }
+      OutputSet<REST...>::forEachState(report);
+    }
+
+  private:
+    FIRST first;
+
+};   //   OutputSet
@@ -0,0 +1,145 @@
+//--- Event-driven output state machine: blink ticks, commands and interrupts as queued events
+
+#include "outputMachine.h"
+
+#include <string.h>
+
+//-- next state for [state][event]; a tick only moves a blinking output, a
+//-- command holds a state until "blink" hands the output back to the ticks
+static const uint8_t transitions[OUTPUT_STATE_COUNT][OUTPUT_EVENT_COUNT] =
+{
+  //                   TICK              ON              OFF              TOGGLE           BLINK
+  /* BLINK_OFF */    { OUTPUT_BLINK_ON,  OUTPUT_HOLD_ON, OUTPUT_HOLD_OFF, OUTPUT_HOLD_ON,  OUTPUT_BLINK_OFF },
+  /* BLINK_ON  */    { OUTPUT_BLINK_OFF, OUTPUT_HOLD_ON, OUTPUT_HOLD_OFF, OUTPUT_HOLD_OFF, OUTPUT_BLINK_ON  },
+  /* HOLD_OFF  */    { OUTPUT_HOLD_OFF,  OUTPUT_HOLD_ON, OUTPUT_HOLD_OFF, OUTPUT_HOLD_ON,  OUTPUT_BLINK_OFF },
+  /* HOLD_ON   */    { OUTPUT_HOLD_ON,   OUTPUT_HOLD_ON, OUTPUT_HOLD_OFF, OUTPUT_HOLD_OFF, OUTPUT_BLINK_ON  }
+};
+
+static const char *const eventNames[OUTPUT_EVENT_COUNT] = { "tick", "on", "off", "toggle", "blink" };
+
+void OutputMachine::begin(outputWriter writer, void *writerContext, outputState initial)
+{
+  write   = writer;
+  context = writerContext;
+  current = initial;
+
+}   //   begin()
+
+//-- in IRAM: the button interrupt calls it, also while the flash cache is off
+bool IRAM_ATTR OutputMachine::post(outputSource source, outputEvent event)
+{
+  if (source >= OUTPUT_SOURCE_COUNT || event >= OUTPUT_EVENT_COUNT)
+  {
+    return false;
+  }
+
+  outputEventRecord record;
+  record.event    = (uint8_t)event;
+  record.source   = (uint8_t)source;
+  record.postedUs = micros();
+  if (!queues[source].push(record))
+  {
+    return false;
+  }
+  if (wake != nullptr)
+  {
+    wake(source == OUTPUT_SOURCE_ISR);
+  }
+  return true;
+
+}   //   post()
+
+uint16_t OutputMachine::process()
+{
+  uint16_t          handled = 0;
+  bool              found   = true;
+  outputEventRecord record;
+
+  while (found && handled < OUTPUT_MACHINE_BATCH)
+  {
+    found = false;
+    for (uint8_t source = 0; source < OUTPUT_SOURCE_COUNT && handled < OUTPUT_MACHINE_BATCH; source++)
+    {
+      if (queues[source].pop(record))
+      {
+        handle(record.event, record.postedUs);
+        handled++;
+        found = true;
+      }
+    }
+  }
+  return handled;
+
+}   //   process()
+
+void OutputMachine::handle(uint8_t event, uint32_t postedUs)
+{
+  bool        wasOn = isOn();
+  outputState next  = (outputState)transitions[current][event];
+
+  statistics.processed++;
+  if (next != current)
+  {
+    statistics.transitions++;
+    current = next;
+  }
+  //-- only a change of the level touches the backends
+  if (isOn() != wasOn && write != nullptr)
+  {
+    write(isOn(), context);
+  }
+
+  statistics.lastLatencyUs = micros() - postedUs;
+  if (statistics.lastLatencyUs > statistics.maxLatencyUs)
+  {
+    statistics.maxLatencyUs = statistics.lastLatencyUs;
+  }
+
+}   //   handle()
+
+bool OutputMachine::hasPending() const
+{
+  for (uint8_t source = 0; source < OUTPUT_SOURCE_COUNT; source++)
+  {
+    if (!queues[source].isEmpty())
+    {
+      return true;
+    }
+  }
+  return false;
+
+}   //   hasPending()
+
+outputMachineStats OutputMachine::stats() const
+{
+  outputMachineStats result = statistics;
+  result.dropped            = 0;
+  for (uint8_t source = 0; source < OUTPUT_SOURCE_COUNT; source++)
+  {
+    result.dropped += queues[source].dropped();
+  }
+  return result;
+
+}   //   stats()
+
+const char *OutputMachine::stateName(outputState state)
+{
+  static const char *const names[OUTPUT_STATE_COUNT] = { "blink off", "blink on", "hold off", "hold on" };
+  return (state < OUTPUT_STATE_COUNT) ? names[state] : "?";
+
+}   //   stateName()
+
+bool OutputMachine::parseEvent(const char *name, outputEvent &event)
+{
+  //-- a tick is the output task's own event, not a command
+  for (uint8_t candidate = OUTPUT_EVENT_ON; candidate < OUTPUT_EVENT_COUNT; candidate++)
+  {
+    if (strcmp(name, eventNames[candidate]) == 0)
+    {
+      event = (outputEvent)candidate;
+      return true;
+    }
+  }
+  return false;
+
+}   //   parseEvent()
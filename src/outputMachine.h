@@ -0,0 +1,109 @@
+//--- Event-driven output state machine: blink ticks, commands and interrupts as queued events
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "spscQueue.h"
+
+//-- events waiting per source; a full queue drops (and counts) new events
+#ifndef OUTPUT_QUEUE_LENGTH
+  #define OUTPUT_QUEUE_LENGTH 16
+#endif
+
+//-- most queued events handled by one process() call, bounds its run time
+#ifndef OUTPUT_MACHINE_BATCH
+  #define OUTPUT_MACHINE_BATCH 8
+#endif
+
+enum outputEvent : uint8_t
+{
+  OUTPUT_EVENT_TICK = 0,    // the blink period passed
+  OUTPUT_EVENT_ON,          // hold on
+  OUTPUT_EVENT_OFF,         // hold off
+  OUTPUT_EVENT_TOGGLE,      // hold the opposite state
+  OUTPUT_EVENT_BLINK,       // follow the ticks again
+  OUTPUT_EVENT_COUNT
+};
+
+enum outputState : uint8_t
+{
+  OUTPUT_BLINK_OFF = 0,
+  OUTPUT_BLINK_ON,
+  OUTPUT_HOLD_OFF,
+  OUTPUT_HOLD_ON,
+  OUTPUT_STATE_COUNT
+};
+
+//-- every source has its own queue, so each queue keeps a single producer
+enum outputSource : uint8_t
+{
+  OUTPUT_SOURCE_TASK = 0,   // the loop task: console, network, software timers
+  OUTPUT_SOURCE_ISR,        // one interrupt handler (the button)
+  OUTPUT_SOURCE_COUNT
+};
+
+struct outputEventRecord
+{
+  uint8_t  event;
+  uint8_t  source;
+  uint32_t postedUs;
+};
+
+struct outputMachineStats
+{
+  uint32_t processed;
+  //-- events that changed the state
+  uint32_t transitions;
+  //-- events lost to a full queue
+  uint32_t dropped;
+  //-- time from post() to the transition
+  uint32_t lastLatencyUs;
+  uint32_t maxLatencyUs;
+};
+
+//-- applies a state to the outputs; runs in the consumer task
+typedef void (*outputWriter)(bool isOn, void *context);
+
+//-- wakes the consumer after a post (fromIsr: called from an interrupt)
+typedef void (*outputWakeup)(bool fromIsr);
+
+class OutputMachine
+{
+  public:
+    //-- the outputs already show initial (the writer is called on changes only)
+    void begin(outputWriter writer, void *context, outputState initial = OUTPUT_BLINK_OFF);
+    void setWakeup(outputWakeup wakeup) { wake = wakeup; }
+
+    //-- producer side, ISR-safe and lock-free; one producer per source
+    bool post(outputSource source, outputEvent event);
+
+    //-- consumer side: handle up to OUTPUT_MACHINE_BATCH queued events, the
+    //-- sources take turns; returns the number handled
+    uint16_t process();
+
+    //-- consumer side: handle an event of the consumer itself (the blink tick)
+    void dispatch(outputEvent event) { handle(event, micros()); }
+
+    bool        hasPending() const;
+    outputState state() const      { return current; }
+    bool        isOn() const       { return current == OUTPUT_BLINK_ON || current == OUTPUT_HOLD_ON; }
+    bool        isBlinking() const { return current == OUTPUT_BLINK_OFF || current == OUTPUT_BLINK_ON; }
+
+    outputMachineStats stats() const;
+
+    static const char *stateName(outputState state);
+    //-- "on", "off", "toggle", "blink" (console and network commands)
+    static bool parseEvent(const char *name, outputEvent &event);
+
+  private:
+    void handle(uint8_t event, uint32_t postedUs);
+
+    SpscQueue<outputEventRecord, OUTPUT_QUEUE_LENGTH> queues[OUTPUT_SOURCE_COUNT];
+    outputWriter       write      = nullptr;
+    void              *context    = nullptr;
+    outputWakeup       wake       = nullptr;
+    outputState        current    = OUTPUT_BLINK_OFF;
+    outputMachineStats statistics = {};
+
+};   //   OutputMachine
@@ -0,0 +1,225 @@
+//--- Frame based NeoPixel effects engine (integer / fixed-point only)
+
+#include "pixelEffects.h"
+
+//-- first quarter of a sine wave, 127 * sin(i * pi / 128)
+static const uint8_t quarterSine[65] =
+{
+    0,   3,   6,   9,  12,  16,  19,  22,  25,  28,  31,  34,  37,
+   40,  43,  46,  49,  51,  54,  57,  60,  63,  65,  68,  71,  73,
+   76,  78,  81,  83,  85,  88,  90,  92,  94,  96,  98, 100, 102,
+  104, 106, 107, 109, 111, 112, 113, 115, 116, 117, 118, 120, 121,
+  122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127, 127
+};
+
+//-- 16 entry palettes, interpolated between neighbouring entries
+static const uint32_t palettes[PALETTE_COUNT][16] =
+{
+  //-- PALETTE_RAINBOW
+  {
+    0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00, 0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+    0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5, 0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B
+  },
+  //-- PALETTE_OCEAN
+  {
+    0x000010, 0x000030, 0x000060, 0x001080, 0x0020A0, 0x0040C0, 0x0060E0, 0x0080FF,
+    0x00A0FF, 0x0080FF, 0x0060E0, 0x0040C0, 0x0020A0, 0x001080, 0x000060, 0x000030
+  },
+  //-- PALETTE_FIRE
+  {
+    0x000000, 0x200000, 0x400000, 0x800000, 0xC00000, 0xFF0000, 0xFF2000, 0xFF4000,
+    0xFF6000, 0xFF8000, 0xFFA000, 0xFFC000, 0xFFE000, 0xFFFF00, 0xFFFF40, 0xFFFF80
+  }
+};
+
+uint8_t scale8(uint8_t value, uint8_t scale)
+{
+  return (uint8_t)(((uint16_t)value * ((uint16_t)scale + 1)) >> 8);
+
+}   //   scale8()
+
+uint8_t sin8(uint8_t theta)
+{
+  uint8_t offset = theta & 0x3F;
+  uint8_t index  = (theta & 0x40) ? (uint8_t)(64 - offset) : offset;
+  uint8_t value  = quarterSine[index];
+
+  return (theta & 0x80) ? (uint8_t)(128 - value) : (uint8_t)(128 + value);
+
+}   //   sin8()
+
+uint32_t blendColor(uint32_t colorA, uint32_t colorB, uint8_t amount)
+{
+  uint32_t result = 0;
+
+  for (uint8_t shift = 0; shift <= 16; shift += 8)
+  {
+    int16_t from = (int16_t)((colorA >> shift) & 0xFF);
+    int16_t to   = (int16_t)((colorB >> shift) & 0xFF);
+    int16_t mix  = from + (int16_t)(((to - from) * (int16_t)amount) / 256);
+    result |= (uint32_t)(uint8_t)mix << shift;
+  }
+  return result;
+
+}   //   blendColor()
+
+uint32_t scaleColor(uint32_t color, uint8_t scale)
+{
+  return ((uint32_t)scale8((uint8_t)(color >> 16), scale) << 16)
+         | ((uint32_t)scale8((uint8_t)(color >> 8), scale) << 8)
+         | scale8((uint8_t)color, scale);
+
+}   //   scaleColor()
+
+PixelEffects::PixelEffects(uint8_t *frameBuffer, uint16_t pixelCount)
+  : frame(frameBuffer), pixelCount(pixelCount)
+{
+}   //   PixelEffects()
+
+void PixelEffects::setEffect(const effectConfig &newConfig)
+{
+  config = newConfig;
+  if (config.periodMs == 0)
+  {
+    config.periodMs = 1;
+  }
+  startMs    = millis();
+  firstFrame = true;
+
+}   //   setEffect()
+
+void PixelEffects::setTargetFps(uint8_t fps)
+{
+  if (fps == 0)
+  {
+    fps = 1;
+  }
+  frameMs = 1000 / fps;
+  if (frameMs == 0)
+  {
+    frameMs = 1;
+  }
+
+}   //   setTargetFps()
+
+void PixelEffects::resetStats()
+{
+  statistics = {};
+
+}   //   resetStats()
+
+inline void PixelEffects::setPixel(uint16_t pixel, uint32_t color)
+{
+  uint8_t *target = &frame[pixel * 3];
+  target[0] = (uint8_t)(color >> 16);
+  target[1] = (uint8_t)(color >> 8);
+  target[2] = (uint8_t)color;
+
+}   //   setPixel()
+
+void PixelEffects::renderSolid(uint32_t color)
+{
+  for (uint16_t pixel = 0; pixel < pixelCount; pixel++)
+  {
+    setPixel(pixel, color);
+  }
+
+}   //   renderSolid()
+
+void PixelEffects::renderFade(uint16_t phase)
+{
+  //-- triangle wave: A -> B -> A over one period
+  uint8_t amount = (phase < 0x8000) ? (uint8_t)(phase >> 7) : (uint8_t)((0xFFFF - phase) >> 7);
+  renderSolid(blendColor(config.colorA, config.colorB, amount));
+
+}   //   renderFade()
+
+void PixelEffects::renderBreathe(uint16_t phase)
+{
+  //-- start dark (-90 degrees) and square the level for a more natural curve
+  uint8_t level = sin8((uint8_t)((phase >> 8) - 64));
+  renderSolid(scaleColor(config.colorA, scale8(level, level)));
+
+}   //   renderBreathe()
+
+void PixelEffects::renderChase(uint16_t phase)
+{
+  uint16_t head       = (uint16_t)(((uint32_t)phase * pixelCount) >> 16);
+  uint8_t  tailLength = (config.tailLength == 0) ? 1 : config.tailLength;
+  uint8_t  fadeStep   = (uint8_t)(255 / tailLength);
+
+  for (uint16_t pixel = 0; pixel < pixelCount; pixel++)
+  {
+    uint16_t distance = (head >= pixel) ? (head - pixel) : (uint16_t)(head + pixelCount - pixel);
+    if (distance < tailLength)
+    {
+      setPixel(pixel, scaleColor(config.colorA, (uint8_t)(255 - distance * fadeStep)));
+    }
+    else
+    {
+      setPixel(pixel, config.colorB);
+    }
+  }
+
+}   //   renderChase()
+
+void PixelEffects::renderPalette(uint16_t phase)
+{
+  const uint32_t *palette = palettes[(config.palette < PALETTE_COUNT) ? config.palette : PALETTE_RAINBOW];
+
+  //-- 8.8 fixed-point position in the palette, one full palette over the strip
+  uint16_t position = phase;
+  uint16_t step     = (uint16_t)(0x10000UL / (pixelCount ? pixelCount : 1));
+
+  for (uint16_t pixel = 0; pixel < pixelCount; pixel++)
+  {
+    uint8_t entry    = (uint8_t)(position >> 12);
+    uint8_t fraction = (uint8_t)(position >> 4);
+    setPixel(pixel, blendColor(palette[entry], palette[(entry + 1) & 0x0F], fraction));
+    position += step;
+  }
+
+}   //   renderPalette()
+
+void PixelEffects::renderFrame(uint32_t nowMs)
+{
+  uint32_t renderStartUs = micros();
+
+  if (!firstFrame)
+  {
+    uint32_t gapMs = nowMs - lastFrameMs;
+    if (gapMs >= 2 * frameMs)
+    {
+      statistics.framesDropped += gapMs / frameMs - 1;
+    }
+  }
+  firstFrame  = false;
+  lastFrameMs = nowMs;
+
+  //-- position in the current cycle as a 0..65535 phase
+  uint32_t inCycle = (nowMs - startMs) % config.periodMs;
+  uint16_t phase   = (uint16_t)((inCycle << 16) / config.periodMs);
+
+  switch (config.type)
+  {
+    case EFFECT_OFF:     renderSolid(0);             break;
+    case EFFECT_SOLID:   renderSolid(config.colorA); break;
+    case EFFECT_FADE:    renderFade(phase);          break;
+    case EFFECT_BREATHE: renderBreathe(phase);       break;
+    case EFFECT_CHASE:   renderChase(phase);         break;
+    case EFFECT_PALETTE: renderPalette(phase);       break;
+  }
+
+  if (output != nullptr)
+  {
+    output(frame, pixelCount);
+  }
+
+  statistics.framesRendered++;
+  statistics.lastRenderUs = micros() - renderStartUs;
+  if (statistics.lastRenderUs > statistics.maxRenderUs)
+  {
+    statistics.maxRenderUs = statistics.lastRenderUs;
+  }
+
+}   //   renderFrame()
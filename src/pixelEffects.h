@@ -0,0 +1,103 @@
+//--- Frame based NeoPixel effects engine (integer / fixed-point only)
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- the NeoPixel output runs the effects engine with -DUSE_PIXEL_EFFECTS
+#if defined(USE_NEOPIXEL) && defined(USE_PIXEL_EFFECTS)
+  #define PIXEL_EFFECTS_ENABLED 1
+#else
+  #define PIXEL_EFFECTS_ENABLED 0
+#endif
+
+//-- default frame rate of the effects engine
+#ifndef EFFECTS_TARGET_FPS
+  #define EFFECTS_TARGET_FPS 50
+#endif
+
+enum effectType : uint8_t
+{
+  EFFECT_OFF = 0,
+  EFFECT_SOLID,
+  EFFECT_FADE,
+  EFFECT_BREATHE,
+  EFFECT_CHASE,
+  EFFECT_PALETTE
+};
+
+enum effectPalette : uint8_t
+{
+  PALETTE_RAINBOW = 0,
+  PALETTE_OCEAN,
+  PALETTE_FIRE,
+  PALETTE_COUNT
+};
+
+struct effectConfig
+{
+  effectType    type       = EFFECT_OFF;
+  //-- 0x00RRGGBB
+  uint32_t      colorA     = 0x0000FF;
+  uint32_t      colorB     = 0x000000;
+  //-- duration of one effect cycle
+  uint16_t      periodMs   = 2000;
+  //-- chase: number of trailing pixels
+  uint8_t       tailLength = 4;
+  effectPalette palette    = PALETTE_RAINBOW;
+};
+
+struct effectStats
+{
+  uint32_t framesRendered;
+  uint32_t framesDropped;
+  uint32_t lastRenderUs;
+  uint32_t maxRenderUs;
+};
+
+//-- receives the finished RGB frame (3 bytes per pixel) to send to the strip
+typedef void (*effectOutputCallback)(const uint8_t *rgbFrame, uint16_t pixelCount);
+
+class PixelEffects
+{
+  public:
+    //-- frameBuffer must hold 3 * pixelCount bytes and stays owned by the caller
+    PixelEffects(uint8_t *frameBuffer, uint16_t pixelCount);
+
+    void setOutput(effectOutputCallback callback) { output = callback; }
+    void setEffect(const effectConfig &config);
+    const effectConfig &getEffect() const { return config; }
+    void setTargetFps(uint8_t fps);
+    uint32_t framePeriodMs() const { return frameMs; }
+
+    //-- render one frame for time nowMs and hand it to the output callback
+    void renderFrame(uint32_t nowMs);
+
+    const effectStats &stats() const { return statistics; }
+    void resetStats();
+
+  private:
+    void renderSolid(uint32_t color);
+    void renderFade(uint16_t phase);
+    void renderBreathe(uint16_t phase);
+    void renderChase(uint16_t phase);
+    void renderPalette(uint16_t phase);
+    void setPixel(uint16_t pixel, uint32_t color);
+
+    uint8_t              *frame;
+    uint16_t              pixelCount;
+    effectConfig          config;
+    effectOutputCallback  output      = nullptr;
+    uint32_t              frameMs     = 1000 / EFFECTS_TARGET_FPS;
+    uint32_t              startMs     = 0;
+    uint32_t              lastFrameMs = 0;
+    bool                  firstFrame  = true;
+    effectStats           statistics  = {};
+
+};   //   PixelEffects
+
+//-- 8 bit fixed-point helpers (also used by other pixel code)
+uint8_t  scale8(uint8_t value, uint8_t scale);
+uint8_t  sin8(uint8_t theta);
+uint32_t blendColor(uint32_t colorA, uint32_t colorB, uint8_t amount);
+uint32_t scaleColor(uint32_t color, uint8_t scale);
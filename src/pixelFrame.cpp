@@ -0,0 +1,175 @@
+//--- Pixel framebuffer with dirty-region tracking, batched refresh of several strips
+
+#include "pixelFrame.h"
+#include "logger.h"
+#include "memoryPool.h"
+
+#include <string.h>
+
+PixelFrame::~PixelFrame()
+{
+  memFree(frame, (size_t)pixelCount * 3);
+
+}   //   ~PixelFrame()
+
+bool PixelFrame::begin()
+{
+  if (frame == nullptr)
+  {
+    frame = (uint8_t *)memAllocCold((size_t)pixelCount * 3);
+    if (frame == nullptr)
+    {
+      LOG_ERROR("Error: no memory for a %u pixel frame.\n", (unsigned)pixelCount);
+      return false;
+    }
+  }
+  markAllDirty();
+  return true;
+
+}   //   begin()
+
+inline void PixelFrame::markDirty(uint16_t pixel)
+{
+  if (pixel < dirtyFirst)
+  {
+    dirtyFirst = pixel;
+  }
+  if ((int32_t)pixel > dirtyLast)
+  {
+    dirtyLast = pixel;
+  }
+
+}   //   markDirty()
+
+void PixelFrame::setPixel(uint16_t pixel, uint32_t color)
+{
+  if (pixel >= pixelCount || frame == nullptr)
+  {
+    return;
+  }
+
+  uint8_t *target = &frame[pixel * 3];
+  uint8_t  red    = (uint8_t)(color >> 16);
+  uint8_t  green  = (uint8_t)(color >> 8);
+  uint8_t  blue   = (uint8_t)color;
+
+  if (target[0] == red && target[1] == green && target[2] == blue)
+  {
+    return;
+  }
+  target[0] = red;
+  target[1] = green;
+  target[2] = blue;
+  markDirty(pixel);
+
+}   //   setPixel()
+
+void PixelFrame::fill(uint32_t color)
+{
+  for (uint16_t pixel = 0; pixel < pixelCount; pixel++)
+  {
+    setPixel(pixel, color);
+  }
+
+}   //   fill()
+
+void PixelFrame::copyFrom(const uint8_t *rgbFrame, uint16_t count)
+{
+  if (frame == nullptr)
+  {
+    return;
+  }
+  if (count > pixelCount)
+  {
+    count = pixelCount;
+  }
+
+  //-- find the changed ends, the span between them is copied as one block
+  size_t bytes = (size_t)count * 3;
+  size_t first = 0;
+  while (first < bytes && frame[first] == rgbFrame[first])
+  {
+    first++;
+  }
+  if (first == bytes)
+  {
+    return;
+  }
+  size_t last = bytes - 1;
+  while (last > first && frame[last] == rgbFrame[last])
+  {
+    last--;
+  }
+
+  memcpy(&frame[first], &rgbFrame[first], last - first + 1);
+  markDirty((uint16_t)(first / 3));
+  markDirty((uint16_t)(last / 3));
+
+}   //   copyFrom()
+
+uint32_t PixelFrame::pixel(uint16_t pixel) const
+{
+  if (pixel >= pixelCount || frame == nullptr)
+  {
+    return 0;
+  }
+  const uint8_t *source = &frame[pixel * 3];
+  return ((uint32_t)source[0] << 16) | ((uint32_t)source[1] << 8) | source[2];
+
+}   //   pixel()
+
+void PixelFrame::markAllDirty()
+{
+  if (pixelCount == 0)
+  {
+    return;
+  }
+  dirtyFirst = 0;
+  dirtyLast  = pixelCount - 1;
+
+}   //   markAllDirty()
+
+void PixelFrame::markClean()
+{
+  dirtyFirst = UINT16_MAX;
+  dirtyLast  = -1;
+
+}   //   markClean()
+
+uint8_t PixelBatch::refresh()
+{
+  uint32_t startUs = micros();
+  uint8_t  shown   = 0;
+
+  statistics.refreshes++;
+
+  //-- first every strip gets its data and show() (RMT strips start sending at
+  //-- once, in parallel); a bit-banged strip sends during its own show()
+  for (uint8_t index = 0; index < stripCount; index++)
+  {
+    batchStrip &current = strips[index];
+    if (!current.frame->isDirty())
+    {
+      continue;
+    }
+    statistics.pixelsPushed += (uint32_t)(current.frame->lastDirty() - current.frame->firstDirty() + 1);
+    current.push(current.strip, *current.frame);
+    current.frame->markClean();
+    shown++;
+  }
+
+  if (shown == 0)
+  {
+    statistics.skippedRefreshes++;
+    return 0;
+  }
+
+  statistics.shows        += shown;
+  statistics.lastRefreshUs = micros() - startUs;
+  if (statistics.lastRefreshUs > statistics.maxRefreshUs)
+  {
+    statistics.maxRefreshUs = statistics.lastRefreshUs;
+  }
+  return shown;
+
+}   //   refresh()
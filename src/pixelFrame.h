@@ -0,0 +1,125 @@
+//--- Pixel framebuffer with dirty-region tracking, batched refresh of several strips
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- strips one PixelBatch can refresh together
+#ifndef PIXEL_BATCH_MAX_STRIPS
+  #define PIXEL_BATCH_MAX_STRIPS 4
+#endif
+
+//-- shadow copy of what a strip shows (0xRRGGBB, before brightness); only changed
+//-- pixels are marked, so pushing a frame costs the dirty span, not the strip length
+class PixelFrame
+{
+  public:
+    explicit PixelFrame(uint16_t pixelCount) : pixelCount(pixelCount) {}
+    ~PixelFrame();
+
+    //-- allocate the frame once (cold memory, see memoryPool.h); all black and all dirty
+    bool begin();
+
+    void setPixel(uint16_t pixel, uint32_t color);
+    void fill(uint32_t color);
+    void clear() { fill(0); }
+    //-- take a whole rendered RGB frame (3 bytes per pixel), e.g. from PixelEffects
+    void copyFrom(const uint8_t *rgbFrame, uint16_t count);
+
+    uint32_t pixel(uint16_t pixel) const;
+    uint16_t count() const { return pixelCount; }
+
+    //-- the strip needs every pixel again (brightness changed, strip restarted)
+    void markAllDirty();
+    void markClean();
+    bool isDirty() const { return dirtyFirst <= dirtyLast; }
+    //-- inclusive span of changed pixels, only valid while isDirty()
+    uint16_t firstDirty() const { return dirtyFirst; }
+    uint16_t lastDirty() const { return (uint16_t)dirtyLast; }
+
+  private:
+    void markDirty(uint16_t pixel);
+
+    uint8_t  *frame      = nullptr;
+    uint16_t  pixelCount;
+    uint16_t  dirtyFirst = UINT16_MAX;
+    int32_t   dirtyLast  = -1;
+
+};   //   PixelFrame
+
+struct pixelBatchStats
+{
+  uint32_t refreshes;
+  //-- refreshes that found no strip dirty (no show() at all)
+  uint32_t skippedRefreshes;
+  uint32_t shows;
+  uint32_t pixelsPushed;
+  uint32_t lastRefreshUs;
+  uint32_t maxRefreshUs;
+};
+
+//-- sends a frame with a strip's show(); a strip type that can send a prefix
+//-- of the chain (RmtNeoPixel) gets an overload, the rest send everything
+template <typename STRIP>
+inline void pixelStripShow(STRIP &strip, uint16_t pixels)
+{
+  (void)pixels;
+  strip.show();
+
+}   //   pixelStripShow()
+
+//-- all strips of the build, refreshed from one scheduled call
+class PixelBatch
+{
+  public:
+    //-- register a frame and the strip it belongs to; returns false when full
+    template <typename STRIP>
+    bool attach(PixelFrame &frame, STRIP &strip)
+    {
+      if (stripCount >= PIXEL_BATCH_MAX_STRIPS)
+      {
+        return false;
+      }
+      strips[stripCount].frame = &frame;
+      strips[stripCount].strip = &strip;
+      strips[stripCount].push  = &pushTo<STRIP>;
+      stripCount++;
+      return true;
+    }
+
+    //-- push the dirty span of every frame to its strip and show it;
+    //-- strips without changes are not touched; returns the strips shown
+    uint8_t refresh();
+
+    const pixelBatchStats &stats() const { return statistics; }
+
+  private:
+    typedef void (*pushCallback)(void *strip, PixelFrame &frame);
+
+    template <typename STRIP>
+    static void pushTo(void *stripPointer, PixelFrame &frame)
+    {
+      STRIP   &strip = *(STRIP *)stripPointer;
+      uint16_t last  = frame.lastDirty();
+
+      for (uint16_t pixel = frame.firstDirty(); pixel <= last; pixel++)
+      {
+        uint32_t color = frame.pixel(pixel);
+        strip.setPixelColor(pixel, (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color);
+      }
+      //-- a WS2812 chain keeps what it does not receive: send up to the last change
+      pixelStripShow(strip, (uint16_t)(last + 1));
+    }
+
+    struct batchStrip
+    {
+      PixelFrame   *frame;
+      void         *strip;
+      pushCallback  push;
+    };
+
+    batchStrip      strips[PIXEL_BATCH_MAX_STRIPS];
+    uint8_t         stripCount = 0;
+    pixelBatchStats statistics = {};
+
+};   //   PixelBatch
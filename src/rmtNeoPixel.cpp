@@ -0,0 +1,231 @@
+//--- ESP32 only: RMT driven, double-buffered WS2812 (NeoPixel) output
+
+#include "rmtNeoPixel.h"
+
+#if NEOPIXEL_RMT_ENABLED
+
+#include "logger.h"
+#include "memoryPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//-- 80 MHz APB / 2 = 25 ns per RMT tick
+static const uint8_t  RMT_CLOCK_DIV = 2;
+static const uint16_t WS2812_T0H    = 16;   //   0.40 us
+static const uint16_t WS2812_T0L    = 34;   //   0.85 us
+static const uint16_t WS2812_T1H    = 32;   //   0.80 us
+static const uint16_t WS2812_T1L    = 18;   //   0.45 us
+
+//-- micros() at the end of the last frame per channel, set from the RMT ISR
+static volatile uint32_t txEndUs[RMT_CHANNEL_MAX] = {};
+
+//-- the ISR is installed with ESP_INTR_FLAG_IRAM so it keeps refilling the RMT
+//-- while the fs worker writes flash (cache off): the callbacks, their data and
+//-- the frame buffers must all be in internal RAM, never flash or PSRAM
+
+//-- runs in the RMT ISR (one callback for every channel)
+static void IRAM_ATTR ws2812TxEnd(rmt_channel_t channel, void *argument)
+{
+  (void)argument;
+  if (channel < RMT_CHANNEL_MAX)
+  {
+    txEndUs[channel] = micros();
+  }
+
+}   //   ws2812TxEnd()
+
+//-- runs in the RMT ISR: expand frame bytes into RMT items, MSB first
+static void IRAM_ATTR ws2812Translator(
+  const void   *source,
+  rmt_item32_t *destination,
+  size_t        sourceSize,
+  size_t        wantedItems,
+  size_t       *translatedSize,
+  size_t       *itemCount
+)
+{
+  static const DRAM_ATTR rmt_item32_t bitZero = {{{ WS2812_T0H, 1, WS2812_T0L, 0 }}};
+  static const DRAM_ATTR rmt_item32_t bitOne  = {{{ WS2812_T1H, 1, WS2812_T1L, 0 }}};
+
+  const uint8_t *sourceBytes = (const uint8_t *)source;
+  size_t         bytesDone   = 0;
+  size_t         itemsDone   = 0;
+
+  while (bytesDone < sourceSize && itemsDone + 8 <= wantedItems)
+  {
+    uint8_t value = sourceBytes[bytesDone];
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      destination->val = (value & 0x80) ? bitOne.val : bitZero.val;
+      value <<= 1;
+      destination++;
+    }
+    itemsDone += 8;
+    bytesDone++;
+  }
+
+  *translatedSize = bytesDone;
+  *itemCount      = itemsDone;
+
+}   //   ws2812Translator()
+
+RmtNeoPixel::RmtNeoPixel(uint16_t pixelCount, uint8_t pin, rmt_channel_t channel)
+  : pixelCount(pixelCount), pin(pin), channel(channel)
+{
+}   //   RmtNeoPixel()
+
+RmtNeoPixel::~RmtNeoPixel()
+{
+  if (started)
+  {
+    rmt_driver_uninstall(channel);
+  }
+  memFree(frontBuffer, (size_t)pixelCount * 3);
+  memFree(backBuffer, (size_t)pixelCount * 3);
+
+}   //   ~RmtNeoPixel()
+
+bool RmtNeoPixel::begin()
+{
+  if (started)
+  {
+    return true;
+  }
+
+  size_t frameBytes = (size_t)pixelCount * 3;
+  //-- the translator reads the front buffer from the ISR, also during flash writes
+  frontBuffer = (uint8_t *)memAllocHot(frameBytes);
+  backBuffer  = (uint8_t *)memAllocHot(frameBytes);
+  if (frontBuffer == nullptr || backBuffer == nullptr)
+  {
+    LOG_ERROR("Error: no memory for %u NeoPixel frame buffers.\n", (unsigned)pixelCount);
+    return false;
+  }
+
+  rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)pin, channel);
+  config.clk_div = RMT_CLOCK_DIV;
+
+  if (rmt_config(&config) != ESP_OK
+      || rmt_driver_install(channel, 0, ESP_INTR_FLAG_IRAM) != ESP_OK
+      || rmt_translator_init(channel, ws2812Translator) != ESP_OK)
+  {
+    LOG_ERROR("Error: could not set up RMT channel %d for NeoPixel.\n", (int)channel);
+    return false;
+  }
+  rmt_register_tx_end_callback(ws2812TxEnd, nullptr);
+
+  started = true;
+  return true;
+
+}   //   begin()
+
+void RmtNeoPixel::setBrightness(uint8_t newBrightness)
+{
+  brightness = newBrightness;
+
+}   //   setBrightness()
+
+void RmtNeoPixel::clear()
+{
+  if (backBuffer != nullptr)
+  {
+    memset(backBuffer, 0, (size_t)pixelCount * 3);
+  }
+
+}   //   clear()
+
+void RmtNeoPixel::setPixelColor(uint16_t pixel, uint8_t red, uint8_t green, uint8_t blue)
+{
+  if (pixel >= pixelCount || backBuffer == nullptr)
+  {
+    return;
+  }
+
+  //-- scale like Adafruit_NeoPixel does: (value * (brightness + 1)) >> 8
+  uint16_t scale = (uint16_t)brightness + 1;
+  uint8_t *target = &backBuffer[pixel * 3];
+  target[0] = (uint8_t)((green * scale) >> 8);
+  target[1] = (uint8_t)((red * scale) >> 8);
+  target[2] = (uint8_t)((blue * scale) >> 8);
+
+}   //   setPixelColor()
+
+void RmtNeoPixel::setPixelColor(uint16_t pixel, uint32_t color)
+{
+  setPixelColor(pixel, (uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color);
+
+}   //   setPixelColor()
+
+bool RmtNeoPixel::isBusy() const
+{
+  return started && (rmt_wait_tx_done(channel, 0) != ESP_OK);
+
+}   //   isBusy()
+
+bool RmtNeoPixel::canShow() const
+{
+  if (!started || isBusy())
+  {
+    return false;
+  }
+  return ((micros() - txEndUs[channel]) >= NEOPIXEL_LATCH_US);
+
+}   //   canShow()
+
+bool RmtNeoPixel::startFrame()
+{
+  //-- swap: the finished front buffer becomes the new back buffer and gets
+  //-- a copy of the frame so callers can keep drawing incrementally
+  uint8_t *sendBuffer = backBuffer;
+  backBuffer          = frontBuffer;
+  frontBuffer         = sendBuffer;
+  memcpy(backBuffer, frontBuffer, (size_t)pixelCount * 3);
+
+  size_t sendBytes = (size_t)sendLength * 3;
+  pendingShow = false;
+  sendLength  = 0;
+  return (rmt_write_sample(channel, frontBuffer, sendBytes, false) == ESP_OK);
+
+}   //   startFrame()
+
+void RmtNeoPixel::show(uint16_t sendPixels)
+{
+  if (!started)
+  {
+    return;
+  }
+  if (sendPixels > pixelCount)
+  {
+    sendPixels = pixelCount;
+  }
+  if (sendPixels > sendLength)
+  {
+    sendLength = sendPixels;
+  }
+
+  if (!canShow())
+  {
+    if (pendingShow)
+    {
+      skipped++;
+    }
+    pendingShow = true;
+    return;
+  }
+
+  startFrame();
+
+}   //   show()
+
+bool RmtNeoPixel::poll()
+{
+  if (pendingShow && canShow())
+  {
+    startFrame();
+  }
+  return pendingShow;
+
+}   //   poll()
+
+#endif   //   NEOPIXEL_RMT_ENABLED
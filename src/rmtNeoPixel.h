@@ -0,0 +1,98 @@
+//--- ESP32 only: RMT driven, double-buffered WS2812 (NeoPixel) output
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "boardCaps.h"
+
+//-- used for -DUSE_NEOPIXEL on every board with an RMT peripheral (boardCaps.h);
+//-- -DUSE_NEOPIXEL_BITBANG selects the Adafruit_NeoPixel driver instead
+#if defined(ARDUINO_ARCH_ESP32) && defined(USE_NEOPIXEL) && (defined(USE_NEOPIXEL_RMT) || BOARD_AUTO_NEOPIXEL_RMT)
+  #define NEOPIXEL_RMT_ENABLED 1
+#else
+  #define NEOPIXEL_RMT_ENABLED 0
+#endif
+
+#if NEOPIXEL_RMT_ENABLED
+
+#include <driver/rmt.h>
+
+#ifndef NEOPIXEL_RMT_CHANNEL
+  #define NEOPIXEL_RMT_CHANNEL RMT_CHANNEL_0
+#endif
+
+//-- low time after a frame before the next one may start, or the pixels take
+//-- both as one frame; WS2812B from 2017 on need 280 us (older parts 50 us)
+#ifndef NEOPIXEL_LATCH_US
+  #define NEOPIXEL_LATCH_US 300
+#endif
+
+//-- drop-in for the part of Adafruit_NeoPixel this firmware uses; show() only
+//-- queues the frame, the RMT peripheral clocks it out without the CPU
+class RmtNeoPixel
+{
+  public:
+    RmtNeoPixel(uint16_t pixelCount, uint8_t pin, rmt_channel_t channel = NEOPIXEL_RMT_CHANNEL);
+    ~RmtNeoPixel();
+
+    bool begin();
+    void setBrightness(uint8_t newBrightness);
+    uint8_t getBrightness() const { return brightness; }
+    void clear();
+    void setPixelColor(uint16_t pixel, uint32_t color);
+    void setPixelColor(uint16_t pixel, uint8_t red, uint8_t green, uint8_t blue);
+    uint16_t numPixels() const { return pixelCount; }
+
+    //-- hand the back buffer to the RMT and return at once; if a frame is
+    //-- still being sent (or latching) the newest frame is sent by the next show()/poll()
+    void show() { show(pixelCount); }
+
+    //-- same, but clock out only the first sendPixels pixels; the rest of the
+    //-- chain keeps its colours (pixelFrame.h sends up to the last change)
+    void show(uint16_t sendPixels);
+
+    //-- send a frame postponed by show() once the RMT is idle and the strip latched;
+    //-- returns true while a frame is still waiting
+    bool poll();
+
+    //-- true while the RMT is still clocking out a frame
+    bool isBusy() const;
+
+    //-- idle and NEOPIXEL_LATCH_US past the end of the last frame (Adafruit's canShow())
+    bool canShow() const;
+
+    //-- frames replaced by a newer one before they could be sent
+    uint32_t skippedFrames() const { return skipped; }
+
+    static uint32_t Color(uint8_t red, uint8_t green, uint8_t blue)
+    {
+      return ((uint32_t)red << 16) | ((uint32_t)green << 8) | blue;
+    }
+
+  private:
+    bool startFrame();
+
+    uint16_t      pixelCount;
+    uint8_t       pin;
+    rmt_channel_t channel;
+    uint8_t       brightness   = 255;
+    bool          started      = false;
+    bool          pendingShow  = false;
+    //-- pixels the next frame sends; pending frames merge to the longest
+    uint16_t      sendLength   = 0;
+    uint32_t      skipped      = 0;
+    //-- GRB byte frames: the RMT reads frontBuffer, setPixelColor() writes backBuffer
+    uint8_t      *frontBuffer  = nullptr;
+    uint8_t      *backBuffer   = nullptr;
+
+};   //   RmtNeoPixel
+
+//-- PixelBatch (pixelFrame.h) sends only the changed prefix of an RMT strip
+inline void pixelStripShow(RmtNeoPixel &strip, uint16_t pixels)
+{
+  strip.show(pixels);
+
+}   //   pixelStripShow()
+
+#endif   //   NEOPIXEL_RMT_ENABLED
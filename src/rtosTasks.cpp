@@ -0,0 +1,291 @@
+//--- ESP32 only: output toggle and filesystem work as separate FreeRTOS tasks
+
+#include "rtosTasks.h"
+#include "logger.h"
+
+#if RTOS_TASKS_ENABLED
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+
+//-- single core targets run both tasks on core 0
+#ifdef CONFIG_FREERTOS_UNICORE
+  #undef  RTOS_OUTPUT_CORE
+  #undef  RTOS_FS_WORKER_CORE
+  #define RTOS_OUTPUT_CORE    0
+  #define RTOS_FS_WORKER_CORE 0
+#endif
+
+static QueueHandle_t         fsQueue           = nullptr;
+static outputCallback        outputHandler     = nullptr;
+static outputCallback        eventHandler      = nullptr;
+static outputServiceCallback serviceHandler    = nullptr;
+static TaskHandle_t          outputTaskHandle  = nullptr;
+static fsCommandCallback     fsHandler         = nullptr;
+static volatile uint32_t     outputPeriodMs    = 1000;
+static uint32_t              reportToggleCount = 0;
+
+//-- written by the output task only; the deadline is absolute (previous + period)
+static volatile uint32_t outputDeadlineUs   = 0;
+static volatile uint32_t outputToggles      = 0;
+static volatile uint32_t outputMaxLateUs    = 0;
+static schedulerTiming   outputTimingStats  = {};
+static volatile bool     outputTimingReset  = false;
+//-- written by the filesystem worker only
+static volatile uint32_t fsHeldCount        = 0;
+
+static void outputTask(void *parameter)
+{
+  (void)parameter;
+  uint32_t toggleCount = 0;
+
+  outputDeadlineUs = micros() + outputPeriodMs * 1000UL;
+
+  for (;;)
+  {
+    //-- sleep until shortly before the toggle; an event notification ends the
+    //-- wait early, runs the event handler and leaves the deadline as it is;
+    //-- pending service work shortens the sleep to one tick
+    bool       servicePending = (serviceHandler != nullptr) && serviceHandler();
+    int32_t    untilUs        = (int32_t)(outputDeadlineUs - micros());
+    TickType_t wait           = (untilUs > SCHEDULER_SPIN_US) ? pdMS_TO_TICKS((untilUs - SCHEDULER_SPIN_US) / 1000) : 0;
+    if (servicePending && wait > 1)
+    {
+      wait = 1;
+    }
+    if (wait > 0)
+    {
+      if (ulTaskNotifyTake(pdTRUE, wait) > 0 && eventHandler != nullptr)
+      {
+        eventHandler();
+      }
+      continue;
+    }
+
+    //-- the last stretch is a busy wait, the next tick could be too late
+    while ((int32_t)(outputDeadlineUs - micros()) > 0)
+    {
+    }
+    uint32_t lateUs = micros() - outputDeadlineUs;
+
+    //-- the next deadline follows from this one, not from when the toggle ran;
+    //-- more than a period behind re-bases on now instead of catching up
+    outputDeadlineUs += outputPeriodMs * 1000UL;
+    if ((int32_t)(micros() - outputDeadlineUs) >= 0)
+    {
+      outputDeadlineUs = micros() + outputPeriodMs * 1000UL;
+    }
+
+    outputHandler();
+
+    if (outputTimingReset)
+    {
+      outputTimingStats = schedulerTiming();
+      fsHeldCount       = 0;
+      outputTimingReset = false;
+    }
+    schedulerRecordLate(outputTimingStats, lateUs, outputMaxLateUs);
+    outputToggles++;
+
+    if (reportToggleCount > 0 && ++toggleCount >= reportToggleCount)
+    {
+      toggleCount = 0;
+      postFsCommand(FS_CMD_REPORT);
+    }
+  }
+
+}   //   outputTask()
+
+//-- time left before work would make the next toggle later than the bound
+static int64_t outputSlackUs()
+{
+  return (int64_t)(int32_t)(outputDeadlineUs - micros()) + outputMaxLateUs;
+
+}   //   outputSlackUs()
+
+//-- hold a command back while it could make the next toggle late; once a
+//-- toggle ran it goes ahead, it would not fit any better later
+static void waitForOutputRoom(uint32_t workUs)
+{
+  if (outputTaskHandle == nullptr || outputMaxLateUs == 0)
+  {
+    return;
+  }
+
+  uint32_t togglesAtStart = outputToggles;
+  bool     held           = false;
+  for (;;)
+  {
+    if (outputSlackUs() >= (int64_t)workUs || outputToggles != togglesAtStart)
+    {
+      return;
+    }
+    if (!held)
+    {
+      held = true;
+      fsHeldCount++;
+    }
+    vTaskDelay(1);
+  }
+
+}   //   waitForOutputRoom()
+
+static void fsWorkerTask(void *parameter)
+{
+  (void)parameter;
+  fsWorkerCommand command;
+  //-- longest run per command, the estimate for the next one
+  uint32_t        maxRunUs[FS_CMD_EVENTS + 1] = {};
+
+  for (;;)
+  {
+    if (xQueueReceive(fsQueue, &command, portMAX_DELAY) != pdTRUE || command > FS_CMD_EVENTS)
+    {
+      continue;
+    }
+    waitForOutputRoom(maxRunUs[command]);
+
+    uint32_t startUs = micros();
+    fsHandler(command);
+    uint32_t runUs = micros() - startUs;
+    if (runUs > maxRunUs[command])
+    {
+      maxRunUs[command] = runUs;
+    }
+  }
+
+}   //   fsWorkerTask()
+
+bool startRtosTasks(
+  outputCallback    toggleCallback,
+  fsCommandCallback fsCallback,
+  uint32_t          periodMs,
+  uint32_t          reportEveryToggles
+)
+{
+  if (fsCallback == nullptr)
+  {
+    return false;
+  }
+
+  outputHandler     = toggleCallback;
+  fsHandler         = fsCallback;
+  outputPeriodMs    = periodMs;
+  reportToggleCount = reportEveryToggles;
+
+  fsQueue = xQueueCreate(RTOS_FS_QUEUE_LENGTH, sizeof(fsWorkerCommand));
+  if (fsQueue == nullptr)
+  {
+    LOG_ERROR("Error: could not create filesystem queue.\n");
+    return false;
+  }
+
+  if (xTaskCreatePinnedToCore(
+        fsWorkerTask, "fsWorker", RTOS_FS_WORKER_STACK, nullptr,
+        RTOS_FS_WORKER_PRIORITY, nullptr, RTOS_FS_WORKER_CORE) != pdPASS)
+  {
+    LOG_ERROR("Error: could not start filesystem worker task.\n");
+    return false;
+  }
+
+  if (toggleCallback != nullptr
+      && xTaskCreatePinnedToCore(
+           outputTask, "output", RTOS_OUTPUT_STACK, nullptr,
+           RTOS_OUTPUT_PRIORITY, &outputTaskHandle, RTOS_OUTPUT_CORE) != pdPASS)
+  {
+    LOG_ERROR("Error: could not start output task.\n");
+    return false;
+  }
+
+  LOG_INFO(
+    "Info: output task on core %d, filesystem worker on core %d\n",
+    RTOS_OUTPUT_CORE,
+    RTOS_FS_WORKER_CORE
+  );
+  return true;
+
+}   //   startRtosTasks()
+
+void setRtosOutputPeriod(uint32_t periodMs)
+{
+  if (periodMs > 0)
+  {
+    outputPeriodMs = periodMs;
+  }
+
+}   //   setRtosOutputPeriod()
+
+void setRtosOutputEventHandler(outputCallback eventCallback)
+{
+  eventHandler = eventCallback;
+
+}   //   setRtosOutputEventHandler()
+
+void setRtosOutputServiceHandler(outputServiceCallback serviceCallback)
+{
+  serviceHandler = serviceCallback;
+
+}   //   setRtosOutputServiceHandler()
+
+void IRAM_ATTR wakeRtosOutputTask(bool fromIsr)
+{
+  if (outputTaskHandle == nullptr)
+  {
+    return;
+  }
+  if (!fromIsr)
+  {
+    xTaskNotifyGive(outputTaskHandle);
+    return;
+  }
+  BaseType_t higherPriorityWoken = pdFALSE;
+  vTaskNotifyGiveFromISR(outputTaskHandle, &higherPriorityWoken);
+  if (higherPriorityWoken == pdTRUE)
+  {
+    portYIELD_FROM_ISR();
+  }
+
+}   //   wakeRtosOutputTask()
+
+void setRtosOutputBound(uint32_t maxLateUs)
+{
+  outputMaxLateUs = maxLateUs;
+
+}   //   setRtosOutputBound()
+
+bool rtosOutputHasRoomFor(uint32_t workUs)
+{
+  if (outputTaskHandle == nullptr || outputMaxLateUs == 0)
+  {
+    return true;
+  }
+  return (outputSlackUs() >= (int64_t)workUs);
+
+}   //   rtosOutputHasRoomFor()
+
+void rtosOutputTiming(schedulerTiming &timing)
+{
+  timing          = outputTimingStats;
+  timing.deferred = fsHeldCount;
+
+}   //   rtosOutputTiming()
+
+void resetRtosOutputTiming()
+{
+  //-- cleared by the output task itself, at its next toggle
+  outputTimingReset = true;
+
+}   //   resetRtosOutputTiming()
+
+bool postFsCommand(fsWorkerCommand command)
+{
+  if (fsQueue == nullptr)
+  {
+    return false;
+  }
+  return (xQueueSend(fsQueue, &command, 0) == pdTRUE);
+
+}   //   postFsCommand()
+
+#endif   //   RTOS_TASKS_ENABLED
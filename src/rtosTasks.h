@@ -0,0 +1,110 @@
+//--- ESP32 only: output toggle and filesystem work as separate FreeRTOS tasks
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "boardCaps.h"
+#include "taskScheduler.h"
+
+//-- the dual task mode is only available on ESP32 builds; dual-core boards get it
+//-- by default (boardCaps.h), -DUSE_RTOS_TASKS forces it on a single-core one
+#if defined(ARDUINO_ARCH_ESP32) && (defined(USE_RTOS_TASKS) || BOARD_AUTO_RTOS_TASKS)
+  #define RTOS_TASKS_ENABLED 1
+#else
+  #define RTOS_TASKS_ENABLED 0
+#endif
+
+#if RTOS_TASKS_ENABLED
+
+//-- core the output task is pinned to (the Arduino loop core)
+#ifndef RTOS_OUTPUT_CORE
+  #define RTOS_OUTPUT_CORE 1
+#endif
+
+//-- core the filesystem worker is pinned to (the protocol core)
+#ifndef RTOS_FS_WORKER_CORE
+  #define RTOS_FS_WORKER_CORE 0
+#endif
+
+#ifndef RTOS_OUTPUT_PRIORITY
+  #define RTOS_OUTPUT_PRIORITY 5
+#endif
+
+#ifndef RTOS_FS_WORKER_PRIORITY
+  #define RTOS_FS_WORKER_PRIORITY 1
+#endif
+
+#ifndef RTOS_OUTPUT_STACK
+  #define RTOS_OUTPUT_STACK 4096
+#endif
+
+#ifndef RTOS_FS_WORKER_STACK
+  #define RTOS_FS_WORKER_STACK 6144
+#endif
+
+//-- number of pending filesystem commands the queue can hold
+#ifndef RTOS_FS_QUEUE_LENGTH
+  #define RTOS_FS_QUEUE_LENGTH 4
+#endif
+
+enum fsWorkerCommand : uint8_t
+{
+  FS_CMD_REPORT = 0,
+  FS_CMD_USAGE,
+  FS_CMD_LIST,
+  FS_CMD_INVALIDATE,
+  FS_CMD_BOOT,
+  FS_CMD_EVENTS
+};
+
+typedef void (*outputCallback)();
+typedef bool (*outputServiceCallback)();
+typedef void (*fsCommandCallback)(fsWorkerCommand command);
+
+//-- start the output task and the filesystem worker
+//-- every reportEveryToggles toggles the output task posts FS_CMD_REPORT
+//-- the first toggle happens one period after the start (setup() did one already)
+//-- with toggleCallback == nullptr only the filesystem worker is started
+bool startRtosTasks(
+  outputCallback    toggleCallback,
+  fsCommandCallback fsCallback,
+  uint32_t          periodMs,
+  uint32_t          reportEveryToggles
+);
+
+//-- change the toggle period, takes effect after the current period
+void setRtosOutputPeriod(uint32_t periodMs);
+
+//-- called by the output task when it is woken between two toggles (queued
+//-- output events); set it before startRtosTasks()
+void setRtosOutputEventHandler(outputCallback eventCallback);
+
+//-- called by the output task on every wake-up; while it returns true (work left,
+//-- e.g. a postponed strip frame) the task wakes again after one tick. Set it
+//-- before startRtosTasks()
+void setRtosOutputServiceHandler(outputServiceCallback serviceCallback);
+
+//-- wake the output task for its event handler; ISR-safe with fromIsr
+void wakeRtosOutputTask(bool fromIsr);
+
+//-- most a toggle may be late: the filesystem worker holds back a command whose
+//-- longest run so far could stall the toggle past it (flash access stops the
+//-- caches of both cores); 0 = no bound. Set it before startRtosTasks()
+void setRtosOutputBound(uint32_t maxLateUs);
+
+//-- the same check without waiting, for flash work outside the worker (OTA
+//-- writes from loop()): true while workUs fits before the next toggle could be
+//-- late, or when there is no bound
+bool rtosOutputHasRoomFor(uint32_t workUs);
+
+//-- lateness of the toggles against their deadlines; deferred counts the
+//-- filesystem commands held back for them (a copy, taken without a lock)
+void rtosOutputTiming(schedulerTiming &timing);
+void resetRtosOutputTiming();
+
+//-- hand a command to the filesystem worker without blocking
+//-- returns false when the queue is full
+bool postFsCommand(fsWorkerCommand command);
+
+#endif   //   RTOS_TASKS_ENABLED
@@ -0,0 +1,221 @@
+//--- Runtime metrics: loop latency histogram, output jitter, heap and FS timings
+
+#include "runtimeMetrics.h"
+#include "logger.h"
+#include "memoryPool.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+static uint32_t      loopHistogram[METRICS_HISTOGRAM_BUCKETS];
+static uint32_t      loopCount       = 0;
+static uint32_t      loopMaxUs       = 0;
+
+static uint32_t      lastTickUs      = 0;
+static bool          haveLastTick    = false;
+static uint32_t      jitterCount     = 0;
+static uint32_t      jitterLastUs    = 0;
+static uint32_t      jitterMaxUs     = 0;
+static uint64_t      jitterSumUs     = 0;
+
+static uint32_t      heapFree        = 0;
+static uint32_t      heapMinFree     = UINT32_MAX;
+static uint32_t      heapLargest     = 0;
+static memoryStats   memory          = {};
+
+static metricsTiming fsTimings[METRICS_FS_COUNT];
+static const char   *fsTimingNames[METRICS_FS_COUNT] = { "mount", "list", "usage", "index" };
+
+//-- floor(log2(value)) for value > 0, else 0
+static inline uint8_t log2Bucket(uint32_t value)
+{
+  uint8_t bucket = 0;
+  while (value > 1 && bucket < METRICS_HISTOGRAM_BUCKETS - 1)
+  {
+    value >>= 1;
+    bucket++;
+  }
+  return bucket;
+
+}   //   log2Bucket()
+
+void metricsLoopTime(uint32_t durationUs)
+{
+  loopHistogram[log2Bucket(durationUs)]++;
+  loopCount++;
+  if (durationUs > loopMaxUs)
+  {
+    loopMaxUs = durationUs;
+  }
+
+}   //   metricsLoopTime()
+
+void metricsOutputTick(uint32_t periodMs)
+{
+  uint32_t nowUs = micros();
+
+  if (haveLastTick)
+  {
+    uint32_t intervalUs = nowUs - lastTickUs;
+    uint32_t periodUs   = periodMs * 1000;
+    uint32_t jitterUs   = (intervalUs > periodUs) ? (intervalUs - periodUs) : (periodUs - intervalUs);
+
+    jitterLastUs  = jitterUs;
+    jitterSumUs  += jitterUs;
+    jitterCount++;
+    if (jitterUs > jitterMaxUs)
+    {
+      jitterMaxUs = jitterUs;
+    }
+  }
+
+  lastTickUs   = nowUs;
+  haveLastTick = true;
+
+}   //   metricsOutputTick()
+
+void metricsFsTime(metricsFsOperation operation, uint32_t durationUs)
+{
+  if (operation >= METRICS_FS_COUNT)
+  {
+    return;
+  }
+  metricsTiming &timing = fsTimings[operation];
+  timing.count++;
+  timing.lastUs = durationUs;
+  if (durationUs > timing.maxUs)
+  {
+    timing.maxUs = durationUs;
+  }
+
+}   //   metricsFsTime()
+
+void metricsSampleHeap()
+{
+  //-- "heap" is the internal RAM only; PSRAM is reported apart in "mem"
+  memGetStats(memory);
+  heapFree    = memory.internalFree;
+  heapLargest = memory.internalLargest;
+#if defined(ARDUINO_ARCH_ESP32)
+  heapMinFree = memory.internalMinFree;
+#else
+  if (heapFree < heapMinFree)
+  {
+    heapMinFree = heapFree;
+  }
+#endif
+
+}   //   metricsSampleHeap()
+
+void metricsReset()
+{
+  memset(loopHistogram, 0, sizeof(loopHistogram));
+  memset(fsTimings, 0, sizeof(fsTimings));
+  loopCount    = 0;
+  loopMaxUs    = 0;
+  haveLastTick = false;
+  jitterCount  = 0;
+  jitterLastUs = 0;
+  jitterMaxUs  = 0;
+  jitterSumUs  = 0;
+
+}   //   metricsReset()
+
+//-- snprintf that never moves length past the end of the buffer
+static size_t appendFormat(char *buffer, size_t bufferSize, size_t length, const char *format, ...)
+{
+  if (length >= bufferSize)
+  {
+    return length;
+  }
+
+  va_list arguments;
+  va_start(arguments, format);
+  int added = vsnprintf(&buffer[length], bufferSize - length, format, arguments);
+  va_end(arguments);
+
+  if (added < 0)
+  {
+    return length;
+  }
+  length += (size_t)added;
+  return (length < bufferSize) ? length : bufferSize - 1;
+
+}   //   appendFormat()
+
+size_t metricsFormat(char *buffer, size_t bufferSize)
+{
+  if (bufferSize == 0)
+  {
+    return 0;
+  }
+  buffer[0] = '\0';
+
+  size_t length = appendFormat(
+    buffer, bufferSize, 0,
+    "{\"up\":%lu,\"loop\":{\"n\":%u,\"max\":%u,\"h\":[",
+    (unsigned long)millis(),
+    (unsigned)loopCount,
+    (unsigned)loopMaxUs
+  );
+
+  for (uint8_t bucket = 0; bucket < METRICS_HISTOGRAM_BUCKETS; bucket++)
+  {
+    length = appendFormat(buffer, bufferSize, length, "%s%u", bucket ? "," : "", (unsigned)loopHistogram[bucket]);
+  }
+
+  length = appendFormat(
+    buffer, bufferSize, length,
+    "]},\"jit\":{\"n\":%u,\"avg\":%u,\"max\":%u,\"last\":%u},\"heap\":{\"free\":%u,\"min\":%u,\"blk\":%u},\"fs\":{",
+    (unsigned)jitterCount,
+    (unsigned)(jitterCount ? jitterSumUs / jitterCount : 0),
+    (unsigned)jitterMaxUs,
+    (unsigned)jitterLastUs,
+    (unsigned)heapFree,
+    (unsigned)(heapMinFree == UINT32_MAX ? 0 : heapMinFree),
+    (unsigned)heapLargest
+  );
+
+  for (uint8_t operation = 0; operation < METRICS_FS_COUNT; operation++)
+  {
+    const metricsTiming &timing = fsTimings[operation];
+    length = appendFormat(
+      buffer, bufferSize, length,
+      "%s\"%s\":[%u,%u,%u]",
+      operation ? "," : "",
+      fsTimingNames[operation],
+      (unsigned)timing.count,
+      (unsigned)timing.lastUs,
+      (unsigned)timing.maxUs
+    );
+  }
+
+  //-- frag: share of the free internal heap that is not in the largest block
+  return appendFormat(
+    buffer, bufferSize, length,
+    "},\"mem\":{\"frag\":%u,\"ps\":[%u,%u],\"cold\":%u,\"fb\":%u,\"pool\":[%u,%u,%u]}}",
+    (unsigned)(heapFree ? 100 - (uint32_t)((uint64_t)heapLargest * 100 / heapFree) : 0),
+    (unsigned)memory.psramFree,
+    (unsigned)memory.psramTotal,
+    (unsigned)memory.coldBytes,
+    (unsigned)memory.coldFallbacks,
+    (unsigned)memory.poolUsed,
+    (unsigned)memory.poolPeak,
+    (unsigned)memory.poolMisses
+  );
+
+}   //   metricsFormat()
+
+void metricsDump()
+{
+  char buffer[640];
+
+  metricsSampleHeap();
+  memcpy(buffer, "METRICS ", 8);
+  size_t length = 8 + metricsFormat(&buffer[8], sizeof(buffer) - 9);
+  buffer[length++] = '\n';
+
+  //-- longer than LOG_LINE_MAX, so queue it raw (and regardless of LOG_LEVEL)
+  logWriteRaw(buffer, length);
+
+}   //   metricsDump()
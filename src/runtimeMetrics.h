@@ -0,0 +1,47 @@
+//--- Runtime metrics: loop latency histogram, output jitter, heap and FS timings
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- log2 buckets: bucket n counts durations in [2^n, 2^(n+1)) us, the last one is open ended
+#ifndef METRICS_HISTOGRAM_BUCKETS
+  #define METRICS_HISTOGRAM_BUCKETS 16
+#endif
+
+enum metricsFsOperation : uint8_t
+{
+  METRICS_FS_MOUNT = 0,
+  METRICS_FS_LIST,
+  METRICS_FS_USAGE,
+  METRICS_FS_INDEX,
+  METRICS_FS_COUNT
+};
+
+struct metricsTiming
+{
+  uint32_t count;
+  uint32_t lastUs;
+  uint32_t maxUs;
+};
+
+//-- busy time of one loop() pass (without the idle sleep)
+void metricsLoopTime(uint32_t durationUs);
+
+//-- call on every output toggle; compares the interval with periodMs
+void metricsOutputTick(uint32_t periodMs);
+
+//-- duration of a filesystem operation
+void metricsFsTime(metricsFsOperation operation, uint32_t durationUs);
+
+//-- sample free heap, the minimum seen and the largest free block
+void metricsSampleHeap();
+
+//-- reset the histogram, jitter and FS timings (heap minimum is kept)
+void metricsReset();
+
+//-- format everything as one line of compact JSON; returns the length
+size_t metricsFormat(char *buffer, size_t bufferSize);
+
+//-- log the JSON line prefixed with "METRICS "
+void metricsDump();
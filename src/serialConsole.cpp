@@ -0,0 +1,143 @@
+//--- Non-blocking line based command console on the serial port
+
+#include "serialConsole.h"
+#include "logger.h"
+
+bool SerialConsole::addCommand(const char *name, consoleHandler handler, const char *help)
+{
+  if (name == nullptr || handler == nullptr || commandCount >= CONSOLE_MAX_COMMANDS)
+  {
+    LOG_ERROR("Error: console cannot add command [%s]\n", name ? name : "?");
+    return false;
+  }
+
+  commands[commandCount].name    = name;
+  commands[commandCount].handler = handler;
+  commands[commandCount].help    = help;
+  commandCount++;
+  return true;
+
+}   //   addCommand()
+
+bool SerialConsole::poll()
+{
+  //-- keep the line until dispatch() had a chance to run it
+  if (lineReady)
+  {
+    return true;
+  }
+
+  for (int budget = 0; budget < CONSOLE_MAX_BYTES_PER_POLL && Serial.available() > 0; budget++)
+  {
+    int received = Serial.read();
+    if (received < 0)
+    {
+      break;
+    }
+
+    if (received == '\r' || received == '\n')
+    {
+      if (lineOverflow)
+      {
+        LOG_WARN("Warning: console line longer than %d characters ignored.\n", CONSOLE_LINE_MAX - 1);
+        lineOverflow = false;
+        lineLength   = 0;
+        continue;
+      }
+      if (lineLength == 0)
+      {
+        //-- empty line or the second half of "\r\n"
+        continue;
+      }
+      line[lineLength] = '\0';
+      lineReady        = true;
+      return true;
+    }
+
+    if (received == '\b' || received == 0x7F)
+    {
+      if (lineLength > 0)
+      {
+        lineLength--;
+      }
+      continue;
+    }
+
+    if (lineLength < CONSOLE_LINE_MAX - 1)
+    {
+      line[lineLength++] = (char)received;
+    }
+    else
+    {
+      lineOverflow = true;
+    }
+  }
+
+  return false;
+
+}   //   poll()
+
+bool SerialConsole::dispatch()
+{
+  if (!lineReady)
+  {
+    return false;
+  }
+
+  //-- split in place on spaces/tabs
+  char *argv[CONSOLE_MAX_ARGS] = {};
+  int   argc   = 0;
+  char *cursor = line;
+  while (*cursor != '\0' && argc < CONSOLE_MAX_ARGS)
+  {
+    while (*cursor == ' ' || *cursor == '\t')
+    {
+      *cursor++ = '\0';
+    }
+    if (*cursor == '\0')
+    {
+      break;
+    }
+    argv[argc++] = cursor;
+    while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t')
+    {
+      cursor++;
+    }
+    if (*cursor != '\0')
+    {
+      *cursor++ = '\0';
+    }
+  }
+
+  if (argc > 0)
+  {
+    bool handled = false;
+    for (uint8_t index = 0; index < commandCount; index++)
+    {
+      if (strcmp(argv[0], commands[index].name) == 0)
+      {
+        commands[index].handler(argc, argv);
+        handled = true;
+        break;
+      }
+    }
+    if (!handled)
+    {
+      LOG_WARN("Warning: unknown command [%s], try \"help\".\n", argv[0]);
+    }
+  }
+
+  lineLength = 0;
+  lineReady  = false;
+  return true;
+
+}   //   dispatch()
+
+void SerialConsole::printHelp() const
+{
+  for (uint8_t index = 0; index < commandCount; index++)
+  {
+    LOG_INFO("  %-8s %s\n", commands[index].name, commands[index].help ? commands[index].help : "");
+  }
+
+}   //   printHelp()
@@ -0,0 +1,64 @@
+//--- Non-blocking line based command console on the serial port
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- longest command line including the terminating '\0'; longer lines are discarded.
+//-- Must hold "ota <bytes> <64 hex sha256>" (up to 76 characters)
+#ifndef CONSOLE_LINE_MAX
+  #define CONSOLE_LINE_MAX 96
+#endif
+
+//-- command word plus arguments
+#ifndef CONSOLE_MAX_ARGS
+  #define CONSOLE_MAX_ARGS 5
+#endif
+
+//-- room for every command initConsole() can register (11 plus ota, events, crash);
+//-- main.cpp checks its count against this at compile time
+#ifndef CONSOLE_MAX_COMMANDS
+  #define CONSOLE_MAX_COMMANDS 16
+#endif
+
+//-- bytes taken from the UART per poll(), keeps one poll() in the microsecond range
+#ifndef CONSOLE_MAX_BYTES_PER_POLL
+  #define CONSOLE_MAX_BYTES_PER_POLL 32
+#endif
+
+//-- argv[0] is the command word; argv[] points into the line buffer
+typedef void (*consoleHandler)(int argc, char *argv[]);
+
+class SerialConsole
+{
+  public:
+    //-- returns false when the command table is full
+    bool addCommand(const char *name, consoleHandler handler, const char *help);
+
+    //-- collect input without blocking; true when a complete line waits for dispatch()
+    bool poll();
+
+    //-- run the waiting line (at most one per call); false if there was none
+    bool dispatch();
+
+    bool hasLine() const { return lineReady; }
+
+    void printHelp() const;
+
+  private:
+    struct consoleCommand
+    {
+      const char     *name;
+      consoleHandler  handler;
+      const char     *help;
+    };
+
+    consoleCommand commands[CONSOLE_MAX_COMMANDS] = {};
+    uint8_t        commandCount = 0;
+
+    char     line[CONSOLE_LINE_MAX] = {};
+    uint8_t  lineLength   = 0;
+    bool     lineReady    = false;
+    bool     lineOverflow = false;
+
+};   //   SerialConsole
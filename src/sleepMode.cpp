@@ -0,0 +1,227 @@
+//--- Power saving blink mode: sleep between toggles, blink state kept in RTC memory
+
+#include "sleepMode.h"
+
+#if SLEEP_MODE_ENABLED
+
+#include "crc32.h"
+#include "logger.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <esp_sleep.h>
+  #include <esp_attr.h>
+  #include <driver/gpio.h>
+#elif defined(ARDUINO_ARCH_ESP8266)
+  #include <ESP8266WiFi.h>
+#endif
+
+static const uint32_t sleepStateMagic = 0x534C5031;   // "SLP1"
+
+//-- everything that has to survive a deep sleep; check is a CRC32 of the
+//-- fields before it so stale or random RTC content is not taken for state
+struct sleepState
+{
+  uint32_t magic;
+  uint32_t toggleCount;
+  uint32_t isOn;
+  uint32_t periodMs;
+  uint32_t wakeCount;
+  uint32_t lastBootUs;
+  uint32_t maxBootUs;
+  uint32_t check;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+RTC_DATA_ATTR static sleepState rtcState;
+#endif
+
+static sleepState state         = {};
+static bool       stateLoaded   = false;
+static bool       resumedBoot   = false;
+static int8_t     heldPin       = -1;
+
+//-- light/modem sleep statistics of this boot
+static uint32_t   sleepCycles   = 0;
+static uint64_t   sleptMs       = 0;
+static uint32_t   overheadUsMax = 0;
+static uint64_t   overheadUsSum = 0;
+
+static uint32_t stateCheck(const sleepState &current)
+{
+  return crc32Update(0, (const uint8_t *)&current, offsetof(sleepState, check));
+
+}   //   stateCheck()
+
+static void loadState()
+{
+  if (stateLoaded)
+  {
+    return;
+  }
+  stateLoaded = true;
+
+#if defined(ARDUINO_ARCH_ESP32)
+  state = rtcState;
+  bool woke = (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_TIMER);
+#elif defined(ARDUINO_ARCH_ESP8266)
+  ESP.rtcUserMemoryRead(SLEEP_RTC_BLOCK, (uint32_t *)&state, sizeof(state));
+  bool woke = (ESP.getResetInfoPtr()->reason == REASON_DEEP_SLEEP_AWAKE);
+#endif
+
+  if (state.magic != sleepStateMagic || state.check != stateCheck(state))
+  {
+    memset(&state, 0, sizeof(state));
+    state.magic = sleepStateMagic;
+    return;
+  }
+  resumedBoot = woke;
+
+}   //   loadState()
+
+static void storeState()
+{
+  state.check = stateCheck(state);
+#if defined(ARDUINO_ARCH_ESP32)
+  rtcState = state;
+#elif defined(ARDUINO_ARCH_ESP8266)
+  ESP.rtcUserMemoryWrite(SLEEP_RTC_BLOCK, (uint32_t *)&state, sizeof(state));
+#endif
+
+}   //   storeState()
+
+void sleepBegin(int8_t holdPin)
+{
+  loadState();
+  heldPin = holdPin;
+#if defined(ARDUINO_ARCH_ESP32)
+  //-- release the level held through the last deep sleep, the caller restores it
+  if (heldPin >= 0)
+  {
+    gpio_hold_dis((gpio_num_t)heldPin);
+  }
+#elif defined(ARDUINO_ARCH_ESP8266)
+  //-- the blink firmware never uses the radio, keep it powered down (modem sleep)
+  WiFi.mode(WIFI_OFF);
+  WiFi.forceSleepBegin();
+#endif
+  LOG_INFO(
+    "Info: %s sleep mode, %s boot (wake %u).\n",
+    (SLEEP_MODE == SLEEP_MODE_DEEP) ? "deep" : "light",
+    resumedBoot ? "resumed" : "cold",
+    (unsigned)state.wakeCount
+  );
+
+}   //   sleepBegin()
+
+bool sleepResumed()
+{
+  loadState();
+  return resumedBoot;
+
+}   //   sleepResumed()
+
+bool sleepRestore(bool &isOn, uint32_t &toggleCount, uint32_t &periodMs)
+{
+  loadState();
+  if (!resumedBoot)
+  {
+    return false;
+  }
+  isOn        = (state.isOn != 0);
+  toggleCount = state.toggleCount;
+  if (state.periodMs > 0)
+  {
+    periodMs = state.periodMs;
+  }
+  return true;
+
+}   //   sleepRestore()
+
+void sleepSave(bool isOn, uint32_t toggleCount, uint32_t periodMs)
+{
+  loadState();
+  state.isOn        = isOn ? 1 : 0;
+  state.toggleCount = toggleCount;
+  state.periodMs    = periodMs;
+  storeState();
+
+}   //   sleepSave()
+
+void sleepRecordBootUs(uint32_t bootUs)
+{
+  loadState();
+  state.lastBootUs = bootUs;
+  if (bootUs > state.maxBootUs)
+  {
+    state.maxBootUs = bootUs;
+  }
+  storeState();
+
+}   //   sleepRecordBootUs()
+
+void sleepFor(uint32_t waitMs)
+{
+  //-- nothing queued for the UART may be lost while the clocks are stopped
+  logFlushAll();
+  Serial.flush();
+
+#if SLEEP_MODE == SLEEP_MODE_DEEP
+  state.wakeCount++;
+  storeState();
+  #if defined(ARDUINO_ARCH_ESP32)
+  if (heldPin >= 0)
+  {
+    gpio_hold_en((gpio_num_t)heldPin);
+    gpio_deep_sleep_hold_en();
+  }
+  esp_sleep_enable_timer_wakeup((uint64_t)waitMs * 1000ULL);
+  esp_deep_sleep_start();
+  #elif defined(ARDUINO_ARCH_ESP8266)
+  ESP.deepSleep((uint64_t)waitMs * 1000ULL);
+  #endif
+#else
+  uint32_t startUs = micros();
+  #if defined(ARDUINO_ARCH_ESP32)
+  //-- esp_timer (and so micros()) keeps counting through light sleep
+  esp_sleep_enable_timer_wakeup((uint64_t)waitMs * 1000ULL);
+  esp_light_sleep_start();
+  #elif defined(ARDUINO_ARCH_ESP8266)
+  delay(waitMs);
+  #endif
+  uint32_t elapsedUs  = micros() - startUs;
+  uint32_t overheadUs = (elapsedUs > waitMs * 1000UL) ? elapsedUs - waitMs * 1000UL : 0;
+
+  sleepCycles++;
+  sleptMs       += waitMs;
+  overheadUsSum += overheadUs;
+  if (overheadUs > overheadUsMax)
+  {
+    overheadUsMax = overheadUs;
+  }
+#endif
+
+}   //   sleepFor()
+
+void sleepReport()
+{
+  loadState();
+#if SLEEP_MODE == SLEEP_MODE_DEEP
+  LOG_INFO(
+    "Sleep: deep, wake %u, boot to toggle %u us (max %u us)\n",
+    (unsigned)state.wakeCount,
+    (unsigned)state.lastBootUs,
+    (unsigned)state.maxBootUs
+  );
+#else
+  LOG_INFO(
+    "Sleep: light, %u cycles, %u ms asleep, wake overhead avg %u us (max %u us)\n",
+    (unsigned)sleepCycles,
+    (unsigned)sleptMs,
+    (unsigned)(sleepCycles ? overheadUsSum / sleepCycles : 0),
+    (unsigned)overheadUsMax
+  );
+#endif
+
+}   //   sleepReport()
+
+#endif   // SLEEP_MODE_ENABLED
@@ -0,0 +1,66 @@
+//--- Power saving blink mode: sleep between toggles, blink state kept in RTC memory
+
+#pragma once
+
+#include <Arduino.h>
+
+#define SLEEP_MODE_LIGHT 1
+#define SLEEP_MODE_DEEP  2
+
+//-- selected with -DUSE_SLEEP_MODE; -DSLEEP_MODE=SLEEP_MODE_DEEP for deep sleep
+//-- ESP32  : light sleep with timer wakeup (GPIO levels are kept) or deep sleep
+//-- ESP8266: modem sleep (radio off, CPU idles in delay()) or deep sleep,
+//--          deep sleep needs GPIO16 (D0) wired to RST
+#if defined(USE_SLEEP_MODE) && (defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266))
+  #define SLEEP_MODE_ENABLED 1
+#else
+  #define SLEEP_MODE_ENABLED 0
+#endif
+
+#if SLEEP_MODE_ENABLED
+
+#ifndef SLEEP_MODE
+  #define SLEEP_MODE SLEEP_MODE_LIGHT
+#endif
+
+#if defined(USE_RTOS_TASKS)
+  #error "USE_SLEEP_MODE sleeps from loop(), remove USE_RTOS_TASKS for this env"
+#endif
+#if defined(USE_HW_BLINK)
+  #error "USE_SLEEP_MODE stops the LEDC/timer1 blink, remove USE_HW_BLINK for this env"
+#endif
+
+//-- shorter waits are not worth a sleep cycle, they idle as usual
+#ifndef SLEEP_MIN_MS
+  #define SLEEP_MIN_MS 10
+#endif
+
+//-- ESP8266 RTC user memory block (4 bytes each) for the state; the
+//-- blocks below are left to the OTA/bootloader
+#ifndef SLEEP_RTC_BLOCK
+  #define SLEEP_RTC_BLOCK 64
+#endif
+
+//-- prepare the sleep mode (radio off on ESP8266); holdPin keeps its level
+//-- through deep sleep (ESP32 only, -1 for none)
+void sleepBegin(int8_t holdPin = -1);
+
+//-- true when this boot is a wake-up from deep sleep with a valid saved state
+bool sleepResumed();
+
+//-- blink state from RTC memory; false (and nothing changed) if there is none
+bool sleepRestore(bool &isOn, uint32_t &toggleCount, uint32_t &periodMs);
+
+//-- store the blink state in RTC memory
+void sleepSave(bool isOn, uint32_t toggleCount, uint32_t periodMs);
+
+//-- sleep for waitMs; returns after light/modem sleep, deep sleep restarts the chip
+void sleepFor(uint32_t waitMs);
+
+//-- cost of the last deep-sleep wake-up: reset until the first toggle in us
+void sleepRecordBootUs(uint32_t bootUs);
+
+//-- one line with sleep cycles, time asleep and the wake-up overhead
+void sleepReport();
+
+#endif   // SLEEP_MODE_ENABLED
@@ -0,0 +1,64 @@
+//--- Lock-free single-producer/single-consumer ring, safe to fill from an interrupt
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <atomic>
+
+//-- one producer (a task or an ISR) and one consumer (a task); neither ever
+//-- blocks or takes a lock, so push() can be called from an interrupt handler.
+//-- CAPACITY must be a power of two; the indices run freely and wrap at 2^32
+template <typename T, uint32_t CAPACITY>
+class SpscQueue
+{
+  static_assert(CAPACITY >= 2 && (CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue CAPACITY must be a power of two");
+
+  public:
+    SpscQueue() : head(0), tail(0), drops(0) {}
+
+    //-- producer side; false (and counted) when the queue is full. Always
+    //-- inlined, so it ends up in the (IRAM) interrupt handler that calls it
+    __attribute__((always_inline)) bool push(const T &item)
+    {
+      uint32_t position = head.load(std::memory_order_relaxed);
+      if (position - tail.load(std::memory_order_acquire) >= CAPACITY)
+      {
+        drops.store(drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+      }
+      items[position & (CAPACITY - 1)] = item;
+      //-- publish the item before the index that makes it visible
+      head.store(position + 1, std::memory_order_release);
+      return true;
+    }
+
+    //-- consumer side; false when the queue is empty
+    bool pop(T &item)
+    {
+      uint32_t position = tail.load(std::memory_order_relaxed);
+      if (position == head.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+      item = items[position & (CAPACITY - 1)];
+      //-- the slot may be reused once the new tail is seen
+      tail.store(position + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool     isEmpty() const  { return count() == 0; }
+    uint32_t count() const    { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+    uint32_t capacity() const { return CAPACITY; }
+    //-- pushes that found the queue full
+    uint32_t dropped() const  { return drops.load(std::memory_order_relaxed); }
+
+  private:
+    T                     items[CAPACITY];
+    //-- written by the producer only
+    std::atomic<uint32_t> head;
+    //-- written by the consumer only
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> drops;
+
+};   //   SpscQueue
@@ -0,0 +1,347 @@
+//--- Small cooperative millis() based task scheduler
+
+#include "taskScheduler.h"
+#include "logger.h"
+
+//-- wrap-around safe "a is at or after b" for millis() timestamps
+static inline bool isDue(uint32_t nowMs, uint32_t dueMs)
+{
+  return (int32_t)(nowMs - dueMs) >= 0;
+
+}   //   isDue()
+
+//-- microseconds from nowUs to a millis() deadline, negative once it passed;
+//-- micros() - millis() * 1000 stays within 0..999 across both wrap-arounds
+static inline int32_t usUntil(uint32_t dueMs, uint32_t nowUs)
+{
+  return (int32_t)(dueMs * 1000UL - nowUs);
+
+}   //   usUntil()
+
+void schedulerRecordLate(schedulerTiming &timing, uint32_t lateUs, uint32_t boundUs)
+{
+  timing.runs++;
+  timing.lastLateUs   = lateUs;
+  timing.totalLateUs += lateUs;
+  if (lateUs > timing.maxLateUs)
+  {
+    timing.maxLateUs = lateUs;
+  }
+  if (boundUs > 0 && lateUs > boundUs)
+  {
+    timing.overBound++;
+  }
+
+}   //   schedulerRecordLate()
+
+int TaskScheduler::addTask(const char *name, schedulerCallback callback, uint32_t periodMs, uint32_t delayMs, bool oneShot)
+{
+  if (callback == nullptr || taskCount >= SCHEDULER_MAX_TASKS)
+  {
+    LOG_ERROR("Error: scheduler cannot add task [%s]\n", name ? name : "?");
+    return -1;
+  }
+
+  schedulerTask &task = tasks[taskCount];
+  task.name      = name;
+  task.callback  = callback;
+  task.periodMs  = periodMs;
+  task.nextDueMs = millis() + delayMs;
+  task.oneShot   = oneShot;
+  task.enabled   = true;
+  task.maxLateUs = 0;
+  task.stats     = schedulerTiming();
+  task.held      = false;
+
+  return taskCount++;
+
+}   //   addTask()
+
+bool TaskScheduler::isValid(int taskId) const
+{
+  return (taskId >= 0 && taskId < taskCount);
+
+}   //   isValid()
+
+int TaskScheduler::addPeriodic(const char *name, schedulerCallback callback, uint32_t periodMs, uint32_t firstDelayMs)
+{
+  if (periodMs == 0)
+  {
+    periodMs = 1;
+  }
+  return addTask(name, callback, periodMs, firstDelayMs, false);
+
+}   //   addPeriodic()
+
+int TaskScheduler::addOneShot(const char *name, schedulerCallback callback, uint32_t delayMs)
+{
+  return addTask(name, callback, 0, delayMs, true);
+
+}   //   addOneShot()
+
+void TaskScheduler::setPeriod(int taskId, uint32_t periodMs)
+{
+  if (!isValid(taskId) || periodMs == 0)
+  {
+    return;
+  }
+  tasks[taskId].periodMs  = periodMs;
+  tasks[taskId].nextDueMs = millis() + periodMs;
+
+}   //   setPeriod()
+
+void TaskScheduler::trigger(int taskId, uint32_t delayMs)
+{
+  if (!isValid(taskId))
+  {
+    return;
+  }
+  tasks[taskId].nextDueMs = millis() + delayMs;
+  tasks[taskId].enabled   = true;
+
+}   //   trigger()
+
+void TaskScheduler::cancel(int taskId)
+{
+  if (!isValid(taskId))
+  {
+    return;
+  }
+  tasks[taskId].enabled = false;
+
+}   //   cancel()
+
+void TaskScheduler::setLatencyBound(int taskId, uint32_t maxLateUs)
+{
+  if (!isValid(taskId))
+  {
+    return;
+  }
+  tasks[taskId].maxLateUs = maxLateUs;
+
+}   //   setLatencyBound()
+
+bool TaskScheduler::hasRoomFor(uint32_t workUs) const
+{
+  uint32_t nowUs = micros();
+
+  for (int taskId = 0; taskId < taskCount; taskId++)
+  {
+    const schedulerTask &task = tasks[taskId];
+    if (!task.enabled || task.maxLateUs == 0)
+    {
+      continue;
+    }
+    int64_t slackUs = (int64_t)usUntil(task.nextDueMs, nowUs) + task.maxLateUs;
+    if (slackUs < (int64_t)workUs)
+    {
+      return false;
+    }
+  }
+  return true;
+
+}   //   hasRoomFor()
+
+//-- a task that could make a bounded one late waits, but only until a bounded
+//-- task has run once: one that does not fit even then never will, it runs
+bool TaskScheduler::mayRun(schedulerTask &task)
+{
+  if (task.maxLateUs > 0 || hasRoomFor(task.stats.maxRunUs))
+  {
+    task.held = false;
+    return true;
+  }
+  if (!task.held)
+  {
+    task.held       = true;
+    task.heldAtRuns = boundedRuns;
+    task.stats.deferred++;
+    return false;
+  }
+  if (task.heldAtRuns != boundedRuns)
+  {
+    task.held = false;
+    return true;
+  }
+  return false;
+
+}   //   mayRun()
+
+bool TaskScheduler::timing(int taskId, schedulerTiming &result) const
+{
+  if (!isValid(taskId))
+  {
+    return false;
+  }
+  result = tasks[taskId].stats;
+  return true;
+
+}   //   timing()
+
+void TaskScheduler::resetTiming()
+{
+  for (int taskId = 0; taskId < taskCount; taskId++)
+  {
+    uint32_t maxRunUs = tasks[taskId].stats.maxRunUs;
+    tasks[taskId].stats          = schedulerTiming();
+    tasks[taskId].stats.maxRunUs = maxRunUs;
+  }
+
+}   //   resetTiming()
+
+void TaskScheduler::run()
+{
+  for (int taskId = 0; taskId < taskCount; taskId++)
+  {
+    schedulerTask &task = tasks[taskId];
+    uint32_t nowMs = millis();
+
+    if (!task.enabled || !isDue(nowMs, task.nextDueMs))
+    {
+      continue;
+    }
+    if (!mayRun(task))
+    {
+      continue;
+    }
+
+    uint32_t startUs = micros();
+    int32_t  lateUs  = -usUntil(task.nextDueMs, startUs);
+
+    if (task.oneShot)
+    {
+      task.enabled = false;
+    }
+    else
+    {
+      //-- keep the original cadence; if we fell more than a period behind, re-base on now
+      task.nextDueMs += task.periodMs;
+      if (isDue(nowMs, task.nextDueMs))
+      {
+        task.nextDueMs = nowMs + task.periodMs;
+      }
+    }
+
+    task.callback();
+
+    uint32_t runUs = micros() - startUs;
+    if (runUs > task.stats.maxRunUs)
+    {
+      task.stats.maxRunUs = runUs;
+    }
+    schedulerRecordLate(task.stats, (lateUs > 0) ? (uint32_t)lateUs : 0, task.maxLateUs);
+    if (task.maxLateUs > 0)
+    {
+      boundedRuns++;
+    }
+  }
+
+}   //   run()
+
+uint32_t TaskScheduler::msUntilNext() const
+{
+  uint32_t nowMs   = millis();
+  uint32_t waitMs  = UINT32_MAX;
+
+  for (int taskId = 0; taskId < taskCount; taskId++)
+  {
+    const schedulerTask &task = tasks[taskId];
+    //-- a held task waits for the bounded one, that deadline counts
+    if (!task.enabled || task.held)
+    {
+      continue;
+    }
+    if (isDue(nowMs, task.nextDueMs))
+    {
+      return 0;
+    }
+    uint32_t taskWaitMs = task.nextDueMs - nowMs;
+    if (taskWaitMs < waitMs)
+    {
+      waitMs = taskWaitMs;
+    }
+  }
+
+  return waitMs;
+
+}   //   msUntilNext()
+
+uint32_t TaskScheduler::msUntilTask(int taskId) const
+{
+  if (!isValid(taskId) || !tasks[taskId].enabled)
+  {
+    return UINT32_MAX;
+  }
+  uint32_t nowMs = millis();
+  if (isDue(nowMs, tasks[taskId].nextDueMs))
+  {
+    return 0;
+  }
+  return tasks[taskId].nextDueMs - nowMs;
+
+}   //   msUntilTask()
+
+//-- microseconds until the earliest bounded deadline, UINT32_MAX without one
+uint32_t TaskScheduler::usUntilBounded() const
+{
+  uint32_t nowUs  = micros();
+  uint32_t waitUs = UINT32_MAX;
+
+  for (int taskId = 0; taskId < taskCount; taskId++)
+  {
+    const schedulerTask &task = tasks[taskId];
+    if (!task.enabled || task.maxLateUs == 0)
+    {
+      continue;
+    }
+    int32_t taskWaitUs = usUntil(task.nextDueMs, nowUs);
+    if (taskWaitUs <= 0)
+    {
+      return 0;
+    }
+    if ((uint32_t)taskWaitUs < waitUs)
+    {
+      waitUs = (uint32_t)taskWaitUs;
+    }
+  }
+
+  return waitUs;
+
+}   //   usUntilBounded()
+
+void TaskScheduler::idle(uint32_t maxIdleMs) const
+{
+  uint32_t waitMs    = msUntilNext();
+  uint32_t boundedUs = usUntilBounded();
+
+  if (waitMs > maxIdleMs)
+  {
+    waitMs = maxIdleMs;
+  }
+
+  if (boundedUs < SCHEDULER_SPIN_US + 1000)
+  {
+    //-- nothing else is due: wait out the last stretch to the bounded deadline
+    if (waitMs > 0)
+    {
+      delayMicroseconds(boundedUs);
+      return;
+    }
+  }
+  else if (boundedUs != UINT32_MAX && waitMs > (boundedUs - SCHEDULER_SPIN_US) / 1000)
+  {
+    //-- wake up before the bounded deadline, with the busy wait still ahead
+    waitMs = (boundedUs - SCHEDULER_SPIN_US) / 1000;
+  }
+
+  if (waitMs == 0)
+  {
+    yield();
+    return;
+  }
+
+  //-- delay() blocks the loop task in the RTOS (ESP32) or the SDK (ESP8266),
+  //-- so the idle task / automatic light-sleep gets the CPU until the deadline
+  delay(waitMs);
+
+}   //   idle()
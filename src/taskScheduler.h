@@ -0,0 +1,119 @@
+//--- Small cooperative millis() based task scheduler
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- maximum number of tasks the scheduler can hold (no heap is used)
+#ifndef SCHEDULER_MAX_TASKS
+  #define SCHEDULER_MAX_TASKS 8
+#endif
+
+//-- upper bound for one idle() sleep so loop() still gets serviced regularly
+#ifndef SCHEDULER_MAX_IDLE_MS
+  #define SCHEDULER_MAX_IDLE_MS 100
+#endif
+
+//-- the last stretch before the deadline of a bounded task is waited out with a
+//-- busy wait, a millisecond sleep could end too late
+#ifndef SCHEDULER_SPIN_US
+  #define SCHEDULER_SPIN_US 1000
+#endif
+
+typedef void (*schedulerCallback)();
+
+//-- how late the runs of a task were against their deadlines
+struct schedulerTiming
+{
+  uint32_t runs;
+  uint32_t lastLateUs;
+  uint32_t maxLateUs;
+  //-- mean lateness is totalLateUs / runs
+  uint64_t totalLateUs;
+  //-- runs later than the bound of the task
+  uint32_t overBound;
+  //-- longest run of the callback
+  uint32_t maxRunUs;
+  //-- times the task was held back to keep a bounded task in time
+  uint32_t deferred;
+};
+
+//-- add one run with lateUs to timing; boundUs 0 has no bound
+void schedulerRecordLate(schedulerTiming &timing, uint32_t lateUs, uint32_t boundUs);
+
+class TaskScheduler
+{
+  public:
+    //-- register a task that runs every periodMs, first run after firstDelayMs
+    //-- returns the task id, or -1 when the task table is full
+    int addPeriodic(const char *name, schedulerCallback callback, uint32_t periodMs, uint32_t firstDelayMs = 0);
+
+    //-- register a task that runs once after delayMs and then disables itself
+    //-- returns the task id, or -1 when the task table is full
+    int addOneShot(const char *name, schedulerCallback callback, uint32_t delayMs);
+
+    //-- change the period of a task; the next deadline is re-based on now
+    void setPeriod(int taskId, uint32_t periodMs);
+
+    //-- (re)arm a task so it runs delayMs from now
+    void trigger(int taskId, uint32_t delayMs = 0);
+
+    //-- disable a task; its slot stays reserved so the id remains valid
+    void cancel(int taskId);
+
+    //-- a bounded task runs at most maxLateUs after its deadline: another task
+    //-- waits while its longest run so far could push the bounded one past that,
+    //-- and idle() wakes up exactly on time for it; 0 removes the bound
+    void setLatencyBound(int taskId, uint32_t maxLateUs);
+
+    //-- true when work of workUs started now keeps every bounded task in time
+    bool hasRoomFor(uint32_t workUs) const;
+
+    //-- lateness statistics of a task; false for an unknown id
+    bool timing(int taskId, schedulerTiming &result) const;
+
+    //-- clear the statistics of every task (the longest runs are kept)
+    void resetTiming();
+
+    //-- run every task whose deadline has passed
+    void run();
+
+    //-- milliseconds until the earliest enabled deadline (0 if one is overdue);
+    //-- a task held back for a bounded one waits for that deadline
+    uint32_t msUntilNext() const;
+
+    //-- milliseconds until the deadline of one task (0 if it is overdue),
+    //-- UINT32_MAX for an unknown or disabled one
+    uint32_t msUntilTask(int taskId) const;
+
+    //-- sleep until the next deadline instead of busy-waiting,
+    //-- but never longer than maxIdleMs
+    void idle(uint32_t maxIdleMs = SCHEDULER_MAX_IDLE_MS) const;
+
+  private:
+    struct schedulerTask
+    {
+      const char        *name;
+      schedulerCallback  callback;
+      uint32_t           periodMs;
+      uint32_t           nextDueMs;
+      bool               oneShot;
+      bool               enabled;
+      uint32_t           maxLateUs;
+      schedulerTiming    stats;
+      //-- held back: boundedRuns at that time; it waits for one bounded run at most
+      bool               held;
+      uint32_t           heldAtRuns;
+    };
+
+    int addTask(const char *name, schedulerCallback callback, uint32_t periodMs, uint32_t delayMs, bool oneShot);
+    bool isValid(int taskId) const;
+    bool mayRun(schedulerTask &task);
+    uint32_t usUntilBounded() const;
+
+    schedulerTask tasks[SCHEDULER_MAX_TASKS] = {};
+    int           taskCount   = 0;
+    //-- runs of bounded tasks so far
+    uint32_t      boundedRuns = 0;
+
+};   //   TaskScheduler
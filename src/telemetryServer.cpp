@@ -0,0 +1,623 @@
+//--- Wi-Fi telemetry: LittleFS usage, the file listing and runtime metrics as chunked JSON over HTTP
+
+#include "telemetryServer.h"
+
+#if TELEMETRY_ENABLED
+
+#include "logger.h"
+#include "runtimeMetrics.h"
+#include "crashReport.h"
+
+#include <string.h>
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <errno.h>
+  #include <lwip/sockets.h>
+#endif
+
+//-- "XXXX\r\n" in front of every chunk, "\r\n" behind it, "0\r\n\r\n" after the last one
+static const size_t CHUNK_HEAD  = 6;
+static const size_t CHUNK_TAIL  = 2;
+static const size_t CHUNK_FINAL = 5;
+
+//-- bytes read from one client per poll
+static const int READ_BYTES_PER_POLL = 128;
+
+//-- path of the command requests, the command follows it
+static const char   OUTPUT_PREFIX[]     = "/output/";
+static const size_t OUTPUT_PREFIX_CHARS = sizeof(OUTPUT_PREFIX) - 1;
+
+//-- answer for a connection that finds every slot taken; small enough for one segment
+static const char BUSY_REPLY[] =
+  "HTTP/1.1 503 Service Unavailable\r\n"
+  "Content-Length: 0\r\n"
+  "Connection: close\r\n\r\n";
+
+//-- copy text as a JSON string body: quote and backslash escaped, control characters dropped
+//-- returns the bytes written, 0 when it does not fit
+static size_t jsonEscape(char *target, size_t room, const char *text, size_t maxLength)
+{
+  size_t length = 0;
+
+  for (size_t position = 0; position < maxLength && text[position] != '\0'; position++)
+  {
+    char character = text[position];
+    if ((uint8_t)character < 0x20)
+    {
+      continue;
+    }
+    bool escape = (character == '"' || character == '\\');
+    if (length + (escape ? 2 : 1) >= room)
+    {
+      return 0;
+    }
+    if (escape)
+    {
+      target[length++] = '\\';
+    }
+    target[length++] = character;
+  }
+  return length;
+
+}   //   jsonEscape()
+
+void TelemetryServer::begin(FsIndex *index, FsUsage *usage)
+{
+  fsIndex = index;
+  fsUsage = usage;
+
+  for (uint8_t slot = 0; slot < TELEMETRY_MAX_CLIENTS; slot++)
+  {
+    clients[slot].state   = CLIENT_FREE;
+    clients[slot].request = nullptr;
+  }
+
+  WiFi.mode(WIFI_STA);
+  WiFi.setAutoReconnect(true);
+  WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+  LOG_INFO("Info: telemetry connecting to [%s]...\n", WIFI_SSID);
+
+}   //   begin()
+
+//-- follow the connection; the listening socket survives a reconnect
+void TelemetryServer::checkWifi()
+{
+  bool connected = (WiFi.status() == WL_CONNECTED);
+  if (connected == wifiUp)
+  {
+    return;
+  }
+  wifiUp = connected;
+
+  if (!connected)
+  {
+    LOG_WARN("Warning: telemetry Wi-Fi lost, reconnecting.\n");
+    return;
+  }
+  if (!listening)
+  {
+    server.begin();
+    server.setNoDelay(true);
+    listening = true;
+  }
+  IPAddress address = WiFi.localIP();
+  LOG_INFO(
+    "Info: telemetry on http://%u.%u.%u.%u:%u/\n",
+    address[0], address[1], address[2], address[3], (unsigned)TELEMETRY_PORT
+  );
+
+}   //   checkWifi()
+
+void TelemetryServer::acceptClients()
+{
+  if (!listening)
+  {
+    return;
+  }
+
+#if defined(ARDUINO_ARCH_ESP8266)
+  WiFiClient incoming = server.accept();
+#else
+  WiFiClient incoming = server.available();
+#endif
+  if (!incoming)
+  {
+    return;
+  }
+
+  for (uint8_t slot = 0; slot < TELEMETRY_MAX_CLIENTS; slot++)
+  {
+    telemetryClient &client = clients[slot];
+    if (client.state != CLIENT_FREE)
+    {
+      continue;
+    }
+    client.request = (char *)memSmallAlloc(TELEMETRY_REQUEST_MAX);
+    if (client.request == nullptr)
+    {
+      break;
+    }
+    client.connection     = incoming;
+    client.connection.setNoDelay(true);
+    client.state          = CLIENT_READING;
+    client.resource       = RESOURCE_NOT_FOUND;
+    client.cursor         = 0;
+    client.finished       = false;
+    client.commandAccepted = false;
+    client.lastActivityMs = millis();
+    client.nextLineMs     = client.lastActivityMs;
+    client.requestLength  = 0;
+    client.lineComplete   = false;
+    client.headerMatch    = 0;
+    client.bufferLength   = 0;
+    client.bufferSent     = 0;
+    return;
+  }
+
+  incoming.write((const uint8_t *)BUSY_REPLY, sizeof(BUSY_REPLY) - 1);
+  incoming.stop();
+
+}   //   acceptClients()
+
+//-- keep the request line, skip the headers up to the empty line
+void TelemetryServer::readRequest(telemetryClient &client)
+{
+  static const char HEADER_END[] = "\r\n\r\n";
+
+  for (int count = 0; count < READ_BYTES_PER_POLL && client.connection.available() > 0; count++)
+  {
+    int character = client.connection.read();
+    if (character < 0)
+    {
+      break;
+    }
+    client.lastActivityMs = millis();
+
+    if (!client.lineComplete)
+    {
+      if (character == '\r' || character == '\n' || client.requestLength >= TELEMETRY_REQUEST_MAX - 1)
+      {
+        client.lineComplete = true;
+      }
+      else
+      {
+        client.request[client.requestLength++] = (char)character;
+      }
+    }
+
+    if (character == HEADER_END[client.headerMatch])
+    {
+      client.headerMatch++;
+    }
+    else
+    {
+      client.headerMatch = (character == '\r') ? 1 : 0;
+    }
+    if (client.headerMatch == 4)
+    {
+      client.request[client.requestLength] = '\0';
+      parseRequest(client);
+      client.state = CLIENT_SENDING;
+      return;
+    }
+  }
+
+}   //   readRequest()
+
+void TelemetryServer::parseRequest(telemetryClient &client)
+{
+  client.resource = RESOURCE_NOT_FOUND;
+  if (strncmp(client.request, "GET ", 4) != 0)
+  {
+    return;
+  }
+
+  static const struct
+  {
+    const char     *path;
+    clientResource  resource;
+  } routes[] =
+  {
+    { "/",               RESOURCE_INDEX   },
+    { "/usage",          RESOURCE_USAGE   },
+    { "/files",          RESOURCE_FILES   },
+    { "/metrics",        RESOURCE_METRICS },
+    { "/metrics/stream", RESOURCE_STREAM  },
+    { "/crash",          RESOURCE_CRASH   }
+  };
+
+  const char *path   = &client.request[4];
+  size_t      length = strcspn(path, " ?");
+
+  for (size_t route = 0; route < sizeof(routes) / sizeof(routes[0]); route++)
+  {
+    if (strlen(routes[route].path) == length && strncmp(routes[route].path, path, length) == 0)
+    {
+      client.resource = routes[route].resource;
+      return;
+    }
+  }
+
+  //-- a command is taken at once, the response only reports the outcome
+  if (length > OUTPUT_PREFIX_CHARS && strncmp(path, OUTPUT_PREFIX, OUTPUT_PREFIX_CHARS) == 0)
+  {
+    char *command = &client.request[4 + OUTPUT_PREFIX_CHARS];
+    command[length - OUTPUT_PREFIX_CHARS] = '\0';
+    client.resource        = RESOURCE_OUTPUT;
+    client.commandAccepted = (commandHandler != nullptr) && commandHandler(command);
+  }
+
+}   //   parseRequest()
+
+size_t TelemetryServer::formatFiles(telemetryClient &client, char *body, size_t room)
+{
+  size_t   length   = 0;
+  uint16_t position = client.cursor - 1;
+
+  if (fsIndex == nullptr)
+  {
+    body[length++]  = '[';
+    body[length++]  = ']';
+    body[length++]  = '\n';
+    client.finished = true;
+    return length;
+  }
+
+  //-- the filesystem worker changes the index on the other core: each chunk is
+  //-- formatted under the index lock, and when entries moved since the first
+  //-- chunk (rescan, removal) the listing ends with what was sent instead of
+  //-- repeating or skipping entries
+  FsIndexLock guard(*fsIndex);
+  if (position == 0)
+  {
+    body[length++]      = '[';
+    client.indexVersion = fsIndex->layoutVersion();
+  }
+  uint16_t count = (client.indexVersion == fsIndex->layoutVersion()) ? fsIndex->count() : position;
+  while (position < count)
+  {
+    const fsIndexEntry *current = fsIndex->entry(position);
+    if (current == nullptr)
+    {
+      break;
+    }
+
+    size_t start = length;
+    if (position > 0 && length < room)
+    {
+      body[length++] = ',';
+    }
+    int head = snprintf(&body[length], room - length, "{\"path\":\"");
+    size_t pathLength = 0;
+    if (head > 0 && (size_t)head < room - length)
+    {
+      length     += (size_t)head;
+      pathLength  = jsonEscape(&body[length], room - length, current->path, sizeof(current->path));
+    }
+    int tail = -1;
+    if (pathLength > 0)
+    {
+      length += pathLength;
+      tail = snprintf(
+        &body[length], room - length, "\",\"size\":%u,\"dir\":%s}",
+        (unsigned)current->size, current->isDirectory ? "true" : "false"
+      );
+    }
+    if (tail < 0 || (size_t)tail >= room - length)
+    {
+      //-- does not fit any more: the entry goes into the next chunk
+      length = start;
+      break;
+    }
+    length += (size_t)tail;
+    position++;
+  }
+
+  if (position >= count && length + 2 <= room)
+  {
+    body[length++] = ']';
+    body[length++] = '\n';
+    client.finished = true;
+  }
+  client.cursor = position + 1;
+  return length;
+
+}   //   formatFiles()
+
+size_t TelemetryServer::formatBody(telemetryClient &client, char *body, size_t room)
+{
+  int length = 0;
+
+  switch (client.resource)
+  {
+    case RESOURCE_INDEX:
+      length = snprintf(
+        body, room,
+        "{\"endpoints\":[\"/usage\",\"/files\",\"/metrics\",\"/metrics/stream\",\"/crash\",\"/output/<command>\"],\"uptimeMs\":%lu,\"clients\":%u}\n",
+        (unsigned long)millis(), (unsigned)clientCount()
+      );
+      client.finished = true;
+      break;
+
+    case RESOURCE_USAGE:
+      if (fsUsage == nullptr || !fsUsage->isValid())
+      {
+        length = snprintf(body, room, "{\"error\":\"no filesystem\"}\n");
+      }
+      else
+      {
+        length = snprintf(
+          body, room,
+          "{\"total\":%u,\"used\":%u,\"free\":%u,\"block\":%u,\"low\":%s}\n",
+          (unsigned)fsUsage->totalBytes(), (unsigned)fsUsage->usedBytes(),
+          (unsigned)fsUsage->freeBytes(), (unsigned)fsUsage->blockBytes(),
+          fsUsage->isLow() ? "true" : "false"
+        );
+      }
+      client.finished = true;
+      break;
+
+    case RESOURCE_FILES:
+      return formatFiles(client, body, room);
+
+    case RESOURCE_METRICS:
+    case RESOURCE_STREAM:
+      length = (int)metricsFormat(body, room - 1);
+      body[length++] = '\n';
+      client.finished = (client.resource == RESOURCE_METRICS);
+      break;
+
+    case RESOURCE_CRASH:
+#if CRASH_REPORT_ENABLED
+      length = (int)crashReportFormat(body, room - 1);
+      body[length++] = '\n';
+#else
+      length = snprintf(body, room, "{\"error\":\"no crash report in this build\"}\n");
+#endif
+      client.finished = true;
+      break;
+
+    case RESOURCE_OUTPUT:
+    {
+      const char *command = &client.request[4 + OUTPUT_PREFIX_CHARS];
+      size_t      used    = (size_t)snprintf(body, room, "{\"command\":\"");
+      size_t      name    = jsonEscape(&body[used], room - used, command, TELEMETRY_REQUEST_MAX);
+      length = (int)(used + name);
+      length += snprintf(
+        &body[length], room - length, "\",\"accepted\":%s}\n",
+        client.commandAccepted ? "true" : "false"
+      );
+      client.finished = true;
+      break;
+    }
+
+    case RESOURCE_NOT_FOUND:
+      length = snprintf(body, room, "{\"error\":\"not found\"}\n");
+      client.finished = true;
+      break;
+  }
+
+  if (length < 0)
+  {
+    return 0;
+  }
+  return ((size_t)length < room) ? (size_t)length : room - 1;
+
+}   //   formatBody()
+
+//-- build the next piece of the response in the client buffer
+void TelemetryServer::fillBuffer(telemetryClient &client)
+{
+  client.bufferSent = 0;
+
+  if (client.cursor == 0)
+  {
+    int length = snprintf(
+      client.buffer, sizeof(client.buffer),
+      "HTTP/1.1 %s\r\n"
+      "Content-Type: application/json\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "Cache-Control: no-store\r\n"
+      "Connection: close\r\n\r\n",
+      (client.resource == RESOURCE_NOT_FOUND) ? "404 Not Found" : "200 OK"
+    );
+    client.bufferLength = (length > 0) ? (uint16_t)length : 0;
+    client.cursor       = 1;
+    return;
+  }
+
+  char  *body   = &client.buffer[CHUNK_HEAD];
+  size_t room   = sizeof(client.buffer) - CHUNK_HEAD - CHUNK_TAIL - CHUNK_FINAL;
+  size_t length = formatBody(client, body, room);
+
+  size_t total = 0;
+  if (length > 0)
+  {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    for (uint8_t digit = 0; digit < 4; digit++)
+    {
+      client.buffer[digit] = HEX_DIGITS[(length >> (12 - 4 * digit)) & 0x0F];
+    }
+    client.buffer[4] = '\r';
+    client.buffer[5] = '\n';
+    total = CHUNK_HEAD + length;
+    client.buffer[total++] = '\r';
+    client.buffer[total++] = '\n';
+  }
+  if (client.finished)
+  {
+    memcpy(&client.buffer[total], "0\r\n\r\n", CHUNK_FINAL);
+    total += CHUNK_FINAL;
+  }
+  client.bufferLength = (uint16_t)total;
+
+  if (client.resource == RESOURCE_STREAM)
+  {
+    client.nextLineMs = millis() + TELEMETRY_STREAM_MS;
+  }
+
+}   //   fillBuffer()
+
+//-- hand as much of the buffer to the TCP stack as it takes right now
+//-- returns false when the connection failed
+bool TelemetryServer::sendBuffer(telemetryClient &client)
+{
+  size_t remaining = client.bufferLength - client.bufferSent;
+  if (remaining == 0)
+  {
+    return true;
+  }
+  const uint8_t *data = (const uint8_t *)&client.buffer[client.bufferSent];
+
+#if defined(ARDUINO_ARCH_ESP32)
+  //-- WiFiClient::write() waits for room; a non-blocking send() never does
+  ssize_t sent = send(client.connection.fd(), data, remaining, MSG_DONTWAIT);
+  if (sent < 0)
+  {
+    return (errno == EAGAIN || errno == EWOULDBLOCK);
+  }
+#else
+  size_t sent = client.connection.availableForWrite();
+  if (sent > remaining)
+  {
+    sent = remaining;
+  }
+  if (sent > 0)
+  {
+    sent = client.connection.write(data, sent);
+  }
+#endif
+
+  if (sent > 0)
+  {
+    client.bufferSent    += (uint16_t)sent;
+    client.lastActivityMs = millis();
+  }
+  return true;
+
+}   //   sendBuffer()
+
+void TelemetryServer::closeClient(telemetryClient &client)
+{
+  client.connection.stop();
+  client.state = CLIENT_FREE;
+  memSmallFree(client.request);
+  client.request = nullptr;
+
+}   //   closeClient()
+
+void TelemetryServer::serviceClient(telemetryClient &client)
+{
+  uint32_t nowMs = millis();
+
+  if (!client.connection.connected())
+  {
+    closeClient(client);
+    return;
+  }
+
+  switch (client.state)
+  {
+    case CLIENT_FREE:
+      return;
+
+    case CLIENT_READING:
+      readRequest(client);
+      break;
+
+    case CLIENT_WAITING:
+      //-- /metrics/stream between two lines; no timeout, the client decides
+      if ((int32_t)(nowMs - client.nextLineMs) < 0)
+      {
+        return;
+      }
+      client.state = CLIENT_SENDING;
+      break;
+
+    case CLIENT_SENDING:
+      break;
+  }
+
+  if (client.state != CLIENT_SENDING)
+  {
+    if (nowMs - client.lastActivityMs >= TELEMETRY_IDLE_TIMEOUT_MS)
+    {
+      closeClient(client);
+    }
+    return;
+  }
+
+  //-- unread input would turn the close into a reset, throw it away
+  while (client.connection.available() > 0)
+  {
+    client.connection.read();
+  }
+
+  if (client.bufferSent >= client.bufferLength)
+  {
+    if (client.finished)
+    {
+      closeClient(client);
+      return;
+    }
+    if (client.resource == RESOURCE_STREAM && (int32_t)(nowMs - client.nextLineMs) < 0)
+    {
+      client.state = CLIENT_WAITING;
+      return;
+    }
+    fillBuffer(client);
+  }
+
+  if (!sendBuffer(client) || nowMs - client.lastActivityMs >= TELEMETRY_IDLE_TIMEOUT_MS)
+  {
+    closeClient(client);
+  }
+
+}   //   serviceClient()
+
+void TelemetryServer::poll()
+{
+  checkWifi();
+  acceptClients();
+
+  //-- one step per client, starting at a different one every poll
+  for (uint8_t step = 0; step < TELEMETRY_MAX_CLIENTS; step++)
+  {
+    uint8_t slot = (uint8_t)((nextClient + step) % TELEMETRY_MAX_CLIENTS);
+    if (clients[slot].state != CLIENT_FREE)
+    {
+      serviceClient(clients[slot]);
+    }
+  }
+  nextClient = (uint8_t)((nextClient + 1) % TELEMETRY_MAX_CLIENTS);
+
+}   //   poll()
+
+bool TelemetryServer::isBusy() const
+{
+  for (uint8_t slot = 0; slot < TELEMETRY_MAX_CLIENTS; slot++)
+  {
+    if (clients[slot].state == CLIENT_READING || clients[slot].state == CLIENT_SENDING)
+    {
+      return true;
+    }
+  }
+  return false;
+
+}   //   isBusy()
+
+uint8_t TelemetryServer::clientCount() const
+{
+  uint8_t count = 0;
+  for (uint8_t slot = 0; slot < TELEMETRY_MAX_CLIENTS; slot++)
+  {
+    if (clients[slot].state != CLIENT_FREE)
+    {
+      count++;
+    }
+  }
+  return count;
+
+}   //   clientCount()
+
+#endif   //   TELEMETRY_ENABLED
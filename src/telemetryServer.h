@@ -0,0 +1,160 @@
+//--- Wi-Fi telemetry: LittleFS usage, the file listing and runtime metrics as chunked JSON over HTTP
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "fsIndex.h"
+#include "fsUsage.h"
+#include "memoryPool.h"
+
+//-- selected with -DUSE_TELEMETRY plus -DWIFI_SSID=\"...\" -DWIFI_PASSWORD=\"...\"
+//-- GET /usage, /files, /metrics answer once; /metrics/stream sends a line every
+//-- TELEMETRY_STREAM_MS until the client disconnects; with USE_CRASH_REPORT
+//-- GET /crash answers the crash summary of this boot; GET /output/<command>
+//-- hands on, off, toggle or blink to the command handler (setCommandHandler())
+#if defined(USE_TELEMETRY) && (defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266))
+  #define TELEMETRY_ENABLED 1
+#else
+  #define TELEMETRY_ENABLED 0
+#endif
+
+#if TELEMETRY_ENABLED
+
+#if !defined(WIFI_SSID) || !defined(WIFI_PASSWORD)
+  #error "USE_TELEMETRY needs WIFI_SSID and WIFI_PASSWORD in build_flags"
+#endif
+#if defined(USE_SLEEP_MODE)
+  #error "USE_TELEMETRY keeps the radio on, remove USE_SLEEP_MODE for this env"
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <WiFi.h>
+#else
+  #include <ESP8266WiFi.h>
+#endif
+
+#ifndef TELEMETRY_PORT
+  #define TELEMETRY_PORT 80
+#endif
+
+//-- clients served at the same time; one more is answered with 503
+#ifndef TELEMETRY_MAX_CLIENTS
+  #if defined(ARDUINO_ARCH_ESP32)
+    #define TELEMETRY_MAX_CLIENTS 4
+  #else
+    #define TELEMETRY_MAX_CLIENTS 1
+  #endif
+#endif
+
+//-- per client response buffer; one chunk is built in it and sent from it,
+//-- it must hold one complete metrics line
+#ifndef TELEMETRY_BUFFER_SIZE
+  #define TELEMETRY_BUFFER_SIZE 704
+#endif
+
+//-- longest request line that is looked at ("GET /metrics/stream HTTP/1.1");
+//-- taken per connection from the small-object pool (memSmallAlloc())
+#ifndef TELEMETRY_REQUEST_MAX
+  #define TELEMETRY_REQUEST_MAX MEM_SMALL_BLOCK_SIZE
+#endif
+
+//-- interval of the /metrics/stream lines
+#ifndef TELEMETRY_STREAM_MS
+  #define TELEMETRY_STREAM_MS 1000
+#endif
+
+//-- a client that sends nothing or takes nothing for this long is dropped
+#ifndef TELEMETRY_IDLE_TIMEOUT_MS
+  #define TELEMETRY_IDLE_TIMEOUT_MS 5000
+#endif
+
+//-- takes a command of GET /output/<command>, runs in poll(); false: refused
+typedef bool (*telemetryCommandHandler)(const char *command);
+
+static_assert(TELEMETRY_BUFFER_SIZE >= 2 * FS_INDEX_PATH_LEN + 64, "TELEMETRY_BUFFER_SIZE must hold one escaped file entry");
+static_assert(TELEMETRY_REQUEST_MAX <= 255, "TELEMETRY_REQUEST_MAX must fit requestLength");
+
+class TelemetryServer
+{
+  public:
+    //-- start the Wi-Fi connection; the server listens once it is up
+    void begin(FsIndex *index, FsUsage *usage);
+    void setCommandHandler(telemetryCommandHandler handler) { commandHandler = handler; }
+
+    //-- accept, read and send a little for every client, never waits on the network
+    void poll();
+
+    //-- true while a response is being sent (the loop should not idle long)
+    bool isBusy() const;
+    uint8_t clientCount() const;
+
+  private:
+    enum clientState : uint8_t
+    {
+      CLIENT_FREE = 0,
+      CLIENT_READING,
+      CLIENT_SENDING,
+      CLIENT_WAITING
+    };
+
+    enum clientResource : uint8_t
+    {
+      RESOURCE_INDEX = 0,
+      RESOURCE_USAGE,
+      RESOURCE_FILES,
+      RESOURCE_METRICS,
+      RESOURCE_STREAM,
+      RESOURCE_CRASH,
+      RESOURCE_OUTPUT,
+      RESOURCE_NOT_FOUND
+    };
+
+    struct telemetryClient
+    {
+      WiFiClient     connection;
+      clientState    state;
+      clientResource resource;
+      //-- next step of the response: 0 = status line, then resource specific
+      uint16_t       cursor;
+      bool           finished;
+      //-- RESOURCE_OUTPUT: the handler took the command (request holds its name)
+      bool           commandAccepted;
+      //-- RESOURCE_FILES: FsIndex::layoutVersion() when the listing started
+      uint32_t       indexVersion;
+      uint32_t       lastActivityMs;
+      uint32_t       nextLineMs;
+      //-- TELEMETRY_REQUEST_MAX bytes from memSmallAlloc() while the client is connected
+      char          *request;
+      uint8_t        requestLength;
+      bool           lineComplete;
+      //-- end of the request headers is found with a small "\r\n\r\n" matcher
+      uint8_t        headerMatch;
+      char           buffer[TELEMETRY_BUFFER_SIZE];
+      uint16_t       bufferLength;
+      uint16_t       bufferSent;
+    };
+
+    void   checkWifi();
+    void   acceptClients();
+    void   serviceClient(telemetryClient &client);
+    void   readRequest(telemetryClient &client);
+    void   parseRequest(telemetryClient &client);
+    void   fillBuffer(telemetryClient &client);
+    size_t formatBody(telemetryClient &client, char *body, size_t room);
+    size_t formatFiles(telemetryClient &client, char *body, size_t room);
+    bool   sendBuffer(telemetryClient &client);
+    void   closeClient(telemetryClient &client);
+
+    FsIndex         *fsIndex    = nullptr;
+    FsUsage         *fsUsage    = nullptr;
+    telemetryCommandHandler commandHandler = nullptr;
+    WiFiServer       server{TELEMETRY_PORT};
+    bool             wifiUp     = false;
+    bool             listening  = false;
+    uint8_t          nextClient = 0;
+    telemetryClient  clients[TELEMETRY_MAX_CLIENTS];
+
+};   //   TelemetryServer
+
+#endif   //   TELEMETRY_ENABLED
@@ -0,0 +1,75 @@
+//--- Time-sliced long operations: a budget per slice, a yield and watchdog feed between slices
+
+#include "workSlice.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+  #include <freertos/FreeRTOS.h>
+  #include <freertos/task.h>
+  #include <esp_task_wdt.h>
+#endif
+
+void workYield()
+{
+#if defined(ARDUINO_ARCH_ESP32)
+  //-- only a subscribed task may reset the watchdog (the loop task when
+  //-- the loop WDT is enabled); an idle task that starves trips it anyway,
+  //-- so block for a tick instead of a taskYIELD() that lower priorities never see
+  if (esp_task_wdt_status(nullptr) == ESP_OK)
+  {
+    esp_task_wdt_reset();
+  }
+  vTaskDelay(1);
+#elif defined(ARDUINO_ARCH_ESP8266)
+  ESP.wdtFeed();
+  yield();
+#else
+  yield();
+#endif
+
+}   //   workYield()
+
+void WorkSlice::begin()
+{
+  startMs        = millis();
+  lastProgressMs = startMs;
+  sliceStartUs   = micros();
+  slices         = 0;
+  longestUs      = 0;
+
+}   //   begin()
+
+void WorkSlice::endSlice()
+{
+  uint32_t usedUs = micros() - sliceStartUs;
+  if (usedUs > longestUs)
+  {
+    longestUs = usedUs;
+  }
+  slices++;
+
+}   //   endSlice()
+
+bool WorkSlice::pace()
+{
+  if (!isExpired())
+  {
+    return false;
+  }
+  endSlice();
+  workYield();
+  nextSlice();
+  return true;
+
+}   //   pace()
+
+bool WorkSlice::progressDue()
+{
+  uint32_t nowMs = millis();
+  if (nowMs - lastProgressMs < WORK_PROGRESS_MS)
+  {
+    return false;
+  }
+  lastProgressMs = nowMs;
+  return true;
+
+}   //   progressDue()
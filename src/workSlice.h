@@ -0,0 +1,57 @@
+//--- Time-sliced long operations: a budget per slice, a yield and watchdog feed between slices
+
+#pragma once
+
+#include <Arduino.h>
+
+//-- longest stretch a long operation may run before it lets others run
+#ifndef WORK_SLICE_BUDGET_US
+  #define WORK_SLICE_BUDGET_US 5000
+#endif
+
+//-- a long operation reports its progress at most this often
+#ifndef WORK_PROGRESS_MS
+  #define WORK_PROGRESS_MS 1000
+#endif
+
+//-- end a slice: feed the task watchdog (ESP32, when this task is watched) and
+//-- let the idle task run; on ESP8266 yield() keeps the soft watchdog quiet
+void workYield();
+
+class WorkSlice
+{
+  public:
+    explicit WorkSlice(uint32_t budgetUs = WORK_SLICE_BUDGET_US) : budgetUs(budgetUs) {}
+
+    //-- start the operation and its first slice
+    void begin();
+
+    //-- the current slice used up its budget
+    bool isExpired() const { return (micros() - sliceStartUs) >= budgetUs; }
+
+    //-- call between steps: ends the slice with workYield() once it is
+    //-- used up and starts the next one; returns true when it yielded
+    bool pace();
+
+    //-- close the current slice without yielding (a resumable step returns instead)
+    void endSlice();
+
+    //-- start the next slice of a resumable operation
+    void nextSlice() { sliceStartUs = micros(); }
+
+    //-- true at most every WORK_PROGRESS_MS, for "still busy" lines
+    bool progressDue();
+
+    uint32_t sliceCount() const { return slices; }
+    uint32_t maxSliceUs() const { return longestUs; }
+    uint32_t elapsedMs() const  { return millis() - startMs; }
+
+  private:
+    uint32_t budgetUs;
+    uint32_t startMs        = 0;
+    uint32_t sliceStartUs   = 0;
+    uint32_t lastProgressMs = 0;
+    uint32_t slices         = 0;
+    uint32_t longestUs      = 0;
+
+};   //   WorkSlice
@@ -0,0 +1,135 @@
+//--- Minimal Arduino core for the host (native env): fake clock and a capturing Serial
+
+#include "Arduino.h"
+
+HostSerial Serial;
+
+//-- microseconds since fakeClockReset(); millis() is derived from it so both stay in step
+static uint64_t fakeNowUs     = 0;
+static uint32_t fakeDelayedMs = 0;
+
+void fakeClockSetMs(uint32_t nowMs)
+{
+  fakeNowUs = (uint64_t)nowMs * 1000;
+
+}   //   fakeClockSetMs()
+
+void fakeClockAdvanceMs(uint32_t ms)
+{
+  fakeNowUs += (uint64_t)ms * 1000;
+
+}   //   fakeClockAdvanceMs()
+
+void fakeClockAdvanceUs(uint32_t us)
+{
+  fakeNowUs += us;
+
+}   //   fakeClockAdvanceUs()
+
+uint32_t fakeClockDelayedMs()
+{
+  return fakeDelayedMs;
+
+}   //   fakeClockDelayedMs()
+
+void fakeClockReset()
+{
+  fakeNowUs     = 0;
+  fakeDelayedMs = 0;
+
+}   //   fakeClockReset()
+
+uint32_t millis()
+{
+  return (uint32_t)(fakeNowUs / 1000);
+
+}   //   millis()
+
+uint32_t micros()
+{
+  return (uint32_t)fakeNowUs;
+
+}   //   micros()
+
+void delay(uint32_t ms)
+{
+  fakeDelayedMs += ms;
+  fakeClockAdvanceMs(ms);
+
+}   //   delay()
+
+void delayMicroseconds(uint32_t us)
+{
+  fakeClockAdvanceUs(us);
+
+}   //   delayMicroseconds()
+
+void yield()
+{
+}   //   yield()
+
+size_t HostSerial::write(uint8_t data)
+{
+  return write(&data, 1);
+
+}   //   write()
+
+size_t HostSerial::write(const uint8_t *data, size_t length)
+{
+  captured.append((const char *)data, length);
+  if (echo)
+  {
+    fwrite(data, 1, length, stdout);
+  }
+  return length;
+
+}   //   write()
+
+size_t HostSerial::print(const char *text)
+{
+  return write((const uint8_t *)text, strlen(text));
+
+}   //   print()
+
+size_t HostSerial::println(const char *text)
+{
+  return print(text) + print("\r\n");
+
+}   //   println()
+
+size_t HostSerial::printf(const char *format, ...)
+{
+  char    line[256];
+  va_list arguments;
+
+  va_start(arguments, format);
+  int length = vsnprintf(line, sizeof(line), format, arguments);
+  va_end(arguments);
+
+  if (length < 0)
+  {
+    return 0;
+  }
+  if ((size_t)length >= sizeof(line))
+  {
+    length = sizeof(line) - 1;
+  }
+  return write((const uint8_t *)line, (size_t)length);
+
+}   //   printf()
+
+int HostSerial::read()
+{
+  if (inputPosition >= input.size())
+  {
+    return -1;
+  }
+  int data = (uint8_t)input[inputPosition++];
+  if (inputPosition == input.size())
+  {
+    input.clear();
+    inputPosition = 0;
+  }
+  return data;
+
+}   //   read()
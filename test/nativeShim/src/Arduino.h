@@ -0,0 +1,65 @@
+//--- Minimal Arduino core for the host (native env): fake clock and a capturing Serial
+
+#pragma once
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "fakeClock.h"
+
+#define PROGMEM
+#define IRAM_ATTR
+#define memcpy_P            memcpy
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+
+uint32_t millis();
+uint32_t micros();
+//-- advances the fake clock instead of sleeping
+void     delay(uint32_t ms);
+void     delayMicroseconds(uint32_t us);
+void     yield();
+
+//-- single threaded host: nothing to mask
+inline void noInterrupts() {}
+inline void interrupts()   {}
+
+//-- Serial replacement: output is captured for the tests, input is fed by them
+class HostSerial
+{
+  public:
+    void   begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t length);
+    size_t print(const char *text);
+    size_t println(const char *text = "");
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    //-- room in the (fake) UART FIFO, see setWriteRoom()
+    int    availableForWrite() { return writeRoom; }
+    int    available() { return (int)(input.size() - inputPosition); }
+    int    read();
+    void   flush() {}
+
+    //-- test hooks
+    const std::string &output() const { return captured; }
+    void clearOutput() { captured.clear(); }
+    void setWriteRoom(int room) { writeRoom = room; }
+    void feed(const char *text) { input += text; }
+    //-- also echo everything to stdout (benchmarks and debugging)
+    void setEcho(bool on) { echo = on; }
+
+  private:
+    std::string captured;
+    std::string input;
+    size_t      inputPosition = 0;
+    int         writeRoom     = 128;
+    bool        echo          = false;
+
+};   //   HostSerial
+
+extern HostSerial Serial;
@@ -0,0 +1,383 @@
+//--- RAM-backed fs::FS for the host (native env), ESP32 core style File API
+
+#include "FS.h"
+
+namespace fs
+{
+
+size_t File::write(const uint8_t *data, size_t length)
+{
+  if (!handle || !handle->writable || handle->node->isDirectory)
+  {
+    return 0;
+  }
+  std::vector<uint8_t> &content = handle->node->data;
+  if (handle->append)
+  {
+    handle->position = content.size();
+  }
+  if (handle->position + length > content.size())
+  {
+    content.resize(handle->position + length);
+  }
+  memcpy(&content[handle->position], data, length);
+  handle->position += length;
+  return length;
+
+}   //   write()
+
+int File::read()
+{
+  uint8_t data;
+  return (read(&data, 1) == 1) ? data : -1;
+
+}   //   read()
+
+size_t File::read(uint8_t *buffer, size_t length)
+{
+  if (!handle || !handle->readable || handle->node->isDirectory)
+  {
+    return 0;
+  }
+  const std::vector<uint8_t> &content = handle->node->data;
+  if (handle->position >= content.size())
+  {
+    return 0;
+  }
+  if (length > content.size() - handle->position)
+  {
+    length = content.size() - handle->position;
+  }
+  memcpy(buffer, &content[handle->position], length);
+  handle->position += length;
+  return length;
+
+}   //   read()
+
+int File::available()
+{
+  if (!handle || handle->node->isDirectory)
+  {
+    return 0;
+  }
+  size_t length = handle->node->data.size();
+  return (handle->position < length) ? (int)(length - handle->position) : 0;
+
+}   //   available()
+
+bool File::seek(uint32_t position)
+{
+  if (!handle || position > handle->node->data.size())
+  {
+    return false;
+  }
+  handle->position = position;
+  return true;
+
+}   //   seek()
+
+size_t File::position() const
+{
+  return handle ? handle->position : 0;
+
+}   //   position()
+
+size_t File::size() const
+{
+  return handle ? handle->node->data.size() : 0;
+
+}   //   size()
+
+const char *File::name() const
+{
+  if (!handle)
+  {
+    return "";
+  }
+  const char *lastSlash = strrchr(handle->path.c_str(), '/');
+  return (lastSlash != nullptr && lastSlash[1] != '\0') ? lastSlash + 1 : handle->path.c_str();
+
+}   //   name()
+
+const char *File::path() const
+{
+  return handle ? handle->path.c_str() : "";
+
+}   //   path()
+
+bool File::isDirectory() const
+{
+  return handle && handle->node->isDirectory;
+
+}   //   isDirectory()
+
+File File::openNextFile(const char *mode)
+{
+  if (!handle || !handle->node->isDirectory)
+  {
+    return File();
+  }
+  return handle->owner->openNextChild(*handle, mode);
+
+}   //   openNextFile()
+
+void File::rewindDirectory()
+{
+  if (handle)
+  {
+    handle->lastChild.clear();
+  }
+
+}   //   rewindDirectory()
+
+FS::FS()
+{
+  clear();
+
+}   //   FS()
+
+std::string FS::normalize(const char *path)
+{
+  std::string result = (path != nullptr) ? path : "";
+  if (result.empty() || result[0] != '/')
+  {
+    result.insert(0, "/");
+  }
+  while (result.size() > 1 && result[result.size() - 1] == '/')
+  {
+    result.erase(result.size() - 1);
+  }
+  return result;
+
+}   //   normalize()
+
+std::string FS::parentOf(const std::string &path)
+{
+  size_t lastSlash = path.rfind('/');
+  return (lastSlash == 0 || lastSlash == std::string::npos) ? std::string("/") : path.substr(0, lastSlash);
+
+}   //   parentOf()
+
+bool FS::hasChildren(const std::string &path) const
+{
+  std::string prefix = (path == "/") ? path : path + "/";
+  nodeMap::const_iterator child = nodes.upper_bound(prefix);
+  return (child != nodes.end() && child->first.compare(0, prefix.size(), prefix) == 0);
+
+}   //   hasChildren()
+
+File FS::open(const char *path, const char *mode, bool create)
+{
+  std::string fullPath = normalize(path);
+  bool        reading  = (mode == nullptr || mode[0] == 'r');
+  bool        plus     = (mode != nullptr && strchr(mode, '+') != nullptr);
+
+  opens++;
+
+  nodeMap::iterator found = nodes.find(fullPath);
+  if (reading)
+  {
+    if (found == nodes.end())
+    {
+      return File();
+    }
+  }
+  else
+  {
+    if (found != nodes.end() && found->second->isDirectory)
+    {
+      return File();
+    }
+    if (found == nodes.end())
+    {
+      std::string parent = parentOf(fullPath);
+      nodeMap::iterator parentNode = nodes.find(parent);
+      if (parentNode == nodes.end())
+      {
+        if (!create)
+        {
+          return File();
+        }
+        //-- create=true makes the missing directories, as the ESP32 LittleFS does
+        for (size_t slash = parent.find('/', 1); ; slash = parent.find('/', slash + 1))
+        {
+          mkdir(parent.substr(0, slash).c_str());
+          if (slash == std::string::npos)
+          {
+            break;
+          }
+        }
+      }
+      else if (!parentNode->second->isDirectory)
+      {
+        return File();
+      }
+      std::shared_ptr<ramNode> node(new ramNode());
+      node->isDirectory = false;
+      found = nodes.insert(std::make_pair(fullPath, node)).first;
+    }
+    else if (mode[0] == 'w')
+    {
+      found->second->data.clear();
+    }
+  }
+
+  std::shared_ptr<ramHandle> handle(new ramHandle());
+  handle->owner    = this;
+  handle->path     = fullPath;
+  handle->node     = found->second;
+  handle->readable = reading || plus;
+  handle->writable = !reading || plus;
+  handle->append   = (mode != nullptr && mode[0] == 'a');
+  handle->position = handle->append ? found->second->data.size() : 0;
+  return File(handle);
+
+}   //   open()
+
+File FS::openNextChild(ramHandle &directory, const char *mode)
+{
+  std::string prefix = (directory.path == "/") ? directory.path : directory.path + "/";
+  nodeMap::iterator child = directory.lastChild.empty()
+                            ? nodes.upper_bound(prefix)
+                            : nodes.upper_bound(directory.lastChild);
+
+  for (; child != nodes.end(); ++child)
+  {
+    if (child->first.compare(0, prefix.size(), prefix) != 0)
+    {
+      break;
+    }
+    //-- skip grandchildren, they sort right behind their directory
+    if (child->first.find('/', prefix.size()) != std::string::npos)
+    {
+      continue;
+    }
+    directory.lastChild = child->first;
+    return open(child->first.c_str(), mode);
+  }
+
+  return File();
+
+}   //   openNextChild()
+
+bool FS::exists(const char *path)
+{
+  return nodes.find(normalize(path)) != nodes.end();
+
+}   //   exists()
+
+bool FS::remove(const char *path)
+{
+  nodeMap::iterator found = nodes.find(normalize(path));
+  if (found == nodes.end() || found->second->isDirectory)
+  {
+    return false;
+  }
+  nodes.erase(found);
+  return true;
+
+}   //   remove()
+
+bool FS::rename(const char *fromPath, const char *toPath)
+{
+  std::string from = normalize(fromPath);
+  std::string to   = normalize(toPath);
+
+  nodeMap::iterator source = nodes.find(from);
+  if (source == nodes.end() || from == "/" || nodes.find(parentOf(to)) == nodes.end())
+  {
+    return false;
+  }
+
+  //-- like lfs_rename(): a file target is replaced, a non-empty directory is not
+  nodeMap::iterator target = nodes.find(to);
+  if (target != nodes.end())
+  {
+    if (target->second->isDirectory != source->second->isDirectory || hasChildren(to))
+    {
+      return false;
+    }
+    nodes.erase(target);
+  }
+
+  std::string              prefix = from + "/";
+  std::vector<std::string> moved;
+  for (nodeMap::iterator node = nodes.begin(); node != nodes.end(); ++node)
+  {
+    if (node->first == from || node->first.compare(0, prefix.size(), prefix) == 0)
+    {
+      moved.push_back(node->first);
+    }
+  }
+  for (size_t index = 0; index < moved.size(); index++)
+  {
+    std::shared_ptr<ramNode> node = nodes[moved[index]];
+    nodes.erase(moved[index]);
+    nodes[to + moved[index].substr(from.size())] = node;
+  }
+  return true;
+
+}   //   rename()
+
+bool FS::mkdir(const char *path)
+{
+  std::string fullPath = normalize(path);
+  if (nodes.find(fullPath) != nodes.end())
+  {
+    return false;
+  }
+  nodeMap::iterator parent = nodes.find(parentOf(fullPath));
+  if (parent == nodes.end() || !parent->second->isDirectory)
+  {
+    return false;
+  }
+
+  std::shared_ptr<ramNode> node(new ramNode());
+  node->isDirectory = true;
+  nodes[fullPath]   = node;
+  return true;
+
+}   //   mkdir()
+
+bool FS::rmdir(const char *path)
+{
+  std::string fullPath = normalize(path);
+  nodeMap::iterator found = nodes.find(fullPath);
+  if (found == nodes.end() || !found->second->isDirectory || fullPath == "/" || hasChildren(fullPath))
+  {
+    return false;
+  }
+  nodes.erase(found);
+  return true;
+
+}   //   rmdir()
+
+void FS::clear()
+{
+  nodes.clear();
+  std::shared_ptr<ramNode> root(new ramNode());
+  root->isDirectory = true;
+  nodes["/"]        = root;
+
+}   //   clear()
+
+size_t FS::usedBytes(size_t blockSize) const
+{
+  //-- superblock pair, then a metadata pair per directory and whole blocks per file
+  size_t blocks = 2;
+  for (nodeMap::const_iterator node = nodes.begin(); node != nodes.end(); ++node)
+  {
+    if (node->second->isDirectory)
+    {
+      blocks += (node->first == "/") ? 0 : 2;
+    }
+    else
+    {
+      blocks += (node->second->data.size() + blockSize - 1) / blockSize;
+    }
+  }
+  return blocks * blockSize;
+
+}   //   usedBytes()
+
+}   //   namespace fs
@@ -0,0 +1,111 @@
+//--- RAM-backed fs::FS for the host (native env), ESP32 core style File API
+
+#pragma once
+
+#include <Arduino.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs
+{
+
+struct ramNode
+{
+  bool                 isDirectory;
+  std::vector<uint8_t> data;
+};
+
+class FS;
+
+//-- shared by all copies of one File, as the core's FileImplPtr is
+struct ramHandle
+{
+  FS                       *owner;
+  std::string               path;
+  std::shared_ptr<ramNode>  node;
+  size_t                    position;
+  bool                      readable;
+  bool                      writable;
+  bool                      append;
+  //-- directory iteration: last child handed out by openNextFile()
+  std::string               lastChild;
+};
+
+class File
+{
+  public:
+    File() {}
+    explicit File(std::shared_ptr<ramHandle> handle) : handle(handle) {}
+
+    operator bool() const { return (bool)handle; }
+
+    size_t write(uint8_t data) { return write(&data, 1); }
+    size_t write(const uint8_t *data, size_t length);
+    int    read();
+    size_t read(uint8_t *buffer, size_t length);
+    int    available();
+    bool   seek(uint32_t position);
+    size_t position() const;
+    size_t size() const;
+    void   flush() {}
+    void   close() { handle.reset(); }
+
+    //-- name() is the last path component, as on the 2.x ESP32 cores
+    const char *name() const;
+    const char *path() const;
+    bool        isDirectory() const;
+    File        openNextFile(const char *mode = FILE_READ);
+    void        rewindDirectory();
+
+  private:
+    std::shared_ptr<ramHandle> handle;
+
+};   //   File
+
+class FS
+{
+  public:
+    FS();
+
+    File open(const char *path, const char *mode = FILE_READ, bool create = false);
+    bool exists(const char *path);
+    bool remove(const char *path);
+    bool rename(const char *fromPath, const char *toPath);
+    bool mkdir(const char *path);
+    bool rmdir(const char *path);
+
+    //-- host extras for the tests
+    //-- drop everything but the root directory
+    void   clear();
+    //-- bytes the tree would take with blockSize byte blocks (LittleFS style accounting)
+    size_t usedBytes(size_t blockSize) const;
+    //-- open()/openNextFile() calls, i.e. simulated flash accesses
+    uint32_t openCount() const { return opens; }
+    void     resetOpenCount() { opens = 0; }
+
+  private:
+    friend class File;
+
+    typedef std::map<std::string, std::shared_ptr<ramNode> > nodeMap;
+
+    static std::string normalize(const char *path);
+    static std::string parentOf(const std::string &path);
+    bool               hasChildren(const std::string &path) const;
+    File               openNextChild(ramHandle &directory, const char *mode);
+
+    nodeMap  nodes;
+    uint32_t opens = 0;
+
+};   //   FS
+
+}   //   namespace fs
+
+using fs::FS;
+using fs::File;
@@ -0,0 +1,32 @@
+//--- Host LittleFS: the RAM-backed fs::FS with the ESP32 LittleFSFS interface
+
+#include "LittleFS.h"
+
+LittleFSFS LittleFS;
+
+bool LittleFSFS::begin(bool formatOnFail, const char *basePath, uint8_t maxOpenFiles, const char *label)
+{
+  (void)basePath;
+  (void)maxOpenFiles;
+  (void)label;
+
+  if (isCorrupt)
+  {
+    if (!formatOnFail)
+    {
+      return false;
+    }
+    format();
+  }
+  mounted = true;
+  return true;
+
+}   //   begin()
+
+bool LittleFSFS::format()
+{
+  clear();
+  isCorrupt = false;
+  return true;
+
+}   //   format()
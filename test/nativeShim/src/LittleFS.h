@@ -0,0 +1,35 @@
+//--- Host LittleFS: the RAM-backed fs::FS with the ESP32 LittleFSFS interface
+
+#pragma once
+
+#include <FS.h>
+
+//-- size the host "partition" reports unless a test changes it
+#ifndef NATIVE_LITTLEFS_BYTES
+  #define NATIVE_LITTLEFS_BYTES (1024 * 1024)
+#endif
+
+class LittleFSFS : public fs::FS
+{
+  public:
+    bool begin(bool formatOnFail = false, const char *basePath = "/littlefs", uint8_t maxOpenFiles = 10, const char *label = "spiffs");
+    void end() { mounted = false; }
+    bool format();
+
+    size_t totalBytes() { return partitionBytes; }
+    size_t usedBytes()  { return fs::FS::usedBytes(4096); }
+
+    //-- test hooks
+    void setTotalBytes(size_t bytes) { partitionBytes = bytes; }
+    //-- make the next begin() calls fail, as a corrupt partition would
+    void setCorrupt(bool corrupt) { isCorrupt = corrupt; }
+    bool isMounted() const { return mounted; }
+
+  private:
+    size_t partitionBytes = NATIVE_LITTLEFS_BYTES;
+    bool   mounted        = false;
+    bool   isCorrupt      = false;
+
+};   //   LittleFSFS
+
+extern LittleFSFS LittleFS;
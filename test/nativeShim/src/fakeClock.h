@@ -0,0 +1,18 @@
+//--- Fake clock behind millis()/micros()/delay() for host tests
+
+#pragma once
+
+#include <stdint.h>
+
+//-- set the clock; tests start near a wrap-around point with e.g. 0xFFFFFF00
+void fakeClockSetMs(uint32_t nowMs);
+
+//-- move the clock forward, as a blocking delay would
+void fakeClockAdvanceMs(uint32_t ms);
+void fakeClockAdvanceUs(uint32_t us);
+
+//-- total milliseconds handed to delay() since the last reset
+uint32_t fakeClockDelayedMs();
+
+//-- back to 0 ms, delay total cleared
+void fakeClockReset();
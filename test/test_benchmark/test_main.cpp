@@ -0,0 +1,190 @@
+//--- Host micro-benchmarks of the firmware hot paths, run with "pio test -e native -f test_benchmark -v"
+//--- times are host nanoseconds: compare runs against each other, not against the target
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include <chrono>
+
+#include "fsIndex.h"
+#include "logger.h"
+#include "memoryPool.h"
+#include "pixelEffects.h"
+#include "taskScheduler.h"
+
+static const uint32_t ITERATIONS = 100000;
+
+static volatile uint32_t sink = 0;
+
+typedef std::chrono::steady_clock benchClock;
+
+static void benchReport(const char *name, benchClock::time_point startTime, uint32_t iterations)
+{
+  double totalNs = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(benchClock::now() - startTime).count();
+  char   line[96];
+
+  snprintf(line, sizeof(line), "%-28s %9.1f ns/op", name, totalNs / iterations);
+  TEST_MESSAGE(line);
+
+}   //   benchReport()
+
+static void idleTask() { sink = sink + 1; }
+
+void setUp()
+{
+  fakeClockReset();
+  Serial.clearOutput();
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- the common case in loop(): a full table and nothing due
+static void benchSchedulerNothingDue()
+{
+  TaskScheduler scheduler;
+  for (int slot = 0; slot < SCHEDULER_MAX_TASKS; slot++)
+  {
+    scheduler.addPeriodic("idle", idleTask, 1000, 1000);
+  }
+
+  benchClock::time_point startTime = benchClock::now();
+  for (uint32_t round = 0; round < ITERATIONS; round++)
+  {
+    scheduler.run();
+    sink = sink + scheduler.msUntilNext();
+  }
+  benchReport("scheduler run+msUntilNext", startTime, ITERATIONS);
+  TEST_ASSERT_EQUAL_UINT32(1000, scheduler.msUntilNext());
+
+}   //   benchSchedulerNothingDue()
+
+static void benchIndexFind()
+{
+  char path[32];
+
+  LittleFS.format();
+  for (int file = 0; file < FS_INDEX_MAX_ENTRIES - 8; file++)
+  {
+    snprintf(path, sizeof(path), "/file%03d.txt", file);
+    LittleFS.open(path, "w").close();
+  }
+
+  FsIndex index;
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+
+  benchClock::time_point startTime = benchClock::now();
+  for (uint32_t round = 0; round < ITERATIONS; round++)
+  {
+    snprintf(path, sizeof(path), "/file%03u.txt", (unsigned)(round % (FS_INDEX_MAX_ENTRIES - 8)));
+    sink = sink + (index.find(path) != nullptr);
+  }
+  benchReport("fsIndex find (+snprintf)", startTime, ITERATIONS);
+
+  startTime = benchClock::now();
+  for (uint32_t round = 0; round < 100; round++)
+  {
+    index.invalidate();
+    index.rescanIfNeeded();
+  }
+  benchReport("fsIndex rescan", startTime, 100);
+
+}   //   benchIndexFind()
+
+static void benchLoggerWrite()
+{
+  logBegin();
+  Serial.setWriteRoom(LOG_BUFFER_SIZE);
+
+  benchClock::time_point startTime = benchClock::now();
+  for (uint32_t round = 0; round < ITERATIONS; round++)
+  {
+    LOG_INFO("run %u took %u us\n", (unsigned)round, 42u);
+    if ((round & 31) == 31)
+    {
+      logFlush();
+      Serial.clearOutput();
+    }
+  }
+  benchReport("logWrite (+flush/32)", startTime, ITERATIONS);
+  TEST_ASSERT_EQUAL_UINT32(0, logDroppedCount());
+
+}   //   benchLoggerWrite()
+
+static void benchEffectsFrame()
+{
+  static uint8_t frame[3 * 60];
+  PixelEffects   effects(frame, 60);
+  effectConfig   config;
+  config.type = EFFECT_PALETTE;
+  effects.setEffect(config);
+
+  benchClock::time_point startTime = benchClock::now();
+  for (uint32_t round = 0; round < ITERATIONS / 10; round++)
+  {
+    effects.renderFrame(round * 20);
+  }
+  benchReport("palette frame, 60 pixels", startTime, ITERATIONS / 10);
+  TEST_ASSERT_EQUAL_UINT32(ITERATIONS / 10, effects.stats().framesRendered);
+
+}   //   benchEffectsFrame()
+
+static void benchSmallAllocations()
+{
+  void *blocks[8];
+
+  benchClock::time_point startTime = benchClock::now();
+  for (uint32_t round = 0; round < ITERATIONS; round++)
+  {
+    for (int block = 0; block < 8; block++)
+    {
+      blocks[block] = memSmallAlloc(48);
+    }
+    for (int block = 0; block < 8; block++)
+    {
+      memSmallFree(blocks[block]);
+    }
+  }
+  benchReport("memSmallAlloc+Free x8", startTime, ITERATIONS);
+
+  startTime = benchClock::now();
+  for (uint32_t round = 0; round < ITERATIONS; round++)
+  {
+    for (int block = 0; block < 8; block++)
+    {
+      blocks[block] = malloc(48);
+    }
+    for (int block = 0; block < 8; block++)
+    {
+      free(blocks[block]);
+    }
+  }
+  benchReport("malloc+free x8 (reference)", startTime, ITERATIONS);
+
+  memoryStats stats;
+  memGetStats(stats);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.poolMisses);
+  TEST_ASSERT_EQUAL_UINT16(0, stats.poolUsed);
+
+}   //   benchSmallAllocations()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  LittleFS.begin();
+  memBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(benchSchedulerNothingDue);
+  RUN_TEST(benchIndexFind);
+  RUN_TEST(benchLoggerWrite);
+  RUN_TEST(benchEffectsFrame);
+  RUN_TEST(benchSmallAllocations);
+  return UNITY_END();
+
+}   //   main()
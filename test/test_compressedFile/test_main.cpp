@@ -0,0 +1,282 @@
+//--- Host tests for the streaming heatshrink reader (compressedFile.cpp) on the RAM-backed LittleFS,
+//--- run with "pio test -e native"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "compressedFile.h"
+#include "crc32.h"
+#include "fsIndex.h"
+
+//-- bit stream writer in the heatshrink order (most significant bit first)
+struct bitStream
+{
+  std::vector<uint8_t> bytes;
+  uint8_t              used = 0;
+
+  void write(uint32_t value, uint8_t count)
+  {
+    for (int8_t bit = count - 1; bit >= 0; bit--)
+    {
+      if (used == 0)
+      {
+        bytes.push_back(0);
+      }
+      if ((value >> bit) & 1)
+      {
+        bytes.back() |= (uint8_t)(0x80 >> used);
+      }
+      used = (used + 1) & 7;
+    }
+  }
+  void literal(uint8_t value)                              { write(1, 1); write(value, 8); }
+  void backref(uint16_t distance, uint16_t count, uint8_t w, uint8_t l)
+  {
+    write(0, 1);
+    write(distance - 1, w);
+    write(count - 1, l);
+  }
+
+};   //   bitStream
+
+//-- greedy reference encoder, the same stream format compressData.py writes
+static std::vector<uint8_t> encode(const std::string &text, uint8_t windowBits, uint8_t lookaheadBits)
+{
+  bitStream stream;
+  size_t    window = (size_t)1 << windowBits;
+  size_t    limit  = (size_t)1 << lookaheadBits;
+
+  for (size_t position = 0; position < text.size();)
+  {
+    size_t bestLength   = 0;
+    size_t bestDistance = 0;
+    for (size_t distance = 1; distance <= window && distance <= position; distance++)
+    {
+      size_t length = 0;
+      while (length < limit && position + length < text.size()
+             && text[position - distance + length] == text[position + length])
+      {
+        length++;
+      }
+      if (length > bestLength)
+      {
+        bestLength   = length;
+        bestDistance = distance;
+      }
+    }
+    if (bestLength >= 2)
+    {
+      stream.backref((uint16_t)bestDistance, (uint16_t)bestLength, windowBits, lookaheadBits);
+      position += bestLength;
+    }
+    else
+    {
+      stream.literal((uint8_t)text[position]);
+      position++;
+    }
+  }
+  return stream.bytes;
+
+}   //   encode()
+
+static void writeStored(const char *path, const std::string &text, const std::vector<uint8_t> &stream,
+                        uint8_t windowBits, uint8_t lookaheadBits)
+{
+  compressedHeader header = {};
+  memcpy(header.magic, "HSZ1", 4);
+  header.windowBits    = windowBits;
+  header.lookaheadBits = lookaheadBits;
+  header.logicalSize   = (uint32_t)text.size();
+  header.crc32         = crc32Update(0, (const uint8_t *)text.data(), text.size());
+
+  File file = LittleFS.open(path, "w");
+  file.write((const uint8_t *)&header, sizeof(header));
+  file.write(stream.data(), stream.size());
+
+}   //   writeStored()
+
+static std::string sampleText()
+{
+  std::string text;
+  char        line[64];
+  for (int number = 0; number < 40; number++)
+  {
+    snprintf(line, sizeof(line), "line %03d: the quick brown fox jumps over the lazy dog\n", number);
+    text += line;
+  }
+  return text;
+
+}   //   sampleText()
+
+static std::string readAll(CompressedFile &file, size_t chunk)
+{
+  std::string          text;
+  std::vector<uint8_t> buffer(chunk);
+  size_t               got;
+  while ((got = file.read(buffer.data(), chunk)) > 0)
+  {
+    text.append((const char *)buffer.data(), got);
+  }
+  return text;
+
+}   //   readAll()
+
+void setUp()
+{
+  LittleFS.format();
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- "/a.txt" finds "/a.txt.hs"; the text spans several windows
+static void testCompressedRoundTrip()
+{
+  std::string text = sampleText();
+  writeStored("/a.txt.hs", text, encode(text, 8, 4), 8, 4);
+
+  CompressedFile file;
+  TEST_ASSERT_TRUE(file.open(LittleFS, "/a.txt"));
+  TEST_ASSERT_TRUE(file.isCompressed());
+  TEST_ASSERT_EQUAL_UINT32(text.size(), file.size());
+  TEST_ASSERT_TRUE(file.storedSize() < text.size() / 2);
+
+  TEST_ASSERT_TRUE(readAll(file, 37) == text);
+  TEST_ASSERT_FALSE(file.isDamaged());
+  TEST_ASSERT_EQUAL_INT(0, file.available());
+  TEST_ASSERT_EQUAL_INT(-1, file.read());
+
+}   //   testCompressedRoundTrip()
+
+//-- a back reference longer than its distance repeats itself (a run)
+static void testOverlappingRun()
+{
+  bitStream stream;
+  stream.literal('a');
+  stream.literal('b');
+  stream.backref(2, 9, 6, 4);
+  writeStored("/run.hs", "ababababab" "a", stream.bytes, 6, 4);
+
+  CompressedFile file;
+  TEST_ASSERT_TRUE(file.open(LittleFS, "/run"));
+  TEST_ASSERT_TRUE(readAll(file, 4) == "abababababa");
+  TEST_ASSERT_FALSE(file.isDamaged());
+
+}   //   testOverlappingRun()
+
+//-- a plain file is read as is, peek() does not move the position
+static void testPlainPassThrough()
+{
+  {
+    File plain = LittleFS.open("/plain.txt", "w");
+    plain.write((const uint8_t *)"hello", 5);
+  }
+
+  CompressedFile file;
+  TEST_ASSERT_TRUE(file.open(LittleFS, "/plain.txt"));
+  TEST_ASSERT_FALSE(file.isCompressed());
+  TEST_ASSERT_EQUAL_UINT32(5, file.size());
+  TEST_ASSERT_EQUAL_INT('h', file.peek());
+  TEST_ASSERT_EQUAL_UINT32(0, file.position());
+  TEST_ASSERT_TRUE(readAll(file, 2) == "hello");
+  TEST_ASSERT_EQUAL_UINT32(5, file.position());
+
+  TEST_ASSERT_FALSE(file.open(LittleFS, "/missing.txt"));
+
+}   //   testPlainPassThrough()
+
+//-- forward seeks decode on, backward seeks start over
+static void testSeek()
+{
+  std::string text = sampleText();
+  writeStored("/s.txt.hs", text, encode(text, 8, 4), 8, 4);
+
+  CompressedFile file;
+  TEST_ASSERT_TRUE(file.open(LittleFS, "/s.txt"));
+  TEST_ASSERT_TRUE(file.seek(1000));
+  TEST_ASSERT_EQUAL_INT(text[1000], file.read());
+  TEST_ASSERT_TRUE(file.seek(10));
+  TEST_ASSERT_EQUAL_UINT32(10, file.position());
+  TEST_ASSERT_EQUAL_INT(text[10], file.read());
+  TEST_ASSERT_FALSE(file.seek(text.size() + 1));
+
+}   //   testSeek()
+
+//-- a flipped bit is noticed by the CRC, a cut stream by running out of bits
+static void testDamageIsDetected()
+{
+  std::string          text   = sampleText();
+  std::vector<uint8_t> stream = encode(text, 8, 4);
+
+  std::vector<uint8_t> flipped = stream;
+  flipped[flipped.size() / 2] ^= 0x01;
+  writeStored("/f.hs", text, flipped, 8, 4);
+  {
+    CompressedFile file;
+    TEST_ASSERT_TRUE(file.open(LittleFS, "/f"));
+    readAll(file, 64);
+    TEST_ASSERT_TRUE(file.isDamaged());
+  }
+
+  std::vector<uint8_t> cut(stream.begin(), stream.begin() + stream.size() / 2);
+  writeStored("/c.hs", text, cut, 8, 4);
+  {
+    CompressedFile file;
+    TEST_ASSERT_TRUE(file.open(LittleFS, "/c"));
+    TEST_ASSERT_TRUE(readAll(file, 64).size() < text.size());
+    TEST_ASSERT_TRUE(file.isDamaged());
+  }
+
+  //-- a window larger than COMPRESSED_WINDOW_BITS_MAX is refused
+  writeStored("/w.hs", text, stream, COMPRESSED_WINDOW_BITS_MAX + 1, 4);
+  compressedHeader header;
+  CompressedFile   file;
+  TEST_ASSERT_FALSE(file.open(LittleFS, "/w"));
+  TEST_ASSERT_FALSE(compressedReadHeader(LittleFS, "/w.hs", header));
+  TEST_ASSERT_TRUE(compressedReadHeader(LittleFS, "/c.hs", header));
+  TEST_ASSERT_EQUAL_UINT32(text.size(), header.logicalSize);
+
+}   //   testDamageIsDetected()
+
+//-- every listing, also the cached one of the index, shows both sizes of a compressed file
+static void testListingShowsBothSizes()
+{
+  std::string text = sampleText();
+  std::vector<uint8_t> stream = encode(text, 8, 4);
+  writeStored("/a.txt.hs", text, stream, 8, 4);
+
+  FsIndex index;
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  Serial.clearOutput();
+  index.printListing();
+
+  char expected[64];
+  snprintf(expected, sizeof(expected), "FILE: /a.txt.hs\tSIZE: %u (logical %u)\n",
+           (unsigned)(stream.size() + sizeof(compressedHeader)), (unsigned)text.size());
+  TEST_ASSERT_TRUE(Serial.output().find(expected) != std::string::npos);
+
+}   //   testListingShowsBothSizes()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  LittleFS.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(testCompressedRoundTrip);
+  RUN_TEST(testOverlappingRun);
+  RUN_TEST(testPlainPassThrough);
+  RUN_TEST(testSeek);
+  RUN_TEST(testDamageIsDetected);
+  RUN_TEST(testListingShowsBothSizes);
+  return UNITY_END();
+
+}   //   main()
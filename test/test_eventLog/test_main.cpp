@@ -0,0 +1,247 @@
+//--- Host tests for the segmented event log (eventLog.cpp) on the RAM-backed LittleFS,
+//--- run with "pio test -e native"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+#include <fakeClock.h>
+
+#include <string>
+
+#include "eventLog.h"
+#include "fsIndex.h"
+#include "fsUsage.h"
+
+static const uint16_t pageRecords    = EVENT_LOG_PAGE_BYTES / EVENT_LOG_RECORD_BYTES;
+static const uint32_t segmentRecords = EVENT_LOG_SEGMENT_BYTES / EVENT_LOG_RECORD_BYTES;
+
+static void appendCounters(EventLog &log, uint32_t first, uint32_t count)
+{
+  for (uint32_t value = first; value < first + count; value++)
+  {
+    TEST_ASSERT_TRUE(log.append(EVENT_STATE, &value, sizeof(value)));
+  }
+
+}   //   appendCounters()
+
+static uint32_t payloadValue(const eventRecord &record)
+{
+  uint32_t value = 0;
+  memcpy(&value, record.payload, sizeof(value));
+  return value;
+
+}   //   payloadValue()
+
+static size_t fileSize(const char *path)
+{
+  File file = LittleFS.open(path, "r");
+  return file ? file.size() : 0;
+
+}   //   fileSize()
+
+void setUp()
+{
+  LittleFS.setTotalBytes(NATIVE_LITTLEFS_BYTES);
+  LittleFS.format();
+  fakeClockReset();
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- records stay in RAM until a page is full, then one write appends the page
+static void testRecordsAreWrittenPerPage()
+{
+  EventLog log;
+  TEST_ASSERT_TRUE(log.begin(LittleFS));
+
+  LittleFS.resetOpenCount();
+  appendCounters(log, 0, pageRecords - 1);
+  TEST_ASSERT_EQUAL_UINT32(0, LittleFS.openCount());
+  TEST_ASSERT_EQUAL_UINT16(pageRecords - 1, log.pendingCount());
+
+  appendCounters(log, pageRecords - 1, 1);
+  TEST_ASSERT_EQUAL_UINT32(1, LittleFS.openCount());
+  TEST_ASSERT_EQUAL_UINT16(0, log.pendingCount());
+  TEST_ASSERT_EQUAL_UINT32(EVENT_LOG_PAGE_BYTES, fileSize(EVENT_LOG_DIR "/00000000.log"));
+  TEST_ASSERT_EQUAL_UINT32(1, log.stats().pagesWritten);
+
+}   //   testRecordsAreWrittenPerPage()
+
+//-- the tail comes oldest first and includes the records still in RAM
+static void testTailSpansFlashAndRam()
+{
+  EventLog    log;
+  eventRecord tail[6];
+  TEST_ASSERT_TRUE(log.begin(LittleFS));
+
+  appendCounters(log, 0, pageRecords + 2);
+  TEST_ASSERT_EQUAL_UINT16(2, log.pendingCount());
+
+  TEST_ASSERT_EQUAL_UINT16(6, log.readTail(tail, 6));
+  for (uint16_t position = 0; position < 6; position++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(pageRecords - 4 + position, payloadValue(tail[position]));
+    TEST_ASSERT_EQUAL_UINT32(pageRecords - 4 + position, tail[position].sequence);
+    TEST_ASSERT_EQUAL_UINT8(EVENT_STATE, tail[position].type);
+  }
+
+  //-- asking for more than there is returns what there is
+  eventRecord all[2 * pageRecords];
+  TEST_ASSERT_EQUAL_UINT16(pageRecords + 2, log.readTail(all, 2 * pageRecords));
+  TEST_ASSERT_EQUAL_UINT32(0, payloadValue(all[0]));
+
+}   //   testTailSpansFlashAndRam()
+
+//-- full segments roll over, beyond EVENT_LOG_MAX_SEGMENTS the oldest is removed
+static void testSegmentsRotate()
+{
+  EventLog log;
+  TEST_ASSERT_TRUE(log.begin(LittleFS));
+
+  uint32_t total = (EVENT_LOG_MAX_SEGMENTS + 1) * segmentRecords + pageRecords;
+  appendCounters(log, 0, total);
+  TEST_ASSERT_TRUE(log.flush());
+
+  TEST_ASSERT_EQUAL_UINT32(EVENT_LOG_MAX_SEGMENTS, log.segmentCount());
+  TEST_ASSERT_FALSE(LittleFS.exists(EVENT_LOG_DIR "/00000000.log"));
+  TEST_ASSERT_FALSE(LittleFS.exists(EVENT_LOG_DIR "/00000001.log"));
+  TEST_ASSERT_TRUE(LittleFS.exists(EVENT_LOG_DIR "/00000002.log"));
+  TEST_ASSERT_EQUAL_UINT32(EVENT_LOG_SEGMENT_BYTES, fileSize(EVENT_LOG_DIR "/00000004.log"));
+  TEST_ASSERT_EQUAL_UINT32(EVENT_LOG_PAGE_BYTES, fileSize(EVENT_LOG_DIR "/00000005.log"));
+  TEST_ASSERT_EQUAL_UINT32(2, log.stats().segmentsRemoved);
+
+  //-- a tail across the segment boundary is still in order
+  eventRecord tail[pageRecords + 3];
+  TEST_ASSERT_EQUAL_UINT16(pageRecords + 3, log.readTail(tail, pageRecords + 3));
+  for (uint16_t position = 0; position < pageRecords + 3; position++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(total - pageRecords - 3 + position, payloadValue(tail[position]));
+  }
+
+}   //   testSegmentsRotate()
+
+//-- a new EventLog continues the newest segment and the sequence
+static void testRestartContinues()
+{
+  {
+    EventLog log;
+    TEST_ASSERT_TRUE(log.begin(LittleFS));
+    appendCounters(log, 0, segmentRecords + pageRecords);
+    TEST_ASSERT_TRUE(log.flush());
+  }
+
+  EventLog log;
+  TEST_ASSERT_TRUE(log.begin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT32(segmentRecords + pageRecords, log.nextSequence());
+  TEST_ASSERT_EQUAL_UINT32(2, log.segmentCount());
+
+  appendCounters(log, 1000, pageRecords);
+  TEST_ASSERT_EQUAL_UINT32(2 * EVENT_LOG_PAGE_BYTES, fileSize(EVENT_LOG_DIR "/00000001.log"));
+
+}   //   testRestartContinues()
+
+//-- a damaged record is skipped, a torn write starts a fresh segment
+static void testDamagedRecordsAreSkipped()
+{
+  {
+    EventLog log;
+    TEST_ASSERT_TRUE(log.begin(LittleFS));
+    appendCounters(log, 0, pageRecords);
+  }
+
+  std::string content;
+  {
+    File file = LittleFS.open(EVENT_LOG_DIR "/00000000.log", "r");
+    content.resize(file.size());
+    file.read((uint8_t *)&content[0], content.size());
+  }
+  //-- flip a payload byte of the last record and add half a record
+  content[content.size() - EVENT_LOG_RECORD_BYTES + 10] ^= 0x55;
+  content.append(EVENT_LOG_RECORD_BYTES / 2, '\xee');
+  {
+    File file = LittleFS.open(EVENT_LOG_DIR "/00000000.log", "w");
+    file.write((const uint8_t *)content.data(), content.size());
+  }
+
+  EventLog log;
+  TEST_ASSERT_TRUE(log.begin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT32(pageRecords - 1, log.nextSequence());
+  TEST_ASSERT_EQUAL_UINT32(2, log.segmentCount());
+
+  eventRecord tail[3];
+  TEST_ASSERT_EQUAL_UINT16(3, log.readTail(tail, 3));
+  TEST_ASSERT_EQUAL_UINT32(pageRecords - 4, payloadValue(tail[0]));
+  TEST_ASSERT_EQUAL_UINT32(pageRecords - 2, payloadValue(tail[2]));
+  TEST_ASSERT_TRUE(log.stats().crcErrors >= 1);
+
+}   //   testDamagedRecordsAreSkipped()
+
+//-- a part page is written once its first record waited EVENT_LOG_FLUSH_MS
+static void testPartPageIsFlushedWhenDue()
+{
+  EventLog log;
+  TEST_ASSERT_TRUE(log.begin(LittleFS));
+
+  appendCounters(log, 0, 2);
+  TEST_ASSERT_EQUAL_UINT32(EVENT_LOG_FLUSH_MS, log.flushIfDue());
+
+  fakeClockAdvanceMs(EVENT_LOG_FLUSH_MS - 10);
+  appendCounters(log, 2, 1);
+  TEST_ASSERT_EQUAL_UINT32(10, log.flushIfDue());
+  TEST_ASSERT_EQUAL_UINT16(3, log.pendingCount());
+
+  fakeClockAdvanceMs(10);
+  TEST_ASSERT_EQUAL_UINT32(0, log.flushIfDue());
+  TEST_ASSERT_EQUAL_UINT16(0, log.pendingCount());
+  TEST_ASSERT_EQUAL_UINT32(3 * EVENT_LOG_RECORD_BYTES, fileSize(EVENT_LOG_DIR "/00000000.log"));
+
+}   //   testPartPageIsFlushedWhenDue()
+
+//-- on a nearly full filesystem old segments go before the segment limit is reached
+static void testLowSpaceRemovesOldSegments()
+{
+  FsUsage usage;
+  FsIndex index;
+
+  //-- 16 KB of directory blocks, above the reserve there is room for three segments
+  LittleFS.setTotalBytes(96 * 1024);
+  TEST_ASSERT_TRUE(usage.begin());
+  index.setUsage(&usage);
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+
+  EventLog log;
+  log.setIndex(&index);
+  log.setUsage(&usage);
+  TEST_ASSERT_TRUE(log.begin(LittleFS));
+
+  appendCounters(log, 0, 4 * segmentRecords + pageRecords);
+  TEST_ASSERT_TRUE(log.flush());
+  TEST_ASSERT_EQUAL_UINT32(3, log.segmentCount());
+  TEST_ASSERT_EQUAL_UINT32(2, log.stats().segmentsRemoved);
+  TEST_ASSERT_TRUE(usage.freeBytes() >= (usage.totalBytes() / 100) * EVENT_LOG_MIN_FREE_PERCENT);
+  TEST_ASSERT_NOT_NULL(index.find(EVENT_LOG_DIR "/00000004.log"));
+  TEST_ASSERT_NULL(index.find(EVENT_LOG_DIR "/00000000.log"));
+
+}   //   testLowSpaceRemovesOldSegments()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  LittleFS.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(testRecordsAreWrittenPerPage);
+  RUN_TEST(testTailSpansFlashAndRam);
+  RUN_TEST(testSegmentsRotate);
+  RUN_TEST(testRestartContinues);
+  RUN_TEST(testDamagedRecordsAreSkipped);
+  RUN_TEST(testPartPageIsFlushedWhenDue);
+  RUN_TEST(testLowSpaceRemovesOldSegments);
+  return UNITY_END();
+
+}   //   main()
@@ -0,0 +1,72 @@
+//--- Host tests for the LittleFS mount policy and cache report (fsBackend.h)
+//--- on the RAM-backed LittleFS, run with "pio test -e native"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include "fsBackend.h"
+
+void setUp()
+{
+  LittleFS.setCorrupt(false);
+  LittleFS.format();
+  LittleFS.end();
+
+}   //   setUp()
+
+void tearDown()
+{
+  LittleFS.setCorrupt(false);
+
+}   //   tearDown()
+
+static void testCleanMount()
+{
+  TEST_ASSERT_TRUE(LittleFsBackend::mount());
+  TEST_ASSERT_TRUE(LittleFS.isMounted());
+
+}   //   testCleanMount()
+
+//-- without -DUSE_FS_AUTO_FORMAT a failed mount is not followed by a format
+static void testFailedMountKeepsData()
+{
+  File file = LittleFS.open("/keep.txt", "w", true);
+  file.write((const uint8_t *)"data", 4);
+  file.close();
+
+  LittleFS.setCorrupt(true);
+  TEST_ASSERT_FALSE(LittleFsBackend::mount());
+  TEST_ASSERT_FALSE(LittleFS.isMounted());
+
+  //-- the "partition" reads again once it is healthy, with its file
+  LittleFS.setCorrupt(false);
+  TEST_ASSERT_TRUE(LittleFsBackend::mount());
+  TEST_ASSERT_TRUE(LittleFS.exists("/keep.txt"));
+
+}   //   testFailedMountKeepsData()
+
+//-- the host core tells nothing about its caches, all sizes stay 0
+static void testCoreCachesUnknown()
+{
+  fsCacheInfo used;
+  used.readSize  = 1;
+  used.cacheSize = 1;
+  LittleFsBackend::caches(used);
+  TEST_ASSERT_EQUAL_UINT16(0, used.readSize);
+  TEST_ASSERT_EQUAL_UINT16(0, used.cacheSize);
+
+}   //   testCoreCachesUnknown()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testCleanMount);
+  RUN_TEST(testFailedMountKeepsData);
+  RUN_TEST(testCoreCachesUnknown);
+  return UNITY_END();
+
+}   //   main()
@@ -0,0 +1,339 @@
+//--- Host tests for the directory walker and index (fsWalker.cpp, fsIndex.cpp)
+//--- on the RAM-backed LittleFS, run with "pio test -e native"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <unity.h>
+
+#include <string>
+
+#include "fsIndex.h"
+#include "fsUsage.h"
+#include "fsWalker.h"
+
+static void putFile(const char *path, size_t size)
+{
+  std::string content(size, 'd');
+  File        file = LittleFS.open(path, "w", true);
+  file.write((const uint8_t *)content.data(), content.size());
+  file.close();
+
+}   //   putFile()
+
+static bool appendEntry(const fsWalkEntry &entry, void *context)
+{
+  char line[80];
+  snprintf(line, sizeof(line), "%u:%s:%u%s\n", entry.depth, entry.path, (unsigned)entry.size, entry.isDirectory ? "/" : "");
+  *(std::string *)context += line;
+  return true;
+
+}   //   appendEntry()
+
+//-- a fresh index from flash is the reference for the incrementally kept one
+static void assertIndexMatchesFlash(const FsIndex &index)
+{
+  FsIndex reference;
+  TEST_ASSERT_TRUE(reference.begin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT16(reference.count(), index.count());
+
+  for (uint16_t position = 0; position < reference.count(); position++)
+  {
+    const fsIndexEntry *expected = reference.entry(position);
+    const fsIndexEntry *actual   = index.find(expected->path);
+    TEST_ASSERT_NOT_NULL(actual);
+    TEST_ASSERT_EQUAL_UINT32(expected->size, actual->size);
+    TEST_ASSERT_EQUAL(expected->isDirectory, actual->isDirectory);
+  }
+
+}   //   assertIndexMatchesFlash()
+
+void setUp()
+{
+  LittleFS.format();
+  putFile("/a.txt", 3);
+  putFile("/data/b.bin", 5000);
+  putFile("/data/sub/c.txt", 1);
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+static void testGlobMatch()
+{
+  TEST_ASSERT_TRUE(fsGlobMatch("*.txt", "a.txt"));
+  TEST_ASSERT_FALSE(fsGlobMatch("*.txt", "a.bin"));
+  TEST_ASSERT_TRUE(fsGlobMatch("log_??.txt", "log_07.txt"));
+  TEST_ASSERT_FALSE(fsGlobMatch("log_??.txt", "log_7.txt"));
+  TEST_ASSERT_TRUE(fsGlobMatch("a*c", "abdc"));
+  TEST_ASSERT_FALSE(fsGlobMatch("a*c", "abd"));
+  TEST_ASSERT_TRUE(fsGlobMatch("*", ""));
+
+}   //   testGlobMatch()
+
+//-- depth first, a directory is reported before its children
+static void testWalkerReportsTree()
+{
+  std::string   listing;
+  fsWalkOptions options;
+
+  TEST_ASSERT_EQUAL_UINT32(5, walkFiles(LittleFS, "/", options, appendEntry, &listing));
+  TEST_ASSERT_EQUAL_STRING(
+    "0:/a.txt:3\n"
+    "0:/data:0/\n"
+    "1:/data/b.bin:5000\n"
+    "1:/data/sub:0/\n"
+    "2:/data/sub/c.txt:1\n",
+    listing.c_str()
+  );
+
+}   //   testWalkerReportsTree()
+
+static void testWalkerFilterAndDepth()
+{
+  std::string   listing;
+  fsWalkOptions options;
+  options.filter             = "*.txt";
+  options.includeDirectories = false;
+
+  walkFiles(LittleFS, "/", options, appendEntry, &listing);
+  TEST_ASSERT_EQUAL_STRING("0:/a.txt:3\n2:/data/sub/c.txt:1\n", listing.c_str());
+
+  listing.clear();
+  options.maxDepth = 0;
+  walkFiles(LittleFS, "/data/", options, appendEntry, &listing);
+  TEST_ASSERT_EQUAL_STRING("", listing.c_str());
+
+  FsWalker walker;
+  TEST_ASSERT_FALSE(walker.begin(LittleFS, "/a.txt"));
+  TEST_ASSERT_FALSE(walker.begin(LittleFS, "/missing"));
+
+}   //   testWalkerFilterAndDepth()
+
+static void testIndexIsBuiltFromFlash()
+{
+  FsIndex index;
+
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT16(5, index.count());
+  TEST_ASSERT_EQUAL_UINT32(5004, index.totalFileBytes());
+  TEST_ASSERT_EQUAL_UINT32(5000, index.find("/data/b.bin")->size);
+  TEST_ASSERT_TRUE(index.find("/data/sub")->isDirectory);
+  TEST_ASSERT_NULL(index.find("/data/none"));
+  TEST_ASSERT_FALSE(index.isOverflowed());
+
+}   //   testIndexIsBuiltFromFlash()
+
+//-- every write wrapper keeps both the index and the usage figures in step with flash
+static void testWriteWrappersKeepIndexInSync()
+{
+  FsIndex index;
+  FsUsage usage;
+  const uint8_t data[10] = {};
+
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  TEST_ASSERT_TRUE(usage.begin());
+  index.setUsage(&usage);
+  TEST_ASSERT_EQUAL_UINT32(LittleFS.usedBytes(), usage.usedBytes());
+
+  TEST_ASSERT_EQUAL_UINT32(10, index.writeFile("/new.txt", data, sizeof(data)));
+  TEST_ASSERT_EQUAL_UINT32(10, index.appendFile("/data/b.bin", data, sizeof(data)));
+  TEST_ASSERT_TRUE(index.makeDir("/logs"));
+  TEST_ASSERT_TRUE(index.renameFile("/new.txt", "/logs/new.txt"));
+  TEST_ASSERT_TRUE(index.removeFile("/a.txt"));
+  assertIndexMatchesFlash(index);
+  TEST_ASSERT_EQUAL_UINT32(LittleFS.usedBytes(), usage.usedBytes());
+
+  TEST_ASSERT_FALSE(index.removeDir("/logs"));
+  TEST_ASSERT_TRUE(index.removeFile("/logs/new.txt"));
+  TEST_ASSERT_TRUE(index.removeDir("/logs"));
+  TEST_ASSERT_FALSE(index.removeFile("/a.txt"));
+  assertIndexMatchesFlash(index);
+  TEST_ASSERT_EQUAL_UINT32(LittleFS.usedBytes(), usage.usedBytes());
+
+}   //   testWriteWrappersKeepIndexInSync()
+
+//-- a renamed directory takes its children along after the forced rescan
+static void testRenamedDirectoryIsRescanned()
+{
+  FsIndex index;
+
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  TEST_ASSERT_TRUE(index.renameFile("/data", "/archive"));
+  TEST_ASSERT_TRUE(index.isStale());
+  TEST_ASSERT_TRUE(index.rescanIfNeeded());
+  TEST_ASSERT_NOT_NULL(index.find("/archive/sub/c.txt"));
+  assertIndexMatchesFlash(index);
+
+}   //   testRenamedDirectoryIsRescanned()
+
+//-- the point of the index: lookups and listings never touch flash
+static void testCachedLookupsDoNotTouchFlash()
+{
+  FsIndex index;
+
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  LittleFS.resetOpenCount();
+  index.find("/data/sub/c.txt");
+  index.printListing();
+  TEST_ASSERT_FALSE(index.rescanIfNeeded());
+  TEST_ASSERT_EQUAL_UINT32(0, LittleFS.openCount());
+
+}   //   testCachedLookupsDoNotTouchFlash()
+
+static void testSmallIndexOverflows()
+{
+  FsIndex index;
+
+  TEST_ASSERT_TRUE(index.begin(LittleFS, "/", 2));
+  TEST_ASSERT_EQUAL_UINT16(2, index.count());
+  TEST_ASSERT_TRUE(index.isOverflowed());
+
+}   //   testSmallIndexOverflows()
+
+//-- a file the index does not hold is rewritten and removed with its real size
+static void testUsageOfUnindexedFile()
+{
+  FsIndex index;
+  FsUsage usage;
+  std::string content(5000, 'u');
+
+  //-- written behind the index' back, as for an overflowed index or a long path
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  putFile("/big.bin", content.size());
+  TEST_ASSERT_NULL(index.find("/big.bin"));
+  TEST_ASSERT_TRUE(usage.begin());
+  index.setUsage(&usage);
+
+  for (int round = 0; round < 3; round++)
+  {
+    index.writeFile("/big.bin", (const uint8_t *)content.data(), content.size());
+    TEST_ASSERT_EQUAL_UINT32(LittleFS.usedBytes(), usage.usedBytes());
+  }
+  TEST_ASSERT_TRUE(index.removeFile("/big.bin"));
+  TEST_ASSERT_EQUAL_UINT32(LittleFS.usedBytes(), usage.usedBytes());
+
+}   //   testUsageOfUnindexedFile()
+
+//-- a resumable walk with no budget takes one entry per step and ends with the same index
+//-- removals move entries around in the table and in the hash, lookups must follow
+static void testLookupsSurviveRemovals()
+{
+  FsIndex index;
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  TEST_ASSERT_TRUE(index.makeDir("/log"));
+
+  char path[32];
+  for (int number = 0; number < 40; number++)
+  {
+    snprintf(path, sizeof(path), "/log/%04d", number);
+    TEST_ASSERT_EQUAL_UINT32(1, index.writeFile(path, (const uint8_t *)"x", 1));
+  }
+  for (int number = 0; number < 40; number += 3)
+  {
+    snprintf(path, sizeof(path), "/log/%04d", number);
+    TEST_ASSERT_TRUE(index.removeFile(path));
+  }
+
+  for (int number = 0; number < 40; number++)
+  {
+    snprintf(path, sizeof(path), "/log/%04d", number);
+    const fsIndexEntry *found = index.find(path);
+    if (number % 3 == 0)
+    {
+      TEST_ASSERT_NULL(found);
+    }
+    else
+    {
+      TEST_ASSERT_NOT_NULL(found);
+      TEST_ASSERT_EQUAL_STRING(path, found->path);
+    }
+  }
+  assertIndexMatchesFlash(index);
+
+}   //   testLookupsSurviveRemovals()
+
+//-- appends keep the positions of a running listing, removals and rescans do not
+static void testLayoutVersionTracksMovedEntries()
+{
+  FsIndex index;
+  TEST_ASSERT_TRUE(index.begin(LittleFS));
+  uint32_t version = index.layoutVersion();
+
+  TEST_ASSERT_EQUAL_UINT32(1, index.writeFile("/new.txt", (const uint8_t *)"x", 1));
+  TEST_ASSERT_EQUAL_UINT32(version, index.layoutVersion());
+
+  TEST_ASSERT_TRUE(index.removeFile("/a.txt"));
+  TEST_ASSERT_TRUE(version != index.layoutVersion());
+
+  version = index.layoutVersion();
+  index.invalidate();
+  TEST_ASSERT_TRUE(index.rescanIfNeeded());
+  TEST_ASSERT_TRUE(version != index.layoutVersion());
+
+}   //   testLayoutVersionTracksMovedEntries()
+
+static void testResumableRescanMatchesFlash()
+{
+  FsIndex index;
+
+  TEST_ASSERT_TRUE(index.begin(LittleFS, "/", FS_INDEX_MAX_ENTRIES, true));
+  TEST_ASSERT_TRUE(index.isScanning());
+  TEST_ASSERT_EQUAL_UINT16(0, index.count());
+
+  uint16_t steps = 0;
+  while (!index.continueRescan(0))
+  {
+    steps++;
+    TEST_ASSERT_EQUAL_UINT16(steps, index.count());
+  }
+  TEST_ASSERT_FALSE(index.isScanning());
+  TEST_ASSERT_FALSE(index.isStale());
+  TEST_ASSERT_EQUAL_UINT16(steps, index.count());
+  assertIndexMatchesFlash(index);
+
+}   //   testResumableRescanMatchesFlash()
+
+//-- an invalidation while a walk is running asks for another walk afterwards
+static void testInvalidateDuringRescanStaysStale()
+{
+  FsIndex index;
+
+  TEST_ASSERT_TRUE(index.begin(LittleFS, "/", FS_INDEX_MAX_ENTRIES, true));
+  TEST_ASSERT_FALSE(index.continueRescan(0));
+  index.invalidate();
+  while (!index.continueRescan(0))
+  {
+  }
+  TEST_ASSERT_TRUE(index.isStale());
+  TEST_ASSERT_TRUE(index.rescanIfNeeded());
+  TEST_ASSERT_FALSE(index.isStale());
+  assertIndexMatchesFlash(index);
+
+}   //   testInvalidateDuringRescanStaysStale()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  LittleFS.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(testGlobMatch);
+  RUN_TEST(testWalkerReportsTree);
+  RUN_TEST(testWalkerFilterAndDepth);
+  RUN_TEST(testIndexIsBuiltFromFlash);
+  RUN_TEST(testWriteWrappersKeepIndexInSync);
+  RUN_TEST(testRenamedDirectoryIsRescanned);
+  RUN_TEST(testCachedLookupsDoNotTouchFlash);
+  RUN_TEST(testSmallIndexOverflows);
+  RUN_TEST(testUsageOfUnindexedFile);
+  RUN_TEST(testLookupsSurviveRemovals);
+  RUN_TEST(testLayoutVersionTracksMovedEntries);
+  RUN_TEST(testResumableRescanMatchesFlash);
+  RUN_TEST(testInvalidateDuringRescanStaysStale);
+  return UNITY_END();
+
+}   //   main()
@@ -0,0 +1,135 @@
+//--- Host tests for the buffered logger (logger.cpp), run with "pio test -e native"
+//--- the logger keeps its ring in static storage, so the tests run in this order
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+
+#include "logger.h"
+
+void setUp()
+{
+  Serial.setWriteRoom(128);
+  logFlushAll();
+  Serial.clearOutput();
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- before logBegin() there is no ring yet: messages go out synchronously
+static void testWritesBeforeBeginGoStraightOut()
+{
+  LOG_INFO("hello %d\n", 7);
+  TEST_ASSERT_EQUAL_STRING("hello 7\n", Serial.output().c_str());
+  TEST_ASSERT_EQUAL_UINT32(0, logPending());
+
+}   //   testWritesBeforeBeginGoStraightOut()
+
+static void testMessagesAreQueuedUntilFlush()
+{
+  logBegin();
+
+  LOG_WARN("queued\n");
+  TEST_ASSERT_EQUAL_STRING("", Serial.output().c_str());
+  TEST_ASSERT_EQUAL_UINT32(7, logPending());
+
+  TEST_ASSERT_EQUAL_UINT32(0, logFlush());
+  TEST_ASSERT_EQUAL_STRING("queued\n", Serial.output().c_str());
+
+}   //   testMessagesAreQueuedUntilFlush()
+
+//-- logFlush() never writes more than the UART can take without blocking
+static void testFlushRespectsUartRoom()
+{
+  Serial.setWriteRoom(4);
+  logWriteRaw("abcdefghij", 10);
+
+  TEST_ASSERT_EQUAL_UINT32(6, logFlush());
+  TEST_ASSERT_EQUAL_STRING("abcd", Serial.output().c_str());
+  TEST_ASSERT_EQUAL_UINT32(2, logFlush());
+
+  Serial.setWriteRoom(0);
+  TEST_ASSERT_EQUAL_UINT32(2, logFlush());
+  TEST_ASSERT_EQUAL_STRING("abcdefgh", Serial.output().c_str());
+
+  logFlushAll();
+  TEST_ASSERT_EQUAL_STRING("abcdefghij", Serial.output().c_str());
+
+}   //   testFlushRespectsUartRoom()
+
+//-- messages that straddle the end of the ring come out in one piece
+static void testRingWrapsAround()
+{
+  std::string expected;
+  char        line[16];
+
+  for (int number = 0; number < 3 * LOG_BUFFER_SIZE / 9; number++)
+  {
+    snprintf(line, sizeof(line), "line %03d\n", number % 1000);
+    expected += line;
+    LOG_INFO("%s", line);
+    if (number % 16 == 15)
+    {
+      logFlush();
+    }
+  }
+  logFlushAll();
+  TEST_ASSERT_EQUAL_STRING(expected.c_str(), Serial.output().c_str());
+
+}   //   testRingWrapsAround()
+
+//-- without a flush task a full ring is drained synchronously, nothing is dropped
+static void testFullRingDrainsInsteadOfDropping()
+{
+  std::string payload(LOG_BUFFER_SIZE + 100, 'x');
+  uint32_t    droppedBefore = logDroppedCount();
+
+  Serial.setWriteRoom(0);
+  logWriteRaw(payload.c_str(), LOG_BUFFER_SIZE / 2);
+  logWriteRaw(payload.c_str(), LOG_BUFFER_SIZE / 2 + 100);
+
+  TEST_ASSERT_TRUE(logPending() <= LOG_BUFFER_SIZE);
+  TEST_ASSERT_EQUAL_UINT32(droppedBefore, logDroppedCount());
+
+  logFlushAll();
+  TEST_ASSERT_EQUAL_STRING(payload.c_str(), Serial.output().c_str());
+
+}   //   testFullRingDrainsInsteadOfDropping()
+
+static void testLongLinesAreTruncated()
+{
+  std::string longText(2 * LOG_LINE_MAX, 'y');
+
+  LOG_ERROR("%s", longText.c_str());
+  TEST_ASSERT_EQUAL_UINT32(LOG_LINE_MAX - 1, logPending());
+
+}   //   testLongLinesAreTruncated()
+
+//-- above LOG_LEVEL the macros compile to nothing
+static void testLevelsAboveFilterCompileOut()
+{
+  LOG_DEBUG("not queued %d\n", 1);
+  TEST_ASSERT_EQUAL_UINT32(0, logPending());
+
+}   //   testLevelsAboveFilterCompileOut()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testWritesBeforeBeginGoStraightOut);
+  RUN_TEST(testMessagesAreQueuedUntilFlush);
+  RUN_TEST(testFlushRespectsUartRoom);
+  RUN_TEST(testRingWrapsAround);
+  RUN_TEST(testFullRingDrainsInsteadOfDropping);
+  RUN_TEST(testLongLinesAreTruncated);
+  RUN_TEST(testLevelsAboveFilterCompileOut);
+  return UNITY_END();
+
+}   //   main()
@@ -0,0 +1,139 @@
+//--- Host tests for the fixed-block pool and the small-object allocator (memoryPool.cpp),
+//--- run with "pio test -e native"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "memoryPool.h"
+
+void setUp()
+{
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- every block is handed out once, then the pool is empty
+static void testPoolExhaustion()
+{
+  BlockPool pool;
+  TEST_ASSERT_TRUE(pool.begin(24, 4));
+  TEST_ASSERT_EQUAL_UINT16(4, pool.capacity());
+
+  void *blocks[4];
+  for (int index = 0; index < 4; index++)
+  {
+    blocks[index] = pool.allocate();
+    TEST_ASSERT_NOT_NULL(blocks[index]);
+    for (int other = 0; other < index; other++)
+    {
+      TEST_ASSERT_TRUE(blocks[index] != blocks[other]);
+    }
+  }
+  TEST_ASSERT_NULL(pool.allocate());
+  TEST_ASSERT_EQUAL_UINT16(4, pool.used());
+  TEST_ASSERT_EQUAL_UINT16(4, pool.peak());
+
+}   //   testPoolExhaustion()
+
+//-- a released block is handed out again, the peak stays
+static void testPoolRelease()
+{
+  BlockPool pool;
+  TEST_ASSERT_TRUE(pool.begin(24, 2));
+
+  void *first  = pool.allocate();
+  void *second = pool.allocate();
+  TEST_ASSERT_NULL(pool.allocate());
+
+  pool.release(first);
+  TEST_ASSERT_EQUAL_UINT16(1, pool.used());
+  TEST_ASSERT_TRUE(pool.allocate() == first);
+
+  pool.release(second);
+  pool.release(first);
+  TEST_ASSERT_EQUAL_UINT16(0, pool.used());
+  TEST_ASSERT_EQUAL_UINT16(2, pool.peak());
+
+  //-- a foreign pointer is ignored
+  int outside = 0;
+  pool.release(&outside);
+  TEST_ASSERT_EQUAL_UINT16(0, pool.used());
+
+}   //   testPoolRelease()
+
+//-- owns() takes block starts inside the storage only
+static void testPoolOwns()
+{
+  BlockPool pool;
+  TEST_ASSERT_FALSE(pool.owns(nullptr));
+  TEST_ASSERT_TRUE(pool.begin(10, 3));
+
+  //-- rounded up to hold the free-list link aligned
+  TEST_ASSERT_TRUE(pool.blockBytes() >= 10);
+  TEST_ASSERT_EQUAL_UINT32(0, pool.blockBytes() % sizeof(void *));
+
+  uint8_t *block = (uint8_t *)pool.allocate();
+  TEST_ASSERT_TRUE(pool.owns(block));
+  TEST_ASSERT_FALSE(pool.owns(block + 1));
+
+  int outside = 0;
+  TEST_ASSERT_FALSE(pool.owns(&outside));
+
+  BlockPool other;
+  TEST_ASSERT_TRUE(other.begin(10, 3));
+  TEST_ASSERT_FALSE(other.owns(block));
+  pool.release(block);
+
+}   //   testPoolOwns()
+
+//-- memSmallAlloc(): pool blocks while they last, the heap for the rest
+static void testSmallAllocFallsBack()
+{
+  void *blocks[MEM_SMALL_BLOCK_COUNT];
+  for (int index = 0; index < MEM_SMALL_BLOCK_COUNT; index++)
+  {
+    blocks[index] = memSmallAlloc(MEM_SMALL_BLOCK_SIZE);
+    TEST_ASSERT_NOT_NULL(blocks[index]);
+  }
+
+  memoryStats stats;
+  memGetStats(stats);
+  TEST_ASSERT_EQUAL_UINT16(MEM_SMALL_BLOCK_COUNT, stats.poolUsed);
+  TEST_ASSERT_EQUAL_UINT32(0, stats.poolMisses);
+
+  //-- pool empty, and a block that does not fit: both from the heap
+  void *extra = memSmallAlloc(8);
+  void *large = memSmallAlloc(MEM_SMALL_BLOCK_SIZE + 1);
+  TEST_ASSERT_NOT_NULL(extra);
+  TEST_ASSERT_NOT_NULL(large);
+  memGetStats(stats);
+  TEST_ASSERT_EQUAL_UINT32(2, stats.poolMisses);
+
+  memSmallFree(extra);
+  memSmallFree(large);
+  for (int index = 0; index < MEM_SMALL_BLOCK_COUNT; index++)
+  {
+    memSmallFree(blocks[index]);
+  }
+  memGetStats(stats);
+  TEST_ASSERT_EQUAL_UINT16(0, stats.poolUsed);
+
+}   //   testSmallAllocFallsBack()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  memBegin();
+
+  UNITY_BEGIN();
+  RUN_TEST(testPoolExhaustion);
+  RUN_TEST(testPoolRelease);
+  RUN_TEST(testPoolOwns);
+  RUN_TEST(testSmallAllocFallsBack);
+  return UNITY_END();
+
+}   //   main()
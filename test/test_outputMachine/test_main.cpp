@@ -0,0 +1,200 @@
+//--- Host tests for the output state machine and its event queue (outputMachine.cpp),
+//--- run with "pio test -e native"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "outputMachine.h"
+#include "spscQueue.h"
+
+static uint32_t writes     = 0;
+static bool     lastLevel  = false;
+static uint32_t wakeups    = 0;
+static uint32_t isrWakeups = 0;
+
+static void recordWrite(bool isOn, void *context)
+{
+  (void)context;
+  writes++;
+  lastLevel = isOn;
+
+}   //   recordWrite()
+
+static void recordWakeup(bool fromIsr)
+{
+  wakeups++;
+  if (fromIsr)
+  {
+    isrWakeups++;
+  }
+
+}   //   recordWakeup()
+
+void setUp()
+{
+  fakeClockReset();
+  writes     = 0;
+  lastLevel  = false;
+  wakeups    = 0;
+  isrWakeups = 0;
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- ticks blink, a command holds, "blink" hands the output back to the ticks
+static void testTransitions()
+{
+  OutputMachine machine;
+  machine.begin(recordWrite, nullptr);
+
+  machine.dispatch(OUTPUT_EVENT_TICK);
+  TEST_ASSERT_EQUAL(OUTPUT_BLINK_ON, machine.state());
+  TEST_ASSERT_TRUE(lastLevel);
+
+  machine.dispatch(OUTPUT_EVENT_OFF);
+  TEST_ASSERT_EQUAL(OUTPUT_HOLD_OFF, machine.state());
+  TEST_ASSERT_FALSE(lastLevel);
+  machine.dispatch(OUTPUT_EVENT_TICK);
+  TEST_ASSERT_EQUAL(OUTPUT_HOLD_OFF, machine.state());
+
+  machine.dispatch(OUTPUT_EVENT_TOGGLE);
+  TEST_ASSERT_EQUAL(OUTPUT_HOLD_ON, machine.state());
+  machine.dispatch(OUTPUT_EVENT_BLINK);
+  TEST_ASSERT_EQUAL(OUTPUT_BLINK_ON, machine.state());
+  TEST_ASSERT_TRUE(machine.isBlinking());
+  machine.dispatch(OUTPUT_EVENT_TICK);
+  TEST_ASSERT_FALSE(machine.isOn());
+
+  //-- tick on, off, toggle on, tick off; BLINK and the held tick change no level
+  TEST_ASSERT_EQUAL_UINT32(4, writes);
+  TEST_ASSERT_EQUAL_UINT32(6, machine.stats().processed);
+  TEST_ASSERT_EQUAL_UINT32(5, machine.stats().transitions);
+
+}   //   testTransitions()
+
+//-- posted events wait for process(), the sources take turns
+static void testQueuedEvents()
+{
+  OutputMachine machine;
+  machine.begin(recordWrite, nullptr, OUTPUT_BLINK_ON);
+  machine.setWakeup(recordWakeup);
+
+  TEST_ASSERT_TRUE(machine.post(OUTPUT_SOURCE_TASK, OUTPUT_EVENT_OFF));
+  TEST_ASSERT_TRUE(machine.post(OUTPUT_SOURCE_ISR, OUTPUT_EVENT_TOGGLE));
+  TEST_ASSERT_TRUE(machine.post(OUTPUT_SOURCE_TASK, OUTPUT_EVENT_BLINK));
+  TEST_ASSERT_EQUAL_UINT32(3, wakeups);
+  TEST_ASSERT_EQUAL_UINT32(1, isrWakeups);
+  TEST_ASSERT_TRUE(machine.hasPending());
+  TEST_ASSERT_EQUAL_UINT32(0, writes);
+
+  //-- off (task), toggle (isr) -> hold on, blink (task) -> blink on
+  TEST_ASSERT_EQUAL_UINT16(3, machine.process());
+  TEST_ASSERT_FALSE(machine.hasPending());
+  TEST_ASSERT_EQUAL(OUTPUT_BLINK_ON, machine.state());
+  TEST_ASSERT_EQUAL_UINT32(2, writes);
+  TEST_ASSERT_EQUAL_UINT16(0, machine.process());
+
+  TEST_ASSERT_FALSE(machine.post(OUTPUT_SOURCE_COUNT, OUTPUT_EVENT_ON));
+  TEST_ASSERT_FALSE(machine.post(OUTPUT_SOURCE_TASK, OUTPUT_EVENT_COUNT));
+
+}   //   testQueuedEvents()
+
+//-- a full queue drops and counts, one process() call stays bounded
+static void testQueueFullAndBatch()
+{
+  OutputMachine machine;
+  machine.begin(recordWrite, nullptr);
+
+  for (uint16_t event = 0; event < OUTPUT_QUEUE_LENGTH; event++)
+  {
+    TEST_ASSERT_TRUE(machine.post(OUTPUT_SOURCE_ISR, OUTPUT_EVENT_TOGGLE));
+  }
+  TEST_ASSERT_FALSE(machine.post(OUTPUT_SOURCE_ISR, OUTPUT_EVENT_TOGGLE));
+  TEST_ASSERT_EQUAL_UINT32(1, machine.stats().dropped);
+  //-- the other source has its own queue
+  TEST_ASSERT_TRUE(machine.post(OUTPUT_SOURCE_TASK, OUTPUT_EVENT_ON));
+
+  uint32_t total = 0;
+  uint16_t handled;
+  while ((handled = machine.process()) > 0)
+  {
+    TEST_ASSERT_TRUE(handled <= OUTPUT_MACHINE_BATCH);
+    total += handled;
+  }
+  TEST_ASSERT_EQUAL_UINT32(OUTPUT_QUEUE_LENGTH + 1, total);
+
+}   //   testQueueFullAndBatch()
+
+//-- the latency runs from post() to the transition
+static void testLatency()
+{
+  OutputMachine machine;
+  machine.begin(recordWrite, nullptr);
+
+  machine.post(OUTPUT_SOURCE_TASK, OUTPUT_EVENT_ON);
+  fakeClockAdvanceUs(250);
+  machine.process();
+  TEST_ASSERT_EQUAL_UINT32(250, machine.stats().lastLatencyUs);
+
+  machine.post(OUTPUT_SOURCE_TASK, OUTPUT_EVENT_OFF);
+  fakeClockAdvanceUs(40);
+  machine.process();
+  TEST_ASSERT_EQUAL_UINT32(40, machine.stats().lastLatencyUs);
+  TEST_ASSERT_EQUAL_UINT32(250, machine.stats().maxLatencyUs);
+
+}   //   testLatency()
+
+//-- the indices run on past the capacity, the order of the items is kept
+static void testQueueWrap()
+{
+  SpscQueue<uint32_t, 4> queue;
+  uint32_t               value = 0;
+
+  for (uint32_t round = 0; round < 10; round++)
+  {
+    TEST_ASSERT_TRUE(queue.push(round));
+    TEST_ASSERT_TRUE(queue.push(round + 100));
+    TEST_ASSERT_EQUAL_UINT32(2, queue.count());
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(round, value);
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(round + 100, value);
+  }
+  TEST_ASSERT_FALSE(queue.pop(value));
+  TEST_ASSERT_TRUE(queue.isEmpty());
+  TEST_ASSERT_EQUAL_UINT32(0, queue.dropped());
+
+}   //   testQueueWrap()
+
+static void testParseEvent()
+{
+  outputEvent event = OUTPUT_EVENT_TICK;
+  TEST_ASSERT_TRUE(OutputMachine::parseEvent("toggle", event));
+  TEST_ASSERT_EQUAL(OUTPUT_EVENT_TOGGLE, event);
+  TEST_ASSERT_TRUE(OutputMachine::parseEvent("blink", event));
+  TEST_ASSERT_EQUAL(OUTPUT_EVENT_BLINK, event);
+  //-- the tick is not a command
+  TEST_ASSERT_FALSE(OutputMachine::parseEvent("tick", event));
+  TEST_ASSERT_FALSE(OutputMachine::parseEvent("", event));
+  TEST_ASSERT_EQUAL_STRING("hold on", OutputMachine::stateName(OUTPUT_HOLD_ON));
+
+}   //   testParseEvent()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testTransitions);
+  RUN_TEST(testQueuedEvents);
+  RUN_TEST(testQueueFullAndBatch);
+  RUN_TEST(testLatency);
+  RUN_TEST(testQueueWrap);
+  RUN_TEST(testParseEvent);
+  return UNITY_END();
+
+}   //   main()
@@ -0,0 +1,161 @@
+//--- Host tests for the effects engine (pixelEffects.cpp), run with "pio test -e native"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "pixelEffects.h"
+
+static const uint16_t PIXELS = 10;
+
+static uint8_t        frameBuffer[3 * PIXELS];
+static const uint8_t *shownFrame  = nullptr;
+static uint16_t       shownPixels = 0;
+static uint32_t       showCount   = 0;
+
+static void captureFrame(const uint8_t *rgbFrame, uint16_t pixelCount)
+{
+  shownFrame  = rgbFrame;
+  shownPixels = pixelCount;
+  showCount++;
+
+}   //   captureFrame()
+
+static uint32_t pixelColor(uint16_t pixel)
+{
+  return ((uint32_t)frameBuffer[pixel * 3] << 16) | ((uint32_t)frameBuffer[pixel * 3 + 1] << 8) | frameBuffer[pixel * 3 + 2];
+
+}   //   pixelColor()
+
+void setUp()
+{
+  fakeClockReset();
+  memset(frameBuffer, 0xAA, sizeof(frameBuffer));
+  shownFrame  = nullptr;
+  shownPixels = 0;
+  showCount   = 0;
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+static void testFixedPointHelpers()
+{
+  TEST_ASSERT_EQUAL_UINT8(255, scale8(255, 255));
+  TEST_ASSERT_EQUAL_UINT8(0, scale8(200, 0));
+  TEST_ASSERT_EQUAL_UINT8(64, scale8(128, 127));
+
+  TEST_ASSERT_EQUAL_UINT8(128, sin8(0));
+  TEST_ASSERT_EQUAL_UINT8(255, sin8(64));
+  TEST_ASSERT_EQUAL_UINT8(128, sin8(128));
+  TEST_ASSERT_EQUAL_UINT8(1, sin8(192));
+
+  TEST_ASSERT_EQUAL_HEX32(0x123456, blendColor(0x123456, 0xFFFFFF, 0));
+  TEST_ASSERT_EQUAL_HEX32(0x7F7F7F, blendColor(0x000000, 0xFFFFFF, 128));
+  TEST_ASSERT_EQUAL_HEX32(0x0100FE, blendColor(0xFF0000, 0x0000FF, 255));
+  TEST_ASSERT_EQUAL_HEX32(0x800000, scaleColor(0xFF0000, 128));
+
+}   //   testFixedPointHelpers()
+
+static void testSolidFillsFrameAndShowsIt()
+{
+  PixelEffects effects(frameBuffer, PIXELS);
+  effectConfig config;
+  config.type   = EFFECT_SOLID;
+  config.colorA = 0x123456;
+
+  effects.setOutput(captureFrame);
+  effects.setEffect(config);
+  effects.renderFrame(millis());
+
+  TEST_ASSERT_EQUAL_UINT32(1, showCount);
+  TEST_ASSERT_TRUE(shownFrame == frameBuffer);
+  TEST_ASSERT_EQUAL_UINT16(PIXELS, shownPixels);
+  for (uint16_t pixel = 0; pixel < PIXELS; pixel++)
+  {
+    TEST_ASSERT_EQUAL_HEX32(0x123456, pixelColor(pixel));
+  }
+
+}   //   testSolidFillsFrameAndShowsIt()
+
+//-- the head moves one pixel per period / pixelCount and drags a fading tail
+static void testChaseHeadAndTail()
+{
+  PixelEffects effects(frameBuffer, PIXELS);
+  effectConfig config;
+  config.type       = EFFECT_CHASE;
+  config.colorA     = 0xFF0000;
+  config.colorB     = 0x000010;
+  config.periodMs   = 1000;
+  config.tailLength = 3;
+
+  effects.setEffect(config);
+  effects.renderFrame(0);
+  TEST_ASSERT_EQUAL_HEX32(0xFF0000, pixelColor(0));
+  TEST_ASSERT_EQUAL_HEX32(0xAA0000, pixelColor(9));
+  TEST_ASSERT_EQUAL_HEX32(0x550000, pixelColor(8));
+  TEST_ASSERT_EQUAL_HEX32(0x000010, pixelColor(7));
+  TEST_ASSERT_EQUAL_HEX32(0x000010, pixelColor(1));
+
+  effects.renderFrame(500);
+  TEST_ASSERT_EQUAL_HEX32(0xFF0000, pixelColor(5));
+  TEST_ASSERT_EQUAL_HEX32(0xAA0000, pixelColor(4));
+
+}   //   testChaseHeadAndTail()
+
+//-- fade is a triangle A -> B -> A over one period
+static void testFadeTurnsAroundHalfway()
+{
+  PixelEffects effects(frameBuffer, PIXELS);
+  effectConfig config;
+  config.type     = EFFECT_FADE;
+  config.colorA   = 0x000000;
+  config.colorB   = 0x0000FF;
+  config.periodMs = 1000;
+
+  effects.setEffect(config);
+  effects.renderFrame(0);
+  TEST_ASSERT_EQUAL_HEX32(0x000000, pixelColor(3));
+  effects.renderFrame(500);
+  TEST_ASSERT_EQUAL_HEX32(0x0000FE, pixelColor(3));
+  effects.renderFrame(1000);
+  TEST_ASSERT_EQUAL_HEX32(0x000000, pixelColor(3));
+
+}   //   testFadeTurnsAroundHalfway()
+
+//-- a late frame counts the frames that were skipped, on-time frames count none
+static void testLateFramesAreCountedAsDropped()
+{
+  PixelEffects effects(frameBuffer, PIXELS);
+  effects.setTargetFps(50);
+  TEST_ASSERT_EQUAL_UINT32(20, effects.framePeriodMs());
+
+  effects.renderFrame(0);
+  effects.renderFrame(20);
+  effects.renderFrame(39);
+  TEST_ASSERT_EQUAL_UINT32(0, effects.stats().framesDropped);
+
+  effects.renderFrame(139);
+  TEST_ASSERT_EQUAL_UINT32(4, effects.stats().framesDropped);
+  TEST_ASSERT_EQUAL_UINT32(4, effects.stats().framesRendered);
+
+  effects.resetStats();
+  TEST_ASSERT_EQUAL_UINT32(0, effects.stats().framesRendered);
+
+}   //   testLateFramesAreCountedAsDropped()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testFixedPointHelpers);
+  RUN_TEST(testSolidFillsFrameAndShowsIt);
+  RUN_TEST(testChaseHeadAndTail);
+  RUN_TEST(testFadeTurnsAroundHalfway);
+  RUN_TEST(testLateFramesAreCountedAsDropped);
+  return UNITY_END();
+
+}   //   main()
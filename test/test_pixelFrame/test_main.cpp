@@ -0,0 +1,161 @@
+//--- Host tests for the dirty-region framebuffer and the batched refresh (pixelFrame.cpp),
+//--- run with "pio test -e native"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "pixelFrame.h"
+
+//-- records what PixelBatch hands to a strip
+struct fakeStrip
+{
+  uint32_t pixels[16];
+  uint32_t setCount;
+  uint32_t showCount;
+
+  void setPixelColor(uint16_t pixel, uint8_t red, uint8_t green, uint8_t blue)
+  {
+    pixels[pixel] = ((uint32_t)red << 16) | ((uint32_t)green << 8) | blue;
+    setCount++;
+  }
+  void show() { showCount++; }
+};
+
+//-- a strip that can send only a prefix of the chain, like RmtNeoPixel
+struct prefixStrip : fakeStrip
+{
+  uint16_t lastSendPixels;
+
+  void show(uint16_t sendPixels)
+  {
+    lastSendPixels = sendPixels;
+    showCount++;
+  }
+};
+
+inline void pixelStripShow(prefixStrip &strip, uint16_t pixels)
+{
+  strip.show(pixels);
+
+}   //   pixelStripShow()
+
+void setUp()
+{
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+static void testOnlyChangedPixelsAreDirty()
+{
+  PixelFrame frame(16);
+  TEST_ASSERT_TRUE(frame.begin());
+  frame.markClean();
+  TEST_ASSERT_FALSE(frame.isDirty());
+
+  //-- writing the colour a pixel already has changes nothing
+  frame.setPixel(3, 0);
+  TEST_ASSERT_FALSE(frame.isDirty());
+
+  frame.setPixel(7, 0x102030);
+  frame.setPixel(4, 0x0000FF);
+  TEST_ASSERT_TRUE(frame.isDirty());
+  TEST_ASSERT_EQUAL_UINT16(4, frame.firstDirty());
+  TEST_ASSERT_EQUAL_UINT16(7, frame.lastDirty());
+  TEST_ASSERT_EQUAL_HEX32(0x102030, frame.pixel(7));
+
+  //-- out of range is ignored
+  frame.setPixel(16, 0xFFFFFF);
+  TEST_ASSERT_EQUAL_UINT16(7, frame.lastDirty());
+
+}   //   testOnlyChangedPixelsAreDirty()
+
+static void testCopyFromMarksChangedSpan()
+{
+  PixelFrame frame(4);
+  uint8_t    rgb[12] = {};
+
+  TEST_ASSERT_TRUE(frame.begin());
+  frame.markClean();
+
+  frame.copyFrom(rgb, 4);
+  TEST_ASSERT_FALSE(frame.isDirty());
+
+  rgb[1 * 3 + 2] = 0x40;
+  rgb[2 * 3 + 0] = 0x80;
+  frame.copyFrom(rgb, 4);
+  TEST_ASSERT_EQUAL_UINT16(1, frame.firstDirty());
+  TEST_ASSERT_EQUAL_UINT16(2, frame.lastDirty());
+  TEST_ASSERT_EQUAL_HEX32(0x000040, frame.pixel(1));
+  TEST_ASSERT_EQUAL_HEX32(0x800000, frame.pixel(2));
+
+}   //   testCopyFromMarksChangedSpan()
+
+//-- a clean batch never calls show(); only dirty strips are pushed and shown
+static void testRefreshSkipsCleanStrips()
+{
+  PixelFrame  frameA(16);
+  PixelFrame  frameB(16);
+  fakeStrip   stripA = {};
+  prefixStrip stripB = {};
+  PixelBatch  batch;
+
+  frameA.begin();
+  frameB.begin();
+  TEST_ASSERT_TRUE(batch.attach(frameA, stripA));
+  TEST_ASSERT_TRUE(batch.attach(frameB, stripB));
+
+  //-- a new frame is all dirty: everything goes out once
+  TEST_ASSERT_EQUAL_UINT8(2, batch.refresh());
+  TEST_ASSERT_EQUAL_UINT32(16, stripA.setCount);
+  TEST_ASSERT_EQUAL_UINT16(16, stripB.lastSendPixels);
+
+  TEST_ASSERT_EQUAL_UINT8(0, batch.refresh());
+  TEST_ASSERT_EQUAL_UINT32(1, stripA.showCount);
+  TEST_ASSERT_EQUAL_UINT32(1, batch.stats().skippedRefreshes);
+
+  //-- pixel 0 of strip B: one pixel set, a one pixel prefix sent, strip A untouched
+  frameB.setPixel(0, 0x0000FF);
+  TEST_ASSERT_EQUAL_UINT8(1, batch.refresh());
+  TEST_ASSERT_EQUAL_UINT32(17, stripB.setCount);
+  TEST_ASSERT_EQUAL_UINT16(1, stripB.lastSendPixels);
+  TEST_ASSERT_EQUAL_HEX32(0x0000FF, stripB.pixels[0]);
+  TEST_ASSERT_EQUAL_UINT32(1, stripA.showCount);
+  TEST_ASSERT_EQUAL_UINT32(2, stripB.showCount);
+
+  //-- a brightness change needs every pixel again
+  frameA.markAllDirty();
+  batch.refresh();
+  TEST_ASSERT_EQUAL_UINT32(32, stripA.setCount);
+  TEST_ASSERT_EQUAL_UINT32(16 + 16 + 1 + 16, batch.stats().pixelsPushed);
+
+}   //   testRefreshSkipsCleanStrips()
+
+static void testBatchIsBounded()
+{
+  PixelFrame frame(1);
+  fakeStrip  strip = {};
+  PixelBatch batch;
+
+  for (int slot = 0; slot < PIXEL_BATCH_MAX_STRIPS; slot++)
+  {
+    TEST_ASSERT_TRUE(batch.attach(frame, strip));
+  }
+  TEST_ASSERT_FALSE(batch.attach(frame, strip));
+
+}   //   testBatchIsBounded()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testOnlyChangedPixelsAreDirty);
+  RUN_TEST(testCopyFromMarksChangedSpan);
+  RUN_TEST(testRefreshSkipsCleanStrips);
+  RUN_TEST(testBatchIsBounded);
+  return UNITY_END();
+
+}   //   main()
@@ -0,0 +1,314 @@
+//--- Host tests for the cooperative scheduler (taskScheduler.cpp), run with "pio test -e native"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include "taskScheduler.h"
+
+static uint32_t runsA = 0;
+static uint32_t runsB = 0;
+
+static uint32_t taskBRunUs = 0;
+
+static void taskA() { runsA++; }
+//-- takes taskBRunUs of (fake) time
+static void taskB() { runsB++; fakeClockAdvanceUs(taskBRunUs); }
+
+void setUp()
+{
+  fakeClockReset();
+  runsA      = 0;
+  runsB      = 0;
+  taskBRunUs = 0;
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- a period is counted from the deadline, not from when the task got to run
+static void testPeriodicKeepsCadence()
+{
+  TaskScheduler scheduler;
+  scheduler.addPeriodic("a", taskA, 100);
+
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+
+  fakeClockAdvanceMs(99);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+
+  //-- 30 ms late: the next deadline stays at 200, not 230
+  fakeClockAdvanceMs(31);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(2, runsA);
+  TEST_ASSERT_EQUAL_UINT32(70, scheduler.msUntilNext());
+
+}   //   testPeriodicKeepsCadence()
+
+//-- more than a period behind: run once and re-base instead of bursting
+static void testLateTaskIsRebased()
+{
+  TaskScheduler scheduler;
+  scheduler.addPeriodic("a", taskA, 100, 100);
+
+  fakeClockAdvanceMs(350);
+  scheduler.run();
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(100, scheduler.msUntilNext());
+
+}   //   testLateTaskIsRebased()
+
+static void testOneShotRunsOnce()
+{
+  TaskScheduler scheduler;
+  int taskId = scheduler.addOneShot("b", taskB, 50);
+
+  fakeClockAdvanceMs(49);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(0, runsB);
+
+  fakeClockAdvanceMs(1);
+  scheduler.run();
+  fakeClockAdvanceMs(1000);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsB);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, scheduler.msUntilNext());
+
+  //-- trigger() re-arms the finished one-shot
+  scheduler.trigger(taskId, 10);
+  fakeClockAdvanceMs(10);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(2, runsB);
+
+}   //   testOneShotRunsOnce()
+
+static void testDeadlinesSurviveMillisWrap()
+{
+  fakeClockSetMs(0xFFFFFFF0UL);
+
+  TaskScheduler scheduler;
+  scheduler.addPeriodic("a", taskA, 32, 32);
+
+  fakeClockAdvanceMs(31);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(0, runsA);
+  TEST_ASSERT_EQUAL_UINT32(1, scheduler.msUntilNext());
+
+  fakeClockAdvanceMs(1);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(32, scheduler.msUntilNext());
+
+}   //   testDeadlinesSurviveMillisWrap()
+
+static void testSetPeriodAndCancel()
+{
+  TaskScheduler scheduler;
+  int taskIdA = scheduler.addPeriodic("a", taskA, 100, 100);
+  int taskIdB = scheduler.addPeriodic("b", taskB, 100, 100);
+
+  scheduler.setPeriod(taskIdA, 500);
+  scheduler.cancel(taskIdB);
+  TEST_ASSERT_EQUAL_UINT32(500, scheduler.msUntilNext());
+
+  fakeClockAdvanceMs(500);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(0, runsB);
+
+  //-- unknown ids are ignored
+  scheduler.cancel(-1);
+  scheduler.trigger(SCHEDULER_MAX_TASKS);
+  scheduler.setPeriod(7, 0);
+
+}   //   testSetPeriodAndCancel()
+
+//-- one task's deadline, whatever the other tasks are due (deep sleep sleeps to the toggle)
+static void testMsUntilTaskIgnoresOtherTasks()
+{
+  TaskScheduler scheduler;
+  int toggleId = scheduler.addPeriodic("toggle", taskA, 2000, 2000);
+  int heapId   = scheduler.addPeriodic("heap", taskB, 1000, 1000);
+
+  TEST_ASSERT_EQUAL_UINT32(1000, scheduler.msUntilNext());
+  TEST_ASSERT_EQUAL_UINT32(2000, scheduler.msUntilTask(toggleId));
+
+  fakeClockAdvanceMs(2500);
+  TEST_ASSERT_EQUAL_UINT32(0, scheduler.msUntilTask(toggleId));
+
+  scheduler.cancel(heapId);
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, scheduler.msUntilTask(heapId));
+  TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, scheduler.msUntilTask(-1));
+
+}   //   testMsUntilTaskIgnoresOtherTasks()
+
+static void testFullTableIsRejected()
+{
+  TaskScheduler scheduler;
+
+  for (int slot = 0; slot < SCHEDULER_MAX_TASKS; slot++)
+  {
+    TEST_ASSERT_EQUAL_INT(slot, scheduler.addPeriodic("a", taskA, 10));
+  }
+  TEST_ASSERT_EQUAL_INT(-1, scheduler.addPeriodic("a", taskA, 10));
+  TEST_ASSERT_EQUAL_INT(-1, scheduler.addOneShot("null", nullptr, 10));
+
+}   //   testFullTableIsRejected()
+
+//-- idle() must sleep exactly up to the deadline, capped at maxIdleMs
+static void testIdleSleepsUntilDeadline()
+{
+  TaskScheduler scheduler;
+  scheduler.addPeriodic("a", taskA, 40, 40);
+
+  scheduler.idle();
+  TEST_ASSERT_EQUAL_UINT32(40, fakeClockDelayedMs());
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+
+  scheduler.idle(15);
+  TEST_ASSERT_EQUAL_UINT32(55, fakeClockDelayedMs());
+
+  //-- overdue: no sleep at all
+  fakeClockAdvanceMs(100);
+  scheduler.idle();
+  TEST_ASSERT_EQUAL_UINT32(55, fakeClockDelayedMs());
+
+}   //   testIdleSleepsUntilDeadline()
+
+//-- lateness is measured in microseconds against the deadline
+static void testLatenessIsMeasured()
+{
+  TaskScheduler scheduler;
+  int taskId = scheduler.addPeriodic("a", taskA, 100, 100);
+  scheduler.setLatencyBound(taskId, 500);
+
+  fakeClockAdvanceUs(100300);
+  scheduler.run();
+  fakeClockAdvanceUs(100500);
+  scheduler.run();
+
+  schedulerTiming timing;
+  TEST_ASSERT_TRUE(scheduler.timing(taskId, timing));
+  TEST_ASSERT_EQUAL_UINT32(2, timing.runs);
+  TEST_ASSERT_EQUAL_UINT32(800, timing.lastLateUs);
+  TEST_ASSERT_EQUAL_UINT32(800, timing.maxLateUs);
+  TEST_ASSERT_EQUAL_UINT32(1100, (uint32_t)timing.totalLateUs);
+  TEST_ASSERT_EQUAL_UINT32(1, timing.overBound);
+  TEST_ASSERT_FALSE(scheduler.timing(SCHEDULER_MAX_TASKS, timing));
+
+  scheduler.resetTiming();
+  scheduler.timing(taskId, timing);
+  TEST_ASSERT_EQUAL_UINT32(0, timing.runs);
+
+}   //   testLatenessIsMeasured()
+
+//-- a task whose longest run does not fit in front of a bounded deadline waits for it
+static void testBackgroundWaitsForBoundedTask()
+{
+  TaskScheduler scheduler;
+  int boundedId    = scheduler.addPeriodic("a", taskA, 100, 100);
+  int backgroundId = scheduler.addPeriodic("b", taskB, 7);
+  scheduler.setLatencyBound(boundedId, 1000);
+  taskBRunUs = 5000;
+
+  //-- 5 ms runs at 0, 7, ... 91 ms; the one due at 98 ms would end too late
+  while (millis() < 98)
+  {
+    scheduler.run();
+    scheduler.idle();
+  }
+  uint32_t runsBefore = runsB;
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(runsBefore, runsB);
+  TEST_ASSERT_EQUAL_UINT32(2, scheduler.msUntilNext());
+
+  while (runsA == 0)
+  {
+    scheduler.idle();
+    scheduler.run();
+  }
+  TEST_ASSERT_EQUAL_UINT32(runsBefore + 1, runsB);
+
+  schedulerTiming timing;
+  scheduler.timing(boundedId, timing);
+  TEST_ASSERT_EQUAL_UINT32(0, timing.overBound);
+  TEST_ASSERT_EQUAL_UINT32(0, timing.maxLateUs);
+  scheduler.timing(backgroundId, timing);
+  TEST_ASSERT_EQUAL_UINT32(1, timing.deferred);
+  TEST_ASSERT_EQUAL_UINT32(5000, timing.maxRunUs);
+
+}   //   testBackgroundWaitsForBoundedTask()
+
+//-- a run longer than the whole period never fits, it goes right after a bounded run
+static void testOversizedTaskIsNotStarved()
+{
+  TaskScheduler scheduler;
+  int boundedId = scheduler.addPeriodic("a", taskA, 100, 100);
+  scheduler.addPeriodic("b", taskB, 50);
+  scheduler.setLatencyBound(boundedId, 1000);
+  taskBRunUs = 150000;
+
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsB);
+
+  //-- held back behind the bounded run at 200 ms ...
+  fakeClockSetMs(200);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(1, runsB);
+
+  //-- ... and run after the next one
+  fakeClockSetMs(300);
+  scheduler.run();
+  TEST_ASSERT_EQUAL_UINT32(2, runsA);
+  TEST_ASSERT_EQUAL_UINT32(2, runsB);
+
+}   //   testOversizedTaskIsNotStarved()
+
+//-- idle() wakes up early and busy-waits the rest, the bounded task runs on time
+static void testIdleIsExactForBoundedTask()
+{
+  TaskScheduler scheduler;
+  int taskId = scheduler.addPeriodic("a", taskA, 40, 40);
+  scheduler.setLatencyBound(taskId, 100);
+  fakeClockAdvanceUs(300);
+
+  scheduler.idle();
+  TEST_ASSERT_EQUAL_UINT32(38, fakeClockDelayedMs());
+  scheduler.idle();
+  TEST_ASSERT_EQUAL_UINT32(40000, micros());
+  scheduler.run();
+
+  schedulerTiming timing;
+  scheduler.timing(taskId, timing);
+  TEST_ASSERT_EQUAL_UINT32(1, runsA);
+  TEST_ASSERT_EQUAL_UINT32(0, timing.lastLateUs);
+
+}   //   testIdleIsExactForBoundedTask()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testPeriodicKeepsCadence);
+  RUN_TEST(testLateTaskIsRebased);
+  RUN_TEST(testOneShotRunsOnce);
+  RUN_TEST(testDeadlinesSurviveMillisWrap);
+  RUN_TEST(testSetPeriodAndCancel);
+  RUN_TEST(testMsUntilTaskIgnoresOtherTasks);
+  RUN_TEST(testFullTableIsRejected);
+  RUN_TEST(testIdleSleepsUntilDeadline);
+  RUN_TEST(testLatenessIsMeasured);
+  RUN_TEST(testBackgroundWaitsForBoundedTask);
+  RUN_TEST(testOversizedTaskIsNotStarved);
+  RUN_TEST(testIdleIsExactForBoundedTask);
+  return UNITY_END();
+
+}   //   main()
@@ -0,0 +1,108 @@
+//--- Host tests for the serial command console (serialConsole.cpp), run with "pio test -e native"
+
+#include <Arduino.h>
+#include <unity.h>
+
+#include <string>
+
+#include "serialConsole.h"
+
+//-- what otaUpload.py sends: "ota <bytes> <sha256 as 64 hex digits>"
+static const char *otaLine =
+  "ota 1310720 "
+  "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08\n";
+
+static int         handlerRuns = 0;
+static int         handlerArgc = 0;
+static std::string handlerArgs[CONSOLE_MAX_ARGS];
+
+static void recordCommand(int argc, char *argv[])
+{
+  handlerRuns++;
+  handlerArgc = argc;
+  for (int index = 0; index < argc; index++)
+  {
+    handlerArgs[index] = argv[index];
+  }
+
+}   //   recordCommand()
+
+//-- poll() takes CONSOLE_MAX_BYTES_PER_POLL per call, keep calling until the line is complete
+static bool pollUntilLine(SerialConsole &console)
+{
+  for (int polls = 0; polls < 16; polls++)
+  {
+    if (console.poll())
+    {
+      return true;
+    }
+  }
+  return false;
+
+}   //   pollUntilLine()
+
+void setUp()
+{
+  handlerRuns = 0;
+  handlerArgc = 0;
+  while (Serial.available() > 0)
+  {
+    Serial.read();
+  }
+  Serial.clearOutput();
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+static void testFullLengthOtaLineIsDispatched()
+{
+  SerialConsole console;
+  TEST_ASSERT_TRUE(console.addCommand("ota", recordCommand, "image"));
+
+  TEST_ASSERT_TRUE(strlen(otaLine) - 1 < CONSOLE_LINE_MAX);
+  Serial.feed(otaLine);
+  TEST_ASSERT_TRUE(pollUntilLine(console));
+  TEST_ASSERT_TRUE(console.dispatch());
+
+  TEST_ASSERT_EQUAL_INT(1, handlerRuns);
+  TEST_ASSERT_EQUAL_INT(3, handlerArgc);
+  TEST_ASSERT_EQUAL_STRING("1310720", handlerArgs[1].c_str());
+  TEST_ASSERT_EQUAL_UINT32(64, handlerArgs[2].size());
+
+}   //   testFullLengthOtaLineIsDispatched()
+
+static void testOverlongLineIsDropped()
+{
+  SerialConsole console;
+  console.addCommand("ota", recordCommand, "image");
+
+  std::string tooLong = "ota ";
+  tooLong.append(CONSOLE_LINE_MAX, 'a');
+  tooLong += "\n";
+  Serial.feed(tooLong.c_str());
+  TEST_ASSERT_FALSE(pollUntilLine(console));
+  TEST_ASSERT_FALSE(console.dispatch());
+
+  //-- the next line is read normally again
+  Serial.feed("ota 1 2\n");
+  TEST_ASSERT_TRUE(pollUntilLine(console));
+  console.dispatch();
+  TEST_ASSERT_EQUAL_INT(1, handlerRuns);
+  TEST_ASSERT_EQUAL_INT(3, handlerArgc);
+
+}   //   testOverlongLineIsDropped()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testFullLengthOtaLineIsDispatched);
+  RUN_TEST(testOverlongLineIsDropped);
+  return UNITY_END();
+
+}   //   main()
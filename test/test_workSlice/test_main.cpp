@@ -0,0 +1,85 @@
+//--- Host tests for the time-sliced long operations (workSlice.cpp) on the fake clock,
+//--- run with "pio test -e native"
+
+#include <Arduino.h>
+#include <unity.h>
+#include <fakeClock.h>
+
+#include "workSlice.h"
+
+void setUp()
+{
+  fakeClockReset();
+
+}   //   setUp()
+
+void tearDown()
+{
+}   //   tearDown()
+
+//-- pace() only ends a slice once its budget is used up
+static void testPaceYieldsAfterBudget()
+{
+  WorkSlice slice(1000);
+  slice.begin();
+
+  fakeClockAdvanceUs(999);
+  TEST_ASSERT_FALSE(slice.pace());
+  TEST_ASSERT_EQUAL_UINT32(0, slice.sliceCount());
+
+  fakeClockAdvanceUs(1);
+  TEST_ASSERT_TRUE(slice.pace());
+  TEST_ASSERT_EQUAL_UINT32(1, slice.sliceCount());
+
+  //-- the next slice starts after the yield with a full budget
+  fakeClockAdvanceUs(500);
+  TEST_ASSERT_FALSE(slice.pace());
+
+}   //   testPaceYieldsAfterBudget()
+
+//-- the longest slice is kept, endSlice() closes the last one
+static void testLongestSliceIsKept()
+{
+  WorkSlice slice(1000);
+  slice.begin();
+
+  fakeClockAdvanceUs(3000);
+  TEST_ASSERT_TRUE(slice.pace());
+  fakeClockAdvanceUs(1200);
+  TEST_ASSERT_TRUE(slice.pace());
+  fakeClockAdvanceUs(200);
+  slice.endSlice();
+
+  TEST_ASSERT_EQUAL_UINT32(3, slice.sliceCount());
+  TEST_ASSERT_EQUAL_UINT32(3000, slice.maxSliceUs());
+
+}   //   testLongestSliceIsKept()
+
+//-- progress lines at most every WORK_PROGRESS_MS
+static void testProgressIsRateLimited()
+{
+  WorkSlice slice;
+  slice.begin();
+
+  TEST_ASSERT_FALSE(slice.progressDue());
+  fakeClockAdvanceMs(WORK_PROGRESS_MS - 1);
+  TEST_ASSERT_FALSE(slice.progressDue());
+  fakeClockAdvanceMs(1);
+  TEST_ASSERT_TRUE(slice.progressDue());
+  TEST_ASSERT_FALSE(slice.progressDue());
+  TEST_ASSERT_EQUAL_UINT32(WORK_PROGRESS_MS, slice.elapsedMs());
+
+}   //   testProgressIsRateLimited()
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+
+  UNITY_BEGIN();
+  RUN_TEST(testPaceYieldsAfterBudget);
+  RUN_TEST(testLongestSliceIsKept);
+  RUN_TEST(testProgressIsRateLimited);
+  return UNITY_END();
+
+}   //   main()